@@ -0,0 +1,432 @@
+//  boost/filesystem/basic_path.hpp  ---------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//--------------------------------------------------------------------------------------//
+
+#ifndef BOOST_FILESYSTEM_BASIC_PATH_HPP
+#define BOOST_FILESYSTEM_BASIC_PATH_HPP
+
+#include <boost/config.hpp>
+
+# if defined( BOOST_NO_STD_WSTRING )
+#   error Configuration not supported: Boost.Filesystem V3 and later requires std::wstring support
+# endif
+
+#include <boost/filesystem/config.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/system/error_code.hpp>
+#include <boost/utility/enable_if.hpp>
+#include <boost/type_traits/decay.hpp>
+#include <string>
+#include <memory>
+#include <cstddef>
+# if defined(__has_include) && !defined(BOOST_NO_CXX17_HDR_STRING_VIEW)
+#   if __has_include(<memory_resource>)
+#     include <memory_resource>
+#   endif
+# endif
+
+#include <boost/config/abi_prefix.hpp> // must be the last #include
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//                                  class basic_path                                    //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+//  basic_path<Allocator> holds a native format path string that obtains its storage
+//  from Allocator, so large temporary sets of paths can be built in an arena and
+//  released all at once. Source arguments are accepted and converted exactly as by
+//  class path; native format sources are appended directly, others are converted
+//  through a temporary string.
+//
+//  Appends behave as for class path. For decomposition and iteration, use to_path().
+//
+//  The status query functions accept a basic_path without copying it into a path. Other
+//  operational functions accept a basic_path by converting it to path.
+
+namespace boost
+{
+namespace filesystem
+{
+  namespace detail
+  {
+    inline bool is_directory_separator(path::value_type c)
+    {
+      return c == '/'
+#     ifdef BOOST_WINDOWS_API
+        || c == path::preferred_separator
+#     endif
+        ;
+    }
+  }
+
+  template <class Allocator>
+  class basic_path
+  {
+  public:
+    typedef path::value_type                        value_type;
+    typedef std::char_traits<value_type>            traits_type;
+    typedef Allocator                               allocator_type;
+    typedef std::basic_string<value_type, traits_type, Allocator>
+                                                    string_type;
+    typedef path::codecvt_type                      codecvt_type;
+
+    //  -----  constructors  -----
+
+    basic_path() {}
+    explicit basic_path(const allocator_type& a) : m_pathname(a) {}
+    basic_path(const basic_path& p) : m_pathname(p.m_pathname) {}
+    basic_path(const basic_path& p, const allocator_type& a)
+      : m_pathname(p.m_pathname.data(), p.m_pathname.size(), a) {}
+#   ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    basic_path(basic_path&& p) BOOST_NOEXCEPT : m_pathname(std::move(p.m_pathname)) {}
+#   endif
+
+    basic_path(const path& p, const allocator_type& a = allocator_type())
+      : m_pathname(p.native().data(), p.native().size(), a) {}
+
+    basic_path(const value_type* s, const allocator_type& a = allocator_type())
+      : m_pathname(s, a) {}
+
+    template <class A>
+    basic_path(const std::basic_string<value_type, traits_type, A>& s,
+      const allocator_type& a = allocator_type())
+      : m_pathname(s.data(), s.size(), a) {}
+
+    template <class Source>
+    basic_path(Source const& source, const allocator_type& a = allocator_type(),
+      typename boost::enable_if<path_traits::is_pathable<
+        typename boost::decay<Source>::type> >::type* =0)
+      : m_pathname(a)
+    {
+      m_concat(source, path::codecvt());
+    }
+
+    template <class Source>
+    basic_path(Source const& source, const codecvt_type& cvt,
+      const allocator_type& a = allocator_type())
+      : m_pathname(a)
+    {
+      m_concat(source, cvt);
+    }
+
+    //  -----  assignments  -----
+
+    basic_path& operator=(const basic_path& p)
+    {
+      m_pathname = p.m_pathname;
+      return *this;
+    }
+
+#   ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    basic_path& operator=(basic_path&& p)
+    {
+      m_pathname = std::move(p.m_pathname);
+      return *this;
+    }
+#   endif
+
+    basic_path& operator=(const path& p)
+    {
+      m_pathname.assign(p.native().data(), p.native().size());
+      return *this;
+    }
+
+    template <class Source>
+      typename boost::enable_if<path_traits::is_pathable<
+        typename boost::decay<Source>::type>, basic_path&>::type
+    operator=(Source const& source)
+    {
+      return assign(source, path::codecvt());
+    }
+
+    template <class Source>
+    basic_path& assign(Source const& source, const codecvt_type& cvt)
+    {
+      path::string_type tmp;
+      const value_type* s;
+      std::size_t size;
+      m_native(source, cvt, tmp, s, size);
+      m_pathname.assign(s, size);
+      return *this;
+    }
+
+    //  -----  concatenation  -----
+
+    basic_path& operator+=(const path& p)    { return concat(p, path::codecvt()); }
+    basic_path& operator+=(value_type c)     { m_pathname += c; return *this; }
+
+    template <class Source>
+      typename boost::enable_if<path_traits::is_pathable<
+        typename boost::decay<Source>::type>, basic_path&>::type
+    operator+=(Source const& source)
+    {
+      return concat(source, path::codecvt());
+    }
+
+    template <class Source>
+    basic_path& concat(Source const& source, const codecvt_type& cvt)
+    {
+      m_concat(source, cvt);
+      return *this;
+    }
+
+    //  -----  appends  -----
+
+    //  if a separator is added, it is the preferred separator for the platform;
+    //  slash for POSIX, backslash for Windows
+
+    basic_path& operator/=(const path& p)    { return append(p, path::codecvt()); }
+
+    template <class Source>
+      typename boost::enable_if<path_traits::is_pathable<
+        typename boost::decay<Source>::type>, basic_path&>::type
+    operator/=(Source const& source)
+    {
+      return append(source, path::codecvt());
+    }
+
+    template <class Source>
+    basic_path& append(Source const& source, const codecvt_type& cvt)
+    {
+      path::string_type tmp;
+      const value_type* s;
+      std::size_t size;
+      m_native(source, cvt, tmp, s, size);
+      if (size == 0)
+        return *this;
+      if (s >= m_pathname.data()
+        && s < m_pathname.data() + m_pathname.size())  // overlapping source
+      {
+        tmp.assign(s, size);
+        s = tmp.data();
+      }
+      if (!detail::is_directory_separator(*s)
+        && !m_pathname.empty()
+#       ifdef BOOST_WINDOWS_API
+        && m_pathname[m_pathname.size()-1] != L':'
+#       endif
+        && !detail::is_directory_separator(m_pathname[m_pathname.size()-1]))
+        m_pathname += path::preferred_separator;
+      m_pathname.append(s, size);
+      return *this;
+    }
+
+    //  -----  modifiers  -----
+
+    void clear()                      { m_pathname.clear(); }
+    void reserve(std::size_t n)       { m_pathname.reserve(n); }
+    void swap(basic_path& rhs)        { m_pathname.swap(rhs.m_pathname); }
+
+    //  -----  observers  -----
+
+    const string_type&  native() const BOOST_NOEXCEPT  { return m_pathname; }
+    const value_type*   c_str() const BOOST_NOEXCEPT   { return m_pathname.c_str(); }
+    bool                empty() const BOOST_NOEXCEPT   { return m_pathname.empty(); }
+    allocator_type      get_allocator() const          { return m_pathname.get_allocator(); }
+
+    //  copy into a default allocated path, e.g. for decomposition or iteration
+    path to_path() const
+    {
+      return path(path::string_type(m_pathname.data(),
+        m_pathname.data() + m_pathname.size()));
+    }
+
+  private:
+    string_type  m_pathname;
+
+    //  m_native: sets [s, s+size) to the native format of source, converting into tmp
+    //  only if source is not already in native format
+    template <class Source>
+    static void m_native(const Source& source, const codecvt_type& cvt,
+      path::string_type& tmp, const value_type*& s, std::size_t& size)
+    {
+      path_traits::dispatch(source, tmp, cvt);
+      s = tmp.data();
+      size = tmp.size();
+    }
+    static void m_native(const value_type* source, const codecvt_type&,
+      path::string_type&, const value_type*& s, std::size_t& size)
+    {
+      s = source;
+      size = traits_type::length(source);
+    }
+    template <class A>
+    static void m_native(const std::basic_string<value_type, traits_type, A>& source,
+      const codecvt_type&, path::string_type&, const value_type*& s, std::size_t& size)
+    {
+      s = source.data();
+      size = source.size();
+    }
+    template <class A>
+    static void m_native(const basic_path<A>& source, const codecvt_type&,
+      path::string_type&, const value_type*& s, std::size_t& size)
+    {
+      s = source.native().data();
+      size = source.native().size();
+    }
+    static void m_native(const path& source, const codecvt_type&,
+      path::string_type&, const value_type*& s, std::size_t& size)
+    {
+      s = source.native().data();
+      size = source.native().size();
+    }
+
+    template <class Source>
+    void m_concat(const Source& source, const codecvt_type& cvt)
+    {
+      path::string_type tmp;
+      const value_type* s;
+      std::size_t size;
+      m_native(source, cvt, tmp, s, size);
+      m_pathname.append(s, size);
+    }
+  };
+
+  //------------------------------------------------------------------------------------//
+  //                              non-member functions                                  //
+  //------------------------------------------------------------------------------------//
+
+  //  equality is native string identity (Windows: slash and backslash are equal), as
+  //  for path_equal_to
+
+  template <class Allocator> inline
+  bool operator==(const basic_path<Allocator>& lhs, const basic_path<Allocator>& rhs)
+  {
+    return detail::native_equal(lhs.c_str(), lhs.native().size(),
+      rhs.c_str(), rhs.native().size());
+  }
+
+  template <class Allocator> inline
+  bool operator!=(const basic_path<Allocator>& lhs, const basic_path<Allocator>& rhs)
+    { return !(lhs == rhs); }
+
+  template <class Allocator> inline
+  std::size_t hash_value(const basic_path<Allocator>& x)
+    { return detail::hash_native(x.c_str(), x.native().size()); }
+
+  template <class Allocator> inline
+  void swap(basic_path<Allocator>& lhs, basic_path<Allocator>& rhs) { lhs.swap(rhs); }
+
+  //  operator/ results use the left-hand argument's allocator and are built with a
+  //  single allocation
+
+  template <class Allocator> inline
+  basic_path<Allocator> operator/(const basic_path<Allocator>& lhs,
+    const basic_path<Allocator>& rhs)
+  {
+    basic_path<Allocator> tmp(lhs.get_allocator());
+    tmp.reserve(lhs.native().size() + 1 + rhs.native().size());
+    tmp += lhs;
+    tmp /= rhs;
+    return tmp;
+  }
+
+  template <class Allocator> inline
+  basic_path<Allocator> operator/(const basic_path<Allocator>& lhs, const path& rhs)
+  {
+    basic_path<Allocator> tmp(lhs.get_allocator());
+    tmp.reserve(lhs.native().size() + 1 + rhs.native().size());
+    tmp += lhs;
+    tmp /= rhs;
+    return tmp;
+  }
+
+  template <class Allocator, class Source> inline
+    typename boost::enable_if<path_traits::is_pathable<
+      typename boost::decay<Source>::type>, basic_path<Allocator> >::type
+  operator/(const basic_path<Allocator>& lhs, const Source& rhs)
+  {
+    basic_path<Allocator> tmp(lhs, lhs.get_allocator());
+    tmp /= rhs;
+    return tmp;
+  }
+
+  //  status query functions  ----------------------------------------------------------//
+
+  template <class Allocator> inline
+  file_status status(const basic_path<Allocator>& p)
+                                       {return detail::status(p.c_str());}
+  template <class Allocator> inline
+  file_status status(const basic_path<Allocator>& p, system::error_code& ec)
+                                       {return detail::status(p.c_str(), &ec);}
+  template <class Allocator> inline
+  file_status symlink_status(const basic_path<Allocator>& p)
+                                       {return detail::symlink_status(p.c_str());}
+  template <class Allocator> inline
+  file_status symlink_status(const basic_path<Allocator>& p, system::error_code& ec)
+                                       {return detail::symlink_status(p.c_str(), &ec);}
+  template <class Allocator> inline
+  bool exists(const basic_path<Allocator>& p)
+                                       {return exists(detail::status(p.c_str()));}
+  template <class Allocator> inline
+  bool exists(const basic_path<Allocator>& p, system::error_code& ec)
+                                       {return exists(detail::status(p.c_str(), &ec));}
+  template <class Allocator> inline
+  bool is_directory(const basic_path<Allocator>& p)
+                                       {return is_directory(detail::status(p.c_str()));}
+  template <class Allocator> inline
+  bool is_directory(const basic_path<Allocator>& p, system::error_code& ec)
+                               {return is_directory(detail::status(p.c_str(), &ec));}
+  template <class Allocator> inline
+  bool is_regular_file(const basic_path<Allocator>& p)
+                               {return is_regular_file(detail::status(p.c_str()));}
+  template <class Allocator> inline
+  bool is_regular_file(const basic_path<Allocator>& p, system::error_code& ec)
+                               {return is_regular_file(detail::status(p.c_str(), &ec));}
+  template <class Allocator> inline
+  bool is_other(const basic_path<Allocator>& p)
+                                       {return is_other(detail::status(p.c_str()));}
+  template <class Allocator> inline
+  bool is_other(const basic_path<Allocator>& p, system::error_code& ec)
+                                       {return is_other(detail::status(p.c_str(), &ec));}
+  template <class Allocator> inline
+  bool is_symlink(const basic_path<Allocator>& p)
+                               {return is_symlink(detail::symlink_status(p.c_str()));}
+  template <class Allocator> inline
+  bool is_symlink(const basic_path<Allocator>& p, system::error_code& ec)
+                               {return is_symlink(detail::symlink_status(p.c_str(), &ec));}
+  template <class Allocator> inline
+  boost::uintmax_t file_size(const basic_path<Allocator>& p)
+                                       {return detail::file_size(p.c_str());}
+  template <class Allocator> inline
+  boost::uintmax_t file_size(const basic_path<Allocator>& p, system::error_code& ec)
+                                       {return detail::file_size(p.c_str(), &ec);}
+  template <class Allocator> inline
+  file_time_type last_write_time(const basic_path<Allocator>& p)
+#ifdef BOOST_FILESYSTEM_USE_TIME_T
+    {return detail::last_write_time(p.c_str());}
+#else
+    {return detail::last_write_time_point(p.c_str());}
+#endif
+  template <class Allocator> inline
+  file_time_type last_write_time(const basic_path<Allocator>& p, system::error_code& ec)
+#ifdef BOOST_FILESYSTEM_USE_TIME_T
+    {return detail::last_write_time(p.c_str(), &ec);}
+#else
+    {return detail::last_write_time_point(p.c_str(), &ec);}
+#endif
+
+  //  pmr::path  -----------------------------------------------------------------------//
+
+# ifdef __cpp_lib_memory_resource
+  namespace pmr
+  {
+    typedef basic_path<std::pmr::polymorphic_allocator<path::value_type> > path;
+  }
+# endif
+
+}  // namespace filesystem
+}  // namespace boost
+
+#include <boost/config/abi_suffix.hpp> // pops abi_prefix.hpp pragmas
+
+#endif  // BOOST_FILESYSTEM_BASIC_PATH_HPP
@@ -0,0 +1,250 @@
+//  boost/filesystem/cached_path.hpp  --------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//--------------------------------------------------------------------------------------//
+
+#ifndef BOOST_FILESYSTEM_CACHED_PATH_HPP
+#define BOOST_FILESYSTEM_CACHED_PATH_HPP
+
+#include <boost/config.hpp>
+
+# if defined( BOOST_NO_STD_WSTRING )
+#   error Configuration not supported: Boost.Filesystem V3 and later requires std::wstring support
+# endif
+
+#include <boost/filesystem/config.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/atomic.hpp>
+#include <boost/utility/enable_if.hpp>
+#include <string>
+
+#include <boost/config/abi_prefix.hpp> // must be the last #include
+
+namespace boost
+{
+namespace filesystem
+{
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//                                 class cached_path                                    //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+//  A cached_path holds a path, and converts it to each other encoding at most once,
+//  on first request; the conversions are returned by reference. wstring() is cached on
+//  POSIX and string() on Windows, where the other is the native format. u16string()
+//  and u32string() are cached on both. Conversions use path::codecvt() as of the first
+//  request; the forms taking a codecvt argument are not cached.
+//
+//  Every modifier discards the cached conversions. Concurrent calls of const member
+//  functions are safe; as for path, a modifier needs exclusive access.
+
+  namespace detail
+  {
+    //  A string computed on first request. If threads race to compute it, one result is
+    //  kept and the others discarded.
+    template <class String>
+    class lazy_string
+    {
+    public:
+      lazy_string() : m_value(0) {}
+      ~lazy_string() { reset(); }
+
+      void reset()  // requires exclusive access
+      {
+        delete m_value.exchange(0, boost::memory_order_acquire);
+      }
+
+      const String& get(const path& p, String (path::*convert)() const) const
+      {
+        String* value = m_value.load(boost::memory_order_acquire);
+        if (value)
+          return *value;
+
+        String* fresh = new String((p.*convert)());
+        String* expected = 0;
+        if (m_value.compare_exchange_strong(expected, fresh,
+              boost::memory_order_acq_rel, boost::memory_order_acquire))
+          return *fresh;
+        delete fresh;
+        return *expected;
+      }
+
+    private:
+      mutable boost::atomic<String*> m_value;
+
+      lazy_string(const lazy_string&);             // not copyable
+      lazy_string& operator=(const lazy_string&);
+    };
+  }
+
+  class cached_path
+  {
+  public:
+    typedef path::value_type   value_type;
+    typedef path::string_type  string_type;
+
+    //  -----  constructors  -----
+
+    cached_path() {}
+    cached_path(const path& p) : m_path(p) {}
+    cached_path(const cached_path& p) : m_path(p.m_path) {}
+
+    template <class Source>
+    cached_path(Source const& source,
+      typename boost::enable_if<path_traits::is_pathable<
+        typename boost::decay<Source>::type> >::type* =0)
+      : m_path(source) {}
+
+    cached_path(const value_type* s) : m_path(s) {}
+
+    //  -----  assignments  -----
+
+    cached_path& operator=(const cached_path& p)
+    {
+      if (this != &p)
+        assign(p.m_path);
+      return *this;
+    }
+
+    cached_path& operator=(const path& p)  { return assign(p); }
+
+    cached_path& assign(const path& p)
+    {
+      m_invalidate();
+      m_path = p;
+      return *this;
+    }
+
+    //  -----  modifiers  -----
+
+    cached_path& operator/=(const path& p)
+    {
+      m_invalidate();
+      m_path /= p;
+      return *this;
+    }
+
+    cached_path& operator+=(const path& p)
+    {
+      m_invalidate();
+      m_path += p;
+      return *this;
+    }
+
+    void clear()
+    {
+      m_invalidate();
+      m_path.clear();
+    }
+
+    cached_path& make_preferred()
+    {
+      m_invalidate();
+      m_path.make_preferred();
+      return *this;
+    }
+
+    cached_path& remove_filename()
+    {
+      m_invalidate();
+      m_path.remove_filename();
+      return *this;
+    }
+
+    cached_path& replace_extension(const path& new_extension = path())
+    {
+      m_invalidate();
+      m_path.replace_extension(new_extension);
+      return *this;
+    }
+
+    void swap(cached_path& rhs)
+    {
+      m_invalidate();
+      rhs.m_invalidate();
+      m_path.swap(rhs.m_path);
+    }
+
+    //  -----  observers  -----
+
+    const boost::filesystem::path& get() const  { return m_path; }
+    operator const boost::filesystem::path&() const { return m_path; }
+
+    const string_type&  native() const  { return m_path.native(); }
+    const value_type*   c_str() const   { return m_path.c_str(); }
+    bool                empty() const   { return m_path.empty(); }
+
+#   ifdef BOOST_WINDOWS_API
+    const std::string&  string() const
+    {
+      return m_string.get(m_path,
+        static_cast<std::string (path::*)() const>(&path::string));
+    }
+    const std::wstring& wstring() const  { return m_path.native(); }
+#   else
+    const std::string&  string() const   { return m_path.native(); }
+    const std::wstring& wstring() const
+    {
+      return m_wstring.get(m_path,
+        static_cast<std::wstring (path::*)() const>(&path::wstring));
+    }
+#   endif
+
+    std::string   string(const path::codecvt_type& cvt) const
+                                              { return m_path.string(cvt); }
+    std::wstring  wstring(const path::codecvt_type& cvt) const
+                                              { return m_path.wstring(cvt); }
+
+    const boost::u16string& u16string() const
+                                  { return m_u16string.get(m_path, &path::u16string); }
+    const boost::u32string& u32string() const
+                                  { return m_u32string.get(m_path, &path::u32string); }
+
+  private:
+    boost::filesystem::path m_path;
+
+#   ifdef BOOST_WINDOWS_API
+    detail::lazy_string<std::string>       m_string;
+#   else
+    detail::lazy_string<std::wstring>      m_wstring;
+#   endif
+    detail::lazy_string<boost::u16string>  m_u16string;
+    detail::lazy_string<boost::u32string>  m_u32string;
+
+    void m_invalidate()
+    {
+#     ifdef BOOST_WINDOWS_API
+      m_string.reset();
+#     else
+      m_wstring.reset();
+#     endif
+      m_u16string.reset();
+      m_u32string.reset();
+    }
+  };
+
+  inline bool operator==(const cached_path& lhs, const cached_path& rhs)
+                                              { return lhs.get() == rhs.get(); }
+  inline bool operator!=(const cached_path& lhs, const cached_path& rhs)
+                                              { return lhs.get() != rhs.get(); }
+  inline bool operator<(const cached_path& lhs, const cached_path& rhs)
+                                              { return lhs.get() < rhs.get(); }
+
+  inline void swap(cached_path& lhs, cached_path& rhs)  { lhs.swap(rhs); }
+
+  inline std::size_t hash_value(const cached_path& p)  { return hash_value(p.get()); }
+
+}  // namespace filesystem
+}  // namespace boost
+
+#include <boost/config/abi_suffix.hpp> // pops abi_prefix.hpp pragmas
+
+#endif  // BOOST_FILESYSTEM_CACHED_PATH_HPP
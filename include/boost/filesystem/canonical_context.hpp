@@ -0,0 +1,167 @@
+//  boost/filesystem/canonical_context.hpp  --------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//--------------------------------------------------------------------------------------//
+
+#ifndef BOOST_FILESYSTEM_CANONICAL_CONTEXT_HPP
+#define BOOST_FILESYSTEM_CANONICAL_CONTEXT_HPP
+
+#include <boost/config.hpp>
+
+# if defined( BOOST_NO_STD_WSTRING )
+#   error Configuration not supported: Boost.Filesystem V3 and later requires std::wstring support
+# endif
+
+#include <boost/filesystem/config.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/system/error_code.hpp>
+#include <boost/chrono/system_clocks.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/cstdint.hpp>
+#include <deque>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+#include <boost/config/abi_prefix.hpp> // must be the last #include
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//                               class canonical_context                                //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+//  A canonical_context remembers, for each path prefix canonical() examines, whether
+//  the prefix is a symlink and if so its target, so canonicalizing many paths under
+//  the same directories and symlinked roots performs the symlink_status() and
+//  read_symlink() calls for each prefix once.
+//
+//  The cache holds at most max_entries prefixes; when full the oldest entry is
+//  discarded. Entries older than ttl are not used. Since the cache cannot observe
+//  changes to the file system, call clear() or invalidate() after changing symlinks
+//  or directories that may be cached, or choose a ttl that bounds staleness.
+//
+//  Errors are never cached. Not thread-safe; use one context per thread.
+
+namespace boost
+{
+namespace filesystem
+{
+  class BOOST_FILESYSTEM_DECL canonical_context
+  {
+  public:
+    typedef boost::chrono::steady_clock  clock;
+
+    explicit canonical_context(std::size_t max_entries = 4096,
+      clock::duration ttl = clock::duration::max());
+
+    //  -----  invalidation  -----
+
+    void clear();
+    void invalidate(const path& p);  // p and every cached prefix below it
+
+    //  -----  observers  -----
+
+    std::size_t      size() const         { return m_map.size(); }
+    std::size_t      max_entries() const  { return m_max_entries; }
+    clock::duration  ttl() const          { return m_ttl; }
+    boost::uintmax_t hits() const         { return m_hits; }
+    boost::uintmax_t misses() const       { return m_misses; }
+
+    //  -----  lookup  -----
+
+    //  As if by is_symlink(symlink_status(prefix, *ec)), and if so
+    //  target = read_symlink(prefix, *ec); prefix must be absolute. Throws
+    //  filesystem_error on error if ec is 0.
+    bool lookup_symlink(const path& prefix, path& target, system::error_code* ec=0);
+
+  private:
+    struct entry
+    {
+      bool               is_symlink;
+      path               target;
+      clock::time_point  inserted;   // only if there is a ttl
+      boost::uintmax_t   sequence;   // identifies the matching m_order element
+    };
+
+    typedef boost::unordered_map<path, entry, path_hash, path_equal_to> map_type;
+
+#   if defined(_MSC_VER)
+#     pragma warning(push) // Save warning settings
+#     pragma warning(disable : 4251) // disable warning: class 'std::vector<_Ty,_Ax>'
+#   endif                            // needs to have dll-interface...
+
+    map_type           m_map;
+    std::deque<std::pair<path, boost::uintmax_t> >
+                       m_order;  // insertion order, oldest first; may be stale
+
+#   if defined(_MSC_VER)
+#     pragma warning(pop) // restore warning settings.
+#   endif
+
+    std::size_t        m_max_entries;
+    clock::duration    m_ttl;
+    boost::uintmax_t   m_hits;
+    boost::uintmax_t   m_misses;
+    boost::uintmax_t   m_sequence;
+
+    void m_make_room();
+  };
+
+  namespace detail
+  {
+    BOOST_FILESYSTEM_DECL
+    path canonical(const path& p, const path& base, canonical_context* ctx,
+      system::error_code* ec=0);
+
+    //  canonical() without the POSIX realpath() fast path: resolves element by element
+    //  using symlink_status() and read_symlink(), or ctx if not null
+    BOOST_FILESYSTEM_DECL
+    path canonical_scan(const path& p, const path& base, canonical_context* ctx=0,
+      system::error_code* ec=0);
+  }
+
+  //  canonical() using, and adding to, the symlink cache of ctx
+
+  inline
+  path canonical(const path& p, canonical_context& ctx)
+                                       {return detail::canonical(p, current_path(), &ctx);}
+  inline
+  path canonical(const path& p, canonical_context& ctx, system::error_code& ec)
+                                 {return detail::canonical(p, current_path(), &ctx, &ec);}
+  inline
+  path canonical(const path& p, const path& base, canonical_context& ctx)
+                                       {return detail::canonical(p, base, &ctx);}
+  inline
+  path canonical(const path& p, const path& base, canonical_context& ctx,
+    system::error_code& ec)            {return detail::canonical(p, base, &ctx, &ec);}
+
+  //  canonical_batch: for each i, results[i] = canonical(paths[i], base), or if that
+  //  would report an error, results[i] is empty and errors[i] is the error. The paths
+  //  are processed in sorted order so each distinct directory is resolved once and
+  //  the result reused for every path below it. If ctx is not null, it is used for
+  //  the symlink lookups.
+
+  BOOST_FILESYSTEM_DECL
+  void canonical_batch(const std::vector<path>& paths, const path& base,
+    std::vector<path>& results, std::vector<system::error_code>& errors,
+    canonical_context* ctx=0);
+
+  inline
+  void canonical_batch(const std::vector<path>& paths,
+    std::vector<path>& results, std::vector<system::error_code>& errors)
+                       {canonical_batch(paths, current_path(), results, errors);}
+
+}  // namespace filesystem
+}  // namespace boost
+
+#include <boost/config/abi_suffix.hpp> // pops abi_prefix.hpp pragmas
+
+#endif  // BOOST_FILESYSTEM_CANONICAL_CONTEXT_HPP
@@ -0,0 +1,162 @@
+//  boost/filesystem/directory_index.hpp  ----------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//--------------------------------------------------------------------------------------//
+
+#ifndef BOOST_FILESYSTEM_DIRECTORY_INDEX_HPP
+#define BOOST_FILESYSTEM_DIRECTORY_INDEX_HPP
+
+#include <boost/config.hpp>
+
+# if defined( BOOST_NO_STD_WSTRING )
+#   error Configuration not supported: Boost.Filesystem V3 and later requires std::wstring support
+# endif
+
+#include <boost/filesystem/config.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/tree_snapshot.hpp>
+#include <boost/filesystem/mapped_file.hpp>
+#include <boost/system/error_code.hpp>
+#include <boost/chrono/system_clocks.hpp>
+#include <boost/cstdint.hpp>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+#include <boost/config/abi_prefix.hpp> // must be the last #include
+
+namespace boost
+{
+namespace filesystem
+{
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//                                class directory_index                                 //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+//  A directory_index is a tree_snapshot saved in a file that is used in place by
+//  memory mapping it, so opening one costs a few system calls however many entries it
+//  holds. The file holds the relative paths in snapshot order, so each directory is
+//  followed by its contents, and one fixed-width column per field: the offset and
+//  size of the name, type, parent directory, end of the directory's contents, size,
+//  last write time in nanoseconds and inode. Lookup is a binary search of the names,
+//  and the entries below a directory are a contiguous range.
+//
+//  An index is only as current as the snapshot it was written from. is_current()
+//  checks it by comparing the last write time of each indexed directory with the
+//  live tree: adding, removing or renaming an entry updates its directory's time, so
+//  only the directories it reports stale need to be listed again. Rewriting a file
+//  in place does not update its directory's time, so is_current() does not detect
+//  that.
+//
+//  The file format depends on the byte order and path::value_type of the platform
+//  that wrote it; open() rejects an index written by another platform, or one whose
+//  header is damaged, with errc::bad_message. Entries are checked only as they are
+//  read, so that opening stays cheap: reading one that is damaged throws
+//  filesystem_error with errc::bad_message.
+
+  class BOOST_FILESYSTEM_DECL directory_index
+  {
+  public:
+    static const std::size_t npos = static_cast<std::size_t>(-1);
+
+    directory_index()                                 { m_init(); }
+    explicit directory_index(const path& index_file)  { m_init(); open(index_file); }
+    ~directory_index()                                { close(); }
+
+    //  -----  writing  -----
+
+    //  Writes snapshot to index_file. The index is written to a temporary file in the
+    //  same directory that is then renamed over index_file, as by atomic_ofstream with
+    //  commit_options::durable, so an index that is open is never changed underneath
+    //  its reader, and a crash leaves either the old index or the new one.
+    static void write(const tree_snapshot& snapshot, const path& index_file);
+    static void write(const tree_snapshot& snapshot, const path& index_file,
+      system::error_code& ec);
+
+    //  -----  reading  -----
+
+    void open(const path& index_file);
+    void open(const path& index_file, system::error_code& ec);
+    void close();
+    bool is_open() const                         { return m_file.is_open(); }
+
+    const boost::filesystem::path& root() const  { return m_root; }
+    boost::chrono::system_clock::time_point root_last_write_time() const
+                                                 { return m_root_time; }
+    std::size_t  size() const                    { return m_count; }
+    bool         empty() const                   { return m_count == 0; }
+
+    snapshot_entry operator[](std::size_t i) const;
+    path relative_path(std::size_t i) const;
+    BOOST_SCOPED_ENUM(file_type) type(std::size_t i) const;
+    boost::uintmax_t file_size(std::size_t i) const  { return m_file_size[i]; }
+    boost::chrono::system_clock::time_point last_write_time(std::size_t i) const;
+    boost::uintmax_t inode(std::size_t i) const      { return m_inode[i]; }
+
+    //  Returns: the index of the directory containing entry i, or npos if that is
+    //  the root
+    std::size_t parent(std::size_t i) const;
+    //  Returns: one past the last entry below entry i; i + 1 if there are none
+    std::size_t subtree_end(std::size_t i) const;
+
+    //  Returns: the index of the entry for relative, or size() if there is none
+    std::size_t find(const path& relative) const;
+
+    //  Returns: the range [first, last) of entries below relative, which is empty
+    //  unless relative is an indexed directory. An empty relative selects the whole
+    //  index.
+    std::pair<std::size_t, std::size_t> below(const path& relative) const;
+
+    //  Returns: true if the root and every indexed directory still exist with the
+    //  last write times recorded. Appends the relative paths of the directories that
+    //  do not to *stale, if given, with an empty path standing for the root.
+    bool is_current(std::vector<path>* stale = 0) const;
+    bool is_current(std::vector<path>* stale, system::error_code& ec) const;
+
+  private:
+    mapped_file               m_file;
+    std::size_t               m_count;
+    boost::filesystem::path   m_root;
+    boost::chrono::system_clock::time_point  m_root_time;
+    boost::filesystem::path   m_index_file;  // for error reports
+
+    // the columns, pointing into m_file
+    const path::value_type*   m_names;
+    boost::uint64_t           m_names_size;  // in path::value_type units
+    const boost::uint64_t*    m_name;
+    const boost::uint32_t*    m_name_size;
+    const boost::uint32_t*    m_type;
+    const boost::uint64_t*    m_parent;
+    const boost::uint64_t*    m_subtree_end;
+    const boost::uint64_t*    m_file_size;
+    const boost::int64_t*     m_mtime;
+    const boost::uint64_t*    m_inode;
+
+    void m_init();
+    void m_open(const path& index_file, system::error_code* ec);
+    void m_damaged() const;  // throws
+    const path::value_type* m_name_at(std::size_t i) const;
+    bool m_is_current(std::vector<path>* stale, system::error_code* ec) const;
+    static void m_write(const tree_snapshot& snapshot, const path& index_file,
+      system::error_code* ec);
+
+    directory_index(const directory_index&);             // not copyable
+    directory_index& operator=(const directory_index&);
+  };
+
+}  // namespace filesystem
+}  // namespace boost
+
+#include <boost/config/abi_suffix.hpp> // pops abi_prefix.hpp pragmas
+
+#endif  // BOOST_FILESYSTEM_DIRECTORY_INDEX_HPP
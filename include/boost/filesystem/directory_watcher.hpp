@@ -0,0 +1,171 @@
+//  boost/filesystem/directory_watcher.hpp  --------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//--------------------------------------------------------------------------------------//
+
+#ifndef BOOST_FILESYSTEM_DIRECTORY_WATCHER_HPP
+#define BOOST_FILESYSTEM_DIRECTORY_WATCHER_HPP
+
+#include <boost/config.hpp>
+
+# if defined( BOOST_NO_STD_WSTRING )
+#   error Configuration not supported: Boost.Filesystem V3 and later requires std::wstring support
+# endif
+
+#include <boost/filesystem/config.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/system/error_code.hpp>
+#include <boost/detail/scoped_enum_emulation.hpp>
+#include <boost/chrono/duration.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+#include <vector>
+#include <string>
+#include <cstddef>
+
+#include <boost/config/abi_prefix.hpp> // must be the last #include
+
+//  The watcher is implemented with inotify, so is available only on Linux; elsewhere
+//  each operation reports errc::not_supported.
+
+#if defined(__linux__) && !defined(BOOST_FILESYSTEM_NO_DIRECTORY_WATCHER)
+# define BOOST_FILESYSTEM_HAS_DIRECTORY_WATCHER
+#endif
+
+namespace boost
+{
+namespace filesystem
+{
+  class status_cache;
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//                                  struct watch_event                                  //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+  BOOST_SCOPED_ENUM_DECLARE_BEGIN(change_kind)
+  {
+    created,
+    modified,   // contents or attributes
+    removed,
+    renamed,    // from old_path to path, both watched
+    overflow    // events were lost; rescan everything watched
+  }
+  BOOST_SCOPED_ENUM_DECLARE_END(change_kind)
+
+  struct watch_event
+  {
+    BOOST_SCOPED_ENUM(change_kind)  kind;
+    boost::filesystem::path         path;          // empty for overflow
+    boost::filesystem::path         old_path;      // renamed only
+    bool                            is_directory;
+  };
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//                                class directory_watcher                               //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+//  A directory_watcher reports changes to the entries of the directories added to it.
+//  A recursive watch also covers every directory below, including ones created or
+//  moved in later; their existing contents are then reported as created, since they
+//  may have been filled before the watch was in place.
+//
+//  A rename within the watched directories is reported as one renamed event. A rename
+//  out of them is reported as removed, and one into them as created. The kernel's
+//  queue is bounded, so a reader that falls behind receives an overflow event, after
+//  which it must rescan.
+//
+//  If a status_cache is attached, read() invalidates the cached entries each event
+//  affects before returning it. Not thread-safe; use one watcher per thread.
+
+  class BOOST_FILESYSTEM_DECL directory_watcher
+  {
+  public:
+    typedef int native_handle_type;  // -1 if not open
+
+    directory_watcher();
+    explicit directory_watcher(system::error_code& ec);
+    ~directory_watcher();
+
+    //  -----  watches  -----
+
+    void add(const path& dir, bool recursive = false);
+    void add(const path& dir, bool recursive, system::error_code& ec);
+    void remove(const path& dir);  // dir and, if dir was added recursively, its subtree
+    void remove(const path& dir, system::error_code& ec);
+
+    //  -----  events  -----
+
+    //  Waits until events are available or timeout elapses, then appends them to
+    //  events. A negative timeout waits indefinitely; zero does not wait. An error,
+    //  such as a new subdirectory that cannot be watched, is reported only after every
+    //  pending event has been appended, so none are lost; if it is thrown, they remain
+    //  in events. Only the first error is reported.
+    //  Returns: the number of events appended.
+    std::size_t read(std::vector<watch_event>& events,
+      boost::chrono::milliseconds timeout = boost::chrono::milliseconds(-1));
+    std::size_t read(std::vector<watch_event>& events,
+      boost::chrono::milliseconds timeout, system::error_code& ec);
+
+    //  -----  observers  -----
+
+    //  Readable when events are pending, for use with poll() or an event loop
+    native_handle_type native_handle() const  { return m_fd; }
+    std::size_t watch_count() const           { return m_watches.size(); }
+
+    void attach(status_cache* cache)          { m_cache = cache; }  // 0 detaches
+    status_cache* attached() const            { return m_cache; }
+
+  private:
+    struct watch
+    {
+      boost::filesystem::path  dir;
+      bool                     recursive;
+      bool                     root;       // passed to add()
+    };
+
+    typedef boost::unordered_map<int, watch> watch_map;
+
+#   if defined(_MSC_VER)
+#     pragma warning(push) // Save warning settings
+#     pragma warning(disable : 4251) // disable warning: class 'std::vector<_Ty,_Ax>'
+#   endif                            // needs to have dll-interface...
+
+    watch_map          m_watches;   // by watch descriptor
+    std::vector<char>  m_buffer;
+
+#   if defined(_MSC_VER)
+#     pragma warning(pop) // restore warning settings.
+#   endif
+
+    native_handle_type m_fd;
+    status_cache*      m_cache;
+
+    void m_open(system::error_code* ec);
+    void m_add(const path& dir, bool recursive, bool root,
+      std::vector<watch_event>* existing, system::error_code* ec);
+    void m_remove(const path& dir, system::error_code* ec);
+    std::size_t m_read(std::vector<watch_event>& events,
+      boost::chrono::milliseconds timeout, system::error_code* ec);
+    void m_invalidate(const watch_event& e);
+
+    directory_watcher(const directory_watcher&);             // not copyable
+    directory_watcher& operator=(const directory_watcher&);
+  };
+
+}  // namespace filesystem
+}  // namespace boost
+
+#include <boost/config/abi_suffix.hpp> // pops abi_prefix.hpp pragmas
+
+#endif  // BOOST_FILESYSTEM_DIRECTORY_WATCHER_HPP
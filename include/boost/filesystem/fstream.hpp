@@ -18,9 +18,17 @@
 #   error Configuration not supported: Boost.Filesystem V3 and later requires std::wstring support
 # endif
 
+#include <boost/filesystem/config.hpp>
 #include <boost/filesystem/path.hpp>
+#include <boost/system/error_code.hpp>
+#include <boost/detail/scoped_enum_emulation.hpp>
+#include <boost/detail/bitmask.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/cstdint.hpp>
 #include <iosfwd>
 #include <fstream>
+#include <cstddef>
 
 #include <boost/config/abi_prefix.hpp> // must be the last #include
 
@@ -174,7 +182,429 @@ namespace filesystem
   typedef basic_ifstream<wchar_t> wifstream;
   typedef basic_ofstream<wchar_t> wofstream;
   typedef basic_fstream<wchar_t> wfstream;
-  
+
+//--------------------------------------------------------------------------------------//
+//                                    open_hints                                        //
+//--------------------------------------------------------------------------------------//
+
+//  Advice applied as a native_filebuf opens a file. Hints that the operating system or
+//  file system does not support are ignored.
+//
+//  uncached is for bulk transfers that would otherwise evict more useful data from the
+//  page cache. Where the whole file cannot be marked uncached (F_NOCACHE), pages are
+//  dropped (POSIX_FADV_DONTNEED) as the file position moves past them; written pages
+//  are first written back (sync_file_range() on Linux), so close() waits for that.
+//  It is ignored on Windows, whose unbuffered I/O needs sector aligned transfers.
+
+  BOOST_SCOPED_ENUM_DECLARE_BEGIN(access_hint)
+  {
+    normal,
+    sequential,   // read ahead aggressively
+    random,       // do not read ahead
+    noreuse       // the data will be accessed once
+  }
+  BOOST_SCOPED_ENUM_DECLARE_END(access_hint)
+
+  struct open_hints
+  {
+    BOOST_SCOPED_ENUM(access_hint)  access;
+    bool                            willneed;     // start reading the file in now
+    boost::uintmax_t                preallocate;  // if writing, reserve space for this
+                                                  // many bytes without changing the size
+    bool                            uncached;     // keep the data out of the page cache
+
+    open_hints()
+      : access(access_hint::normal), willneed(false), preallocate(0), uncached(false) {}
+  };
+
+//--------------------------------------------------------------------------------------//
+//                                  native_filebuf                                      //
+//--------------------------------------------------------------------------------------//
+
+//  A native_filebuf is a stream buffer for a file opened with the operating system's
+//  own API rather than <cstdio>. std::basic_filebuf neither exposes its descriptor nor
+//  adopts one, so where native_handle(), open_hints or a buffer size other than the
+//  standard library's is needed, use native_filebuf and the native_ifstream,
+//  native_ofstream and native_fstream built on it in place of the classes above.
+//
+//  The buffer is allocated at construction or by set_buffer_size(); pubsetbuf(s, n)
+//  supplies the caller's own buffer, and pubsetbuf(0, 0) makes the stream unbuffered.
+//  Reads and writes at least as large as the buffer bypass it. Data is transferred
+//  unchanged, as if in binary mode. The open modes are those of std::basic_filebuf.
+
+  class BOOST_FILESYSTEM_DECL native_filebuf : public std::streambuf
+  {
+  public:
+#   ifdef BOOST_WINDOWS_API
+    typedef void* native_handle_type;  // HANDLE
+#   else
+    typedef int native_handle_type;    // file descriptor
+#   endif
+
+    static const std::size_t default_buffer_size = 64 * 1024;
+
+    explicit native_filebuf(std::size_t buffer_size = default_buffer_size);
+    virtual ~native_filebuf();
+
+    native_filebuf* open(const path& p, std::ios_base::openmode mode,
+      const open_hints& hints = open_hints());
+    native_filebuf* close();  // writes buffered output, then closes
+    bool is_open() const;
+
+    //  The handle is open if is_open(); output buffered in the native_filebuf has not
+    //  necessarily been written to it, so call pubsync() first
+
+    native_handle_type native_handle() const  { return m_handle; }
+    std::size_t buffer_size() const           { return m_buffer_size; }
+    void set_buffer_size(std::size_t n)
+                                { pubsetbuf(0, static_cast<std::streamsize>(n)); }
+
+    //  The error that made the last operation fail, e.g. open() or a write
+    const system::error_code& error() const   { return m_error; }
+
+  protected:
+    virtual int_type underflow();
+    virtual int_type overflow(int_type c = traits_type::eof());
+    virtual int sync();
+    virtual std::streamsize xsgetn(char* s, std::streamsize n);
+    virtual std::streamsize xsputn(const char* s, std::streamsize n);
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir way,
+      std::ios_base::openmode which = std::ios_base::in | std::ios_base::out);
+    virtual pos_type seekpos(pos_type pos,
+      std::ios_base::openmode which = std::ios_base::in | std::ios_base::out);
+    virtual std::streambuf* setbuf(char* s, std::streamsize n);
+
+  private:
+#   if defined(_MSC_VER)
+#     pragma warning(push) // Save warning settings
+#     pragma warning(disable : 4251) // disable warning: class 'std::vector<_Ty,_Ax>'
+#   endif                            // needs to have dll-interface...
+
+    boost::scoped_array<char>  m_owned;   // the buffer, unless the caller supplied it
+    system::error_code         m_error;
+
+#   if defined(_MSC_VER)
+#     pragma warning(pop) // restore warning settings.
+#   endif
+
+    native_handle_type       m_handle;
+    char*                    m_buffer;
+    std::size_t              m_buffer_size;
+    char                     m_one;       // the get area when unbuffered
+    std::ios_base::openmode  m_mode;
+    bool                     m_uncached;  // pages are dropped behind the position
+    boost::uintmax_t         m_drop_begin;
+    boost::uintmax_t         m_drop_mark;
+
+    bool m_flush();          // writes and empties the put area
+    bool m_stop_reading();   // moves the file position back over unread input
+    bool m_write(const char* s, std::size_t n);
+    std::streamsize m_read(char* s, std::size_t n);
+    bool m_seek(boost::intmax_t off, std::ios_base::seekdir way, boost::intmax_t& pos);
+    void m_drop_behind();
+
+    //  open(), but if exclusive, creating the file and failing if it exists. On POSIX a
+    //  file created is given create_mode, less the umask
+    native_filebuf* m_open(const path& p, std::ios_base::openmode mode,
+      const open_hints& hints, bool exclusive, unsigned create_mode);
+    friend class atomic_ofstream;  // creates its temporary file exclusively
+
+    native_filebuf(const native_filebuf&);             // not copyable
+    native_filebuf& operator=(const native_filebuf&);
+  };
+
+//--------------------------------------------------------------------------------------//
+//                      native_ifstream, native_ofstream, native_fstream                //
+//--------------------------------------------------------------------------------------//
+
+  class native_ifstream : public std::istream
+  {
+  private: // disallow copying
+    native_ifstream(const native_ifstream&);
+    const native_ifstream& operator=(const native_ifstream&);
+
+  public:
+    native_ifstream() : std::istream(0)  { this->init(&m_buf); }
+    explicit native_ifstream(const path& p,
+      std::ios_base::openmode mode = std::ios_base::in,
+      const open_hints& hints = open_hints())
+      : std::istream(0)                  { this->init(&m_buf); open(p, mode, hints); }
+
+    void open(const path& p, std::ios_base::openmode mode = std::ios_base::in,
+      const open_hints& hints = open_hints())
+    {
+      if (m_buf.open(p, mode | std::ios_base::in, hints))
+        this->clear();
+      else
+        this->setstate(std::ios_base::failbit);
+    }
+    void close()
+    {
+      if (!m_buf.close())
+        this->setstate(std::ios_base::failbit);
+    }
+    bool is_open() const                 { return m_buf.is_open(); }
+
+    native_filebuf* rdbuf() const        { return const_cast<native_filebuf*>(&m_buf); }
+    native_filebuf::native_handle_type native_handle() const
+                                         { return m_buf.native_handle(); }
+  private:
+    native_filebuf m_buf;
+  };
+
+  class native_ofstream : public std::ostream
+  {
+  private: // disallow copying
+    native_ofstream(const native_ofstream&);
+    const native_ofstream& operator=(const native_ofstream&);
+
+  public:
+    native_ofstream() : std::ostream(0)  { this->init(&m_buf); }
+    explicit native_ofstream(const path& p,
+      std::ios_base::openmode mode = std::ios_base::out,
+      const open_hints& hints = open_hints())
+      : std::ostream(0)                  { this->init(&m_buf); open(p, mode, hints); }
+
+    void open(const path& p, std::ios_base::openmode mode = std::ios_base::out,
+      const open_hints& hints = open_hints())
+    {
+      if (m_buf.open(p, mode | std::ios_base::out, hints))
+        this->clear();
+      else
+        this->setstate(std::ios_base::failbit);
+    }
+    void close()
+    {
+      if (!m_buf.close())
+        this->setstate(std::ios_base::failbit);
+    }
+    bool is_open() const                 { return m_buf.is_open(); }
+
+    native_filebuf* rdbuf() const        { return const_cast<native_filebuf*>(&m_buf); }
+    native_filebuf::native_handle_type native_handle() const
+                                         { return m_buf.native_handle(); }
+  private:
+    native_filebuf m_buf;
+  };
+
+  class native_fstream : public std::iostream
+  {
+  private: // disallow copying
+    native_fstream(const native_fstream&);
+    const native_fstream& operator=(const native_fstream&);
+
+  public:
+    native_fstream() : std::iostream(0)  { this->init(&m_buf); }
+    explicit native_fstream(const path& p,
+      std::ios_base::openmode mode = std::ios_base::in | std::ios_base::out,
+      const open_hints& hints = open_hints())
+      : std::iostream(0)                 { this->init(&m_buf); open(p, mode, hints); }
+
+    void open(const path& p,
+      std::ios_base::openmode mode = std::ios_base::in | std::ios_base::out,
+      const open_hints& hints = open_hints())
+    {
+      if (m_buf.open(p, mode, hints))
+        this->clear();
+      else
+        this->setstate(std::ios_base::failbit);
+    }
+    void close()
+    {
+      if (!m_buf.close())
+        this->setstate(std::ios_base::failbit);
+    }
+    bool is_open() const                 { return m_buf.is_open(); }
+
+    native_filebuf* rdbuf() const        { return const_cast<native_filebuf*>(&m_buf); }
+    native_filebuf::native_handle_type native_handle() const
+                                         { return m_buf.native_handle(); }
+  private:
+    native_filebuf m_buf;
+  };
+
+//--------------------------------------------------------------------------------------//
+//                                   atomic_ofstream                                    //
+//--------------------------------------------------------------------------------------//
+
+//  An atomic_ofstream replaces a file as a whole or not at all. Output goes to a
+//  temporary file beside the target, named as if by unique_path(), which commit()
+//  renames over the target; a reader sees either the old contents or the new. If the
+//  stream is closed, discarded or destroyed without a commit(), the temporary file is
+//  removed and the target is untouched.
+//
+//  The temporary file is created exclusively, so an existing file is never opened in
+//  its place. On POSIX, if the target exists, the temporary file is created readable
+//  by its owner alone and then given the target's permissions, so the new contents
+//  are never readable by anyone the target does not allow.
+//
+//  Without sync_file, a crash soon after commit() may leave the target empty or partly
+//  written on some file systems; without sync_directory, it may leave the old file in
+//  place. sync_directory is ignored on Windows, where rename() has no directory to
+//  flush.
+
+  BOOST_SCOPED_ENUM_DECLARE_BEGIN(commit_options)
+  {
+    none = 0,
+    sync_file = 1,        // write the contents to the storage device before renaming
+    sync_directory = 2,   // write the rename to the storage device before returning
+    durable = 3           // sync_file | sync_directory
+  }
+  BOOST_SCOPED_ENUM_DECLARE_END(commit_options)
+
+  BOOST_BITMASK(BOOST_SCOPED_ENUM(commit_options))
+
+  class BOOST_FILESYSTEM_DECL atomic_ofstream : public std::ostream
+  {
+  public:
+    atomic_ofstream() : std::ostream(0)  { this->init(&m_buf); }
+    explicit atomic_ofstream(const path& p, const open_hints& hints = open_hints())
+      : std::ostream(0)                  { this->init(&m_buf); open(p, hints); }
+    virtual ~atomic_ofstream();          // discards, unless committed
+
+    //  Creates the temporary file for p, which is not touched until commit(). Sets
+    //  failbit on failure; rdbuf()->error() tells why.
+    void open(const path& p, const open_hints& hints = open_hints());
+
+    //  Writes buffered output, then replaces the target with the temporary file. On
+    //  failure the temporary file is removed, failbit is set and the target is left as
+    //  it was, unless only the directory sync failed. Either way the stream is closed.
+    void commit(BOOST_SCOPED_ENUM(commit_options) options = commit_options::durable)
+                                         { m_commit(options, 0); }
+    void commit(BOOST_SCOPED_ENUM(commit_options) options, system::error_code& ec)
+                                         { m_commit(options, &ec); }
+
+    void discard();                      // removes the temporary file and closes
+    void close()                         { discard(); }
+    bool is_open() const                 { return m_buf.is_open(); }
+
+    const boost::filesystem::path& target_path() const  { return m_target; }
+    const boost::filesystem::path& temp_path() const    { return m_temp; }
+
+    native_filebuf* rdbuf() const        { return const_cast<native_filebuf*>(&m_buf); }
+    native_filebuf::native_handle_type native_handle() const
+                                         { return m_buf.native_handle(); }
+  private:
+    native_filebuf           m_buf;
+    boost::filesystem::path  m_target;
+    boost::filesystem::path  m_temp;
+
+    void m_commit(BOOST_SCOPED_ENUM(commit_options) options, system::error_code* ec);
+
+    atomic_ofstream(const atomic_ofstream&);             // not copyable
+    atomic_ofstream& operator=(const atomic_ofstream&);
+  };
+
+//--------------------------------------------------------------------------------------//
+//                            async_filebuf, async_ofstream                             //
+//--------------------------------------------------------------------------------------//
+
+//  An async_filebuf writes behind: output is copied into one of buffer_count buffers,
+//  and each buffer, once full, is written to the file by a thread of its own while the
+//  next one is filled. So a write only waits for the disk when every buffer is full
+//  or waiting to be written, which bounds the memory used by a slow disk.
+//
+//  A write that fails is reported by the next output to find it, by pubsync() (and so
+//  by flush()) or by close(), which return failure; error() tells why. Output after a
+//  failure is discarded, since the contents of the file are then unknown. pubsync()
+//  waits until everything written so far is in the file, so a stream that is flushed
+//  often, e.g. by std::endl, gains little over a native_ofstream.
+//
+//  Output only; open modes are those of native_filebuf without in. Seeking is not
+//  supported. On Windows before Vista, which lacks condition variables, buffers are
+//  written by the thread that fills them.
+
+  class BOOST_FILESYSTEM_DECL async_filebuf : public std::streambuf
+  {
+  public:
+    typedef native_filebuf::native_handle_type native_handle_type;
+
+    static const std::size_t default_buffer_size = 64 * 1024;
+    static const std::size_t default_buffer_count = 4;
+
+    //  buffer_count is at least 2
+    explicit async_filebuf(std::size_t buffer_size = default_buffer_size,
+      std::size_t buffer_count = default_buffer_count);
+    virtual ~async_filebuf();
+
+    async_filebuf* open(const path& p, std::ios_base::openmode mode = std::ios_base::out,
+      const open_hints& hints = open_hints());
+    async_filebuf* close();  // waits until everything is written, then closes
+    bool is_open() const                      { return m_file.is_open(); }
+
+    native_handle_type native_handle() const  { return m_file.native_handle(); }
+    std::size_t buffer_size() const           { return m_buffer_size; }
+    std::size_t buffer_count() const          { return m_buffer_count; }
+
+    //  The error that made the last operation fail, or the first write that failed
+    const system::error_code& error() const   { return m_error; }
+
+  protected:
+    virtual int_type overflow(int_type c = traits_type::eof());
+    virtual int sync();
+    virtual std::streamsize xsputn(const char* s, std::streamsize n);
+
+  private:
+    struct writer;
+
+#   if defined(_MSC_VER)
+#     pragma warning(push) // Save warning settings
+#     pragma warning(disable : 4251) // disable warning: class 'std::vector<_Ty,_Ax>'
+#   endif                            // needs to have dll-interface...
+
+    boost::scoped_ptr<writer>  m_writer;
+    system::error_code         m_error;
+
+#   if defined(_MSC_VER)
+#     pragma warning(pop) // restore warning settings.
+#   endif
+
+    native_filebuf  m_file;   // unbuffered; written to only by the writer
+    std::size_t     m_buffer_size;
+    std::size_t     m_buffer_count;
+
+    bool m_submit();  // hands the put area to the writer and starts on a free buffer
+    bool m_drain();   // waits until every buffer handed to the writer is written
+
+    async_filebuf(const async_filebuf&);             // not copyable
+    async_filebuf& operator=(const async_filebuf&);
+  };
+
+  class async_ofstream : public std::ostream
+  {
+  private: // disallow copying
+    async_ofstream(const async_ofstream&);
+    const async_ofstream& operator=(const async_ofstream&);
+
+  public:
+    async_ofstream() : std::ostream(0)  { this->init(&m_buf); }
+    explicit async_ofstream(const path& p,
+      std::ios_base::openmode mode = std::ios_base::out,
+      const open_hints& hints = open_hints())
+      : std::ostream(0)                 { this->init(&m_buf); open(p, mode, hints); }
+
+    void open(const path& p, std::ios_base::openmode mode = std::ios_base::out,
+      const open_hints& hints = open_hints())
+    {
+      if (m_buf.open(p, mode | std::ios_base::out, hints))
+        this->clear();
+      else
+        this->setstate(std::ios_base::failbit);
+    }
+    void close()
+    {
+      if (!m_buf.close())
+        this->setstate(std::ios_base::failbit);
+    }
+    bool is_open() const                { return m_buf.is_open(); }
+
+    async_filebuf* rdbuf() const        { return const_cast<async_filebuf*>(&m_buf); }
+    async_filebuf::native_handle_type native_handle() const
+                                        { return m_buf.native_handle(); }
+  private:
+    async_filebuf m_buf;
+  };
+
 } // namespace filesystem
 } // namespace boost
 
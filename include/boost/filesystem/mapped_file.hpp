@@ -0,0 +1,175 @@
+//  boost/filesystem/mapped_file.hpp  --------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//--------------------------------------------------------------------------------------//
+
+#ifndef BOOST_FILESYSTEM_MAPPED_FILE_HPP
+#define BOOST_FILESYSTEM_MAPPED_FILE_HPP
+
+#include <boost/config.hpp>
+
+# if defined( BOOST_NO_STD_WSTRING )
+#   error Configuration not supported: Boost.Filesystem V3 and later requires std::wstring support
+# endif
+
+#include <boost/filesystem/config.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/system/error_code.hpp>
+#include <boost/detail/scoped_enum_emulation.hpp>
+#include <boost/detail/bitmask.hpp>
+#include <cstddef>
+
+#include <boost/config/abi_prefix.hpp> // must be the last #include
+
+namespace boost
+{
+namespace filesystem
+{
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//                                  class mapped_file                                   //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+//  A mapped_file maps the whole of a regular file into memory, so it can be read, and
+//  in read_write mode written, in place without copying through a stream buffer.
+//
+//  Pages are read in as they are first touched. populate reads the whole file in when
+//  it is mapped (MAP_POPULATE on Linux, otherwise as if by advise(willneed)).
+//  huge_pages places the mapping on a huge page boundary and asks the kernel to back
+//  it with huge pages (MADV_HUGEPAGE) where it supports that, to reduce TLB misses on
+//  large maps; elsewhere it is ignored.
+//
+//  resize() changes the size of the file and maps it again, so invalidates pointers
+//  into the old mapping. When growing, the new blocks are allocated before the file
+//  is extended (posix_fallocate where the file system supports it), so a full disk is
+//  reported by resize() instead of as SIGBUS on first write to the new pages.
+//
+//  A mapping of an empty file has size() 0 and null data.
+
+  BOOST_SCOPED_ENUM_DECLARE_BEGIN(map_mode)
+  {
+    read_only,
+    read_write    // changes are written back to the file
+  }
+  BOOST_SCOPED_ENUM_DECLARE_END(map_mode)
+
+  BOOST_SCOPED_ENUM_DECLARE_BEGIN(map_options)
+  {
+    none = 0,
+    create = 1,       // read_write: create the file, empty, if it does not exist
+    populate = 2,     // read the whole file in when it is mapped
+    huge_pages = 4    // align to, and ask for, huge pages
+  }
+  BOOST_SCOPED_ENUM_DECLARE_END(map_options)
+
+  BOOST_BITMASK(BOOST_SCOPED_ENUM(map_options))
+
+  BOOST_SCOPED_ENUM_DECLARE_BEGIN(map_advice)
+  {
+    normal,
+    sequential,   // read ahead aggressively, and drop pages soon after they are read
+    random,       // do not read ahead
+    willneed,     // start reading the range in now
+    dontneed      // the range will not be needed soon
+  }
+  BOOST_SCOPED_ENUM_DECLARE_END(map_advice)
+
+  class BOOST_FILESYSTEM_DECL mapped_file
+  {
+  public:
+#   ifdef BOOST_WINDOWS_API
+    typedef void* native_handle_type;  // HANDLE of the file
+#   else
+    typedef int native_handle_type;    // file descriptor
+#   endif
+
+    mapped_file()  { m_init(); }
+    explicit mapped_file(const path& p,
+      BOOST_SCOPED_ENUM(map_mode) mode = map_mode::read_only,
+      BOOST_SCOPED_ENUM(map_options) options = map_options::none)
+                                       { m_init(); m_open(p, mode, options, 0); }
+    mapped_file(const path& p, BOOST_SCOPED_ENUM(map_mode) mode,
+      BOOST_SCOPED_ENUM(map_options) options, system::error_code& ec)
+                                       { m_init(); m_open(p, mode, options, &ec); }
+    ~mapped_file()                     { close(); }
+
+    void open(const path& p, BOOST_SCOPED_ENUM(map_mode) mode = map_mode::read_only,
+      BOOST_SCOPED_ENUM(map_options) options = map_options::none)
+                                       { m_open(p, mode, options, 0); }
+    void open(const path& p, BOOST_SCOPED_ENUM(map_mode) mode,
+      BOOST_SCOPED_ENUM(map_options) options, system::error_code& ec)
+                                       { m_open(p, mode, options, &ec); }
+    void close();
+
+    //  -----  observers  -----
+
+    bool         is_open() const                { return m_is_open; }
+    BOOST_SCOPED_ENUM(map_mode) mode() const    { return m_mode; }
+    std::size_t  size() const                   { return m_size; }
+    const char*  const_data() const             { return m_data; }
+    //  Returns: the mapping if writable, otherwise 0
+    char*        data() const
+                           { return m_mode == map_mode::read_write ? m_data : 0; }
+    native_handle_type native_handle() const    { return m_handle; }
+
+    //  -----  operations  -----
+
+    //  Hints how the whole mapping, or [offset, offset+length) of it, will be used
+    void advise(BOOST_SCOPED_ENUM(map_advice) advice)
+                                       { m_advise(advice, 0, m_size, 0); }
+    void advise(BOOST_SCOPED_ENUM(map_advice) advice, system::error_code& ec)
+                                       { m_advise(advice, 0, m_size, &ec); }
+    void advise(BOOST_SCOPED_ENUM(map_advice) advice, std::size_t offset,
+      std::size_t length)              { m_advise(advice, offset, length, 0); }
+    void advise(BOOST_SCOPED_ENUM(map_advice) advice, std::size_t offset,
+      std::size_t length, system::error_code& ec)
+                                       { m_advise(advice, offset, length, &ec); }
+
+    //  read_write only: sets the size of the file to new_size and maps all of it.
+    //  On error the file and mapping are unchanged, unless the error came from
+    //  mapping the resized file, in which case the mapping is closed.
+    void resize(std::size_t new_size)  { m_resize(new_size, 0); }
+    void resize(std::size_t new_size, system::error_code& ec)
+                                       { m_resize(new_size, &ec); }
+
+    //  Writes changed pages, and the file's size, to the storage device
+    void flush()                       { m_flush(0); }
+    void flush(system::error_code& ec) { m_flush(&ec); }
+
+  private:
+    char*                           m_data;
+    std::size_t                     m_size;
+    native_handle_type              m_handle;
+    bool                            m_is_open;
+    BOOST_SCOPED_ENUM(map_mode)     m_mode;
+    BOOST_SCOPED_ENUM(map_options)  m_options;
+    boost::filesystem::path         m_path;  // for error reports
+
+    void m_init();
+    void m_open(const path& p, BOOST_SCOPED_ENUM(map_mode) mode,
+      BOOST_SCOPED_ENUM(map_options) options, system::error_code* ec);
+    bool m_map(system::error_code& ec);
+    void m_unmap();
+    void m_advise(BOOST_SCOPED_ENUM(map_advice) advice, std::size_t offset,
+      std::size_t length, system::error_code* ec);
+    void m_resize(std::size_t new_size, system::error_code* ec);
+    void m_flush(system::error_code* ec);
+
+    mapped_file(const mapped_file&);             // not copyable
+    mapped_file& operator=(const mapped_file&);
+  };
+
+}  // namespace filesystem
+}  // namespace boost
+
+#include <boost/config/abi_suffix.hpp> // pops abi_prefix.hpp pragmas
+
+#endif  // BOOST_FILESYSTEM_MAPPED_FILE_HPP
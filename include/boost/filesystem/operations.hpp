@@ -29,6 +29,7 @@
 #include <boost/system/error_code.hpp>
 #include <boost/system/system_error.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/move/core.hpp>
 #include <boost/utility/enable_if.hpp>
 #include <boost/type_traits/is_same.hpp>
 #include <boost/iterator.hpp>
@@ -253,6 +254,11 @@ namespace boost
     // unspecified implementation detail
     _detail_sub_directory = 512,
 
+    // Option controlling copy_file() I/O: keep the data of both files out of the
+    // page cache, for bulk copies (O_DIRECT or drop-behind on POSIX, where supported,
+    // COPY_FILE_NO_BUFFERING on Windows Vista and later)
+    uncached = 1024,
+
 # ifndef BOOST_FILESYSTEM_NO_DEPRECATED
       fail_if_exists = none,
       overwrite_if_exists = overwrite_existing
@@ -278,6 +284,50 @@ namespace boost
     boost::uintmax_t available; // <= free
   };
 
+  //  temp_file: returned by create_temp_file() and create_anonymous_temp_file(). It
+  //  owns a handle open for reading and writing. file_path() is empty for an anonymous
+  //  file until link_temp_file() gives it a name.
+  //
+  //  close() closes the handle and keeps the file. A temp_file destroyed while still
+  //  open, e.g. by an exception before the file was complete, is abandoned: the handle
+  //  is closed and the file removed. release() hands the handle to the caller, who
+  //  must then close it with close() on POSIX or CloseHandle() on Windows.
+
+  namespace detail { struct temp_file_access; }
+
+  class BOOST_FILESYSTEM_DECL temp_file
+  {
+    BOOST_MOVABLE_BUT_NOT_COPYABLE(temp_file)
+  public:
+#   ifdef BOOST_WINDOWS_API
+    typedef void* native_handle_type;  // HANDLE
+#   else
+    typedef int native_handle_type;    // file descriptor
+#   endif
+
+    temp_file();                                      // not open
+    temp_file(BOOST_RV_REF(temp_file) f);
+    temp_file& operator=(BOOST_RV_REF(temp_file) f);
+    ~temp_file();                                     // abandons the file if open
+
+    bool is_open() const;
+    native_handle_type native_handle() const          { return m_handle; }
+    const boost::filesystem::path& file_path() const  { return m_path; }
+
+    void close()                                      { m_close(0); }
+    void close(system::error_code& ec)                { m_close(&ec); }
+    native_handle_type release();  // the handle, which is no longer owned
+
+  private:
+    native_handle_type       m_handle;
+    boost::filesystem::path  m_path;
+
+    void m_close(system::error_code* ec);
+    void m_abandon();
+
+    friend struct detail::temp_file_access;  // fills in a newly created file
+  };
+
 #ifdef BOOST_FILESYSTEM_USE_TIME_T
   typedef std::time_t file_time_type;
 #else
@@ -342,6 +392,15 @@ namespace boost
     BOOST_FILESYSTEM_DECL
     void last_write_time(const path& p, const std::time_t new_time,
                          system::error_code* ec=0);
+#ifndef BOOST_FILESYSTEM_USE_TIME_T
+    //  last_write_time() at the resolution of the file system and system_clock
+    BOOST_FILESYSTEM_DECL
+    boost::chrono::system_clock::time_point
+      last_write_time_point(const path& p, system::error_code* ec=0);
+    BOOST_FILESYSTEM_DECL
+    void last_write_time(const path& p, boost::chrono::system_clock::time_point new_time,
+                         system::error_code* ec=0);
+#endif
     BOOST_FILESYSTEM_DECL
     void permissions(const path& p, perms prms, system::error_code* ec=0);
     BOOST_FILESYSTEM_DECL
@@ -363,6 +422,34 @@ namespace boost
     path temp_directory_path(system::error_code* ec=0);
     BOOST_FILESYSTEM_DECL
     path unique_path(const path& p, system::error_code* ec=0);
+    BOOST_FILESYSTEM_DECL
+    temp_file create_temp_file(const path& dir, const path& model,
+                               system::error_code* ec=0);
+    BOOST_FILESYSTEM_DECL
+    path create_temp_directory(const path& dir, const path& model,
+                               system::error_code* ec=0);
+    BOOST_FILESYSTEM_DECL
+    temp_file create_anonymous_temp_file(const path& dir, system::error_code* ec=0);
+    BOOST_FILESYSTEM_DECL
+    void link_temp_file(temp_file& f, const path& dir, const path& model,
+                        system::error_code* ec=0);
+
+    //  native string forms of the status queries, used by basic_path<Allocator> so
+    //  that its contents need not be copied into a path; a path is constructed only to
+    //  report an error. Windows: forward to the path forms.
+    BOOST_FILESYSTEM_DECL
+    file_status status(const path::value_type* p, system::error_code* ec=0);
+    BOOST_FILESYSTEM_DECL
+    file_status symlink_status(const path::value_type* p, system::error_code* ec=0);
+    BOOST_FILESYSTEM_DECL
+    boost::uintmax_t file_size(const path::value_type* p, system::error_code* ec=0);
+    BOOST_FILESYSTEM_DECL
+    std::time_t last_write_time(const path::value_type* p, system::error_code* ec=0);
+#ifndef BOOST_FILESYSTEM_USE_TIME_T
+    BOOST_FILESYSTEM_DECL
+    boost::chrono::system_clock::time_point
+      last_write_time_point(const path::value_type* p, system::error_code* ec=0);
+#endif
   }  // namespace detail
 
 //--------------------------------------------------------------------------------------//
@@ -616,7 +703,7 @@ namespace boost
 #ifdef BOOST_FILESYSTEM_USE_TIME_T
     {return detail::last_write_time(p);}
 #else
-    {return boost::chrono::system_clock::from_time_t(detail::last_write_time(p));}
+    {return detail::last_write_time_point(p);}
 #endif
 
   inline
@@ -624,7 +711,7 @@ namespace boost
 #ifdef BOOST_FILESYSTEM_USE_TIME_T
     {return detail::last_write_time(p, &ec);}
 #else
-    {return boost::chrono::system_clock::from_time_t(detail::last_write_time(p, &ec));}
+    {return detail::last_write_time_point(p, &ec);}
 #endif
 
   inline
@@ -632,7 +719,7 @@ namespace boost
 #ifdef BOOST_FILESYSTEM_USE_TIME_T
     {detail::last_write_time(p, new_time);}
 #else
-    {detail::last_write_time(p, boost::chrono::system_clock::to_time_t(new_time));}
+    {detail::last_write_time(p, new_time);}
 #endif
 
   inline
@@ -641,7 +728,7 @@ namespace boost
 #ifdef BOOST_FILESYSTEM_USE_TIME_T
     {detail::last_write_time(p, new_time, &ec);}
 #else
-    {detail::last_write_time(p, boost::chrono::system_clock::to_time_t(new_time), &ec);}
+    {detail::last_write_time(p, new_time, &ec);}
 #endif
 
   inline
@@ -714,6 +801,51 @@ namespace boost
   path unique_path(const path& p, system::error_code& ec)
                                        { return detail::unique_path(p, &ec); }
 
+  //  create_temp_file, create_temp_directory: create a new file or directory in dir,
+  //  named as if by unique_path(model), exclusively (O_EXCL, CREATE_NEW), retrying
+  //  with a new name if the name is taken. The file is open for reading and writing,
+  //  and private to the owner. On error, handle is -1 (INVALID_HANDLE_VALUE).
+  //
+  //  create_anonymous_temp_file: create a file in dir that has no name, using O_TMPFILE
+  //  on Linux; elsewhere, or if the file system does not support it, a file is created
+  //  as by create_temp_file() and then removed (POSIX) or marked delete on close
+  //  (Windows). link_temp_file() names an O_TMPFILE file once it is complete, as if by
+  //  create_temp_file(dir, model), so readers never see it partly written. It reports
+  //  an error for any other file.
+
+  inline
+  temp_file create_temp_file(const path& dir, const path& model="%%%%-%%%%-%%%%-%%%%")
+                                       {return detail::create_temp_file(dir, model);}
+  inline
+  temp_file create_temp_file(const path& dir, system::error_code& ec)
+                {return detail::create_temp_file(dir, "%%%%-%%%%-%%%%-%%%%", &ec);}
+  inline
+  temp_file create_temp_file(const path& dir, const path& model, system::error_code& ec)
+                                       {return detail::create_temp_file(dir, model, &ec);}
+  inline
+  path create_temp_directory(const path& dir, const path& model="%%%%-%%%%-%%%%-%%%%")
+                                       {return detail::create_temp_directory(dir, model);}
+  inline
+  path create_temp_directory(const path& dir, system::error_code& ec)
+           {return detail::create_temp_directory(dir, "%%%%-%%%%-%%%%-%%%%", &ec);}
+  inline
+  path create_temp_directory(const path& dir, const path& model, system::error_code& ec)
+                                  {return detail::create_temp_directory(dir, model, &ec);}
+  inline
+  temp_file create_anonymous_temp_file(const path& dir)
+                                       {return detail::create_anonymous_temp_file(dir);}
+  inline
+  temp_file create_anonymous_temp_file(const path& dir, system::error_code& ec)
+                                  {return detail::create_anonymous_temp_file(dir, &ec);}
+  inline
+  void link_temp_file(temp_file& f, const path& dir,
+                      const path& model="%%%%-%%%%-%%%%-%%%%")
+                                       {detail::link_temp_file(f, dir, model);}
+  inline
+  void link_temp_file(temp_file& f, const path& dir, const path& model,
+                      system::error_code& ec)
+                                       {detail::link_temp_file(f, dir, model, &ec);}
+
 //--------------------------------------------------------------------------------------//
 //                                                                                      //
 //                                 directory_entry                                      //
@@ -32,6 +32,7 @@
 #include <boost/static_assert.hpp>
 #include <boost/functional/hash_fwd.hpp>
 #include <boost/type_traits/is_integral.hpp>
+#include <boost/utility/string_ref.hpp>
 #include <string>
 #include <iterator>
 #include <cstring>
@@ -40,6 +41,10 @@
 #include <cassert>
 #include <locale>
 #include <algorithm>
+#include <utility>
+# ifndef BOOST_NO_CXX17_HDR_STRING_VIEW
+#   include <string_view>
+# endif
 
 #include <boost/config/abi_prefix.hpp> // must be the last #include
 
@@ -51,6 +56,16 @@ namespace boost
 {
 namespace filesystem
 {
+  class path;
+  class path_pool;
+
+  namespace detail
+  {
+    //  *first / ... / *(last-1), built with a single allocation
+    BOOST_FILESYSTEM_DECL
+      path join(const path* const* first, const path* const* last);
+  }
+
   //------------------------------------------------------------------------------------//
   //                                                                                    //
   //                                    class path                                      //
@@ -92,8 +107,9 @@ namespace filesystem
     //  argument is given, using a conversion object modeled on
     //  std::wstring_convert.
     //
-    //  The path locale, which is global to the thread, can be changed by the
-    //  imbue() function. It is initialized to an implementation defined locale.
+    //  The path locale, which is global to the program, can be changed by the
+    //  imbue() function, and overridden for a single thread by imbue_thread(). It
+    //  is initialized to an implementation defined locale on first use.
     //  
     //  For Windows, wchar_t strings do not undergo conversion. char strings
     //  are converted using the "ANSI" or "OEM" code pages, as determined by
@@ -499,6 +515,13 @@ namespace filesystem
     path  stem() const;              // returns 0 or 1 element path
     path  extension() const;         // returns 0 or 1 element path
 
+    //  -----  lexical operations  -----
+
+    //  no filesystem access; symbolic links are not resolved
+    path  lexically_normal() const;
+    path  lexically_relative(const path& base) const;
+    path  lexically_proximate(const path& base) const;
+
     //  -----  query  -----
 
     bool empty() const               { return m_pathname.empty(); } // name consistent with std containers
@@ -530,9 +553,18 @@ namespace filesystem
 
     //  -----  static member functions  -----
 
+    //  imbue() and codecvt() may be called concurrently. The reference returned by
+    //  codecvt() remains valid after imbue() replaces the locale; under an
+    //  imbue_thread() override, only until the override is changed or the thread ends.
+    //  imbue() returns the locale it replaces, which is the default if no conversion
+    //  has yet been made.
     static std::locale  imbue(const std::locale& loc);
     static const        codecvt_type& codecvt();
 
+    //  Per-thread override of the path locale for the calling thread
+    static void         imbue_thread(const std::locale& loc);
+    static void         reset_thread_locale();
+
     //  -----  deprecated functions  -----
 
 # if defined(BOOST_FILESYSTEM_DEPRECATED) && defined(BOOST_FILESYSTEM_NO_DEPRECATED)
@@ -607,6 +639,8 @@ namespace filesystem
     //    warning #427-D: qualified name is not allowed in member declaration 
     friend class iterator;
     friend bool operator<(const path& lhs, const path& rhs);
+    friend path detail::join(const path* const* first, const path* const* last);
+    friend class path_pool;  // to_path() builds m_pathname in place
 
     // see path::iterator::increment/decrement comment below
     static void m_path_iterator_increment(path::iterator & it);
@@ -619,6 +653,31 @@ namespace filesystem
     BOOST_FILESYSTEM_DECL
       int lex_compare(path::iterator first1, path::iterator last1,
         path::iterator first2, path::iterator last2);
+
+    //  hash of a native format character sequence; processes a machine word at a time
+    //  with four independent lanes so long paths hash at memory speed.
+    //  Windows: slash and backslash hash the same
+    BOOST_FILESYSTEM_DECL
+      std::size_t hash_native(const path::value_type* s, std::size_t size) BOOST_NOEXCEPT;
+
+    //  equality of native format character sequences, consistent with hash_native()
+    inline bool native_equal(const path::value_type* s1, std::size_t size1,
+      const path::value_type* s2, std::size_t size2) BOOST_NOEXCEPT
+    {
+      if (size1 != size2)
+        return false;
+#   ifdef BOOST_WINDOWS_API
+      for (; size1; --size1, ++s1, ++s2)
+      {
+        if (*s1 != *s2
+          && !((*s1 == L'/' || *s1 == L'\\') && (*s2 == L'/' || *s2 == L'\\')))
+          return false;
+      }
+      return true;
+#   else
+      return size1 == 0 || std::memcmp(s1, s2, size1) == 0;
+#   endif
+    }
   }
 
 # ifndef BOOST_FILESYSTEM_NO_DEPRECATED
@@ -684,19 +743,165 @@ namespace filesystem
 
   inline std::size_t hash_value(const path& x)
   {
-# ifdef BOOST_WINDOWS_API
-    std::size_t seed = 0;
-    for(const path::value_type* it = x.c_str(); *it; ++it)
-      hash_combine(seed, *it == '/' ? L'\\' : *it);
-    return seed;
-# else   // BOOST_POSIX_API
-    return hash_range(x.native().begin(), x.native().end());
-# endif
+    return detail::hash_native(x.c_str(), x.native().size());
   }
 
   inline void swap(path& lhs, path& rhs)                   { lhs.swap(rhs); }
 
-  inline path operator/(const path& lhs, const path& rhs)  { return path(lhs) /= rhs; }
+  //  hashed_path: a path together with its precomputed hash_value(), for use as the
+  //  key of large unordered containers where rehashing on every lookup, rehash, or
+  //  bucket walk would otherwise dominate.
+
+  class hashed_path
+  {
+  public:
+    hashed_path() : m_hash(hash_value(m_path)) {}
+    explicit hashed_path(const boost::filesystem::path& p)
+      : m_path(p), m_hash(hash_value(m_path)) {}
+# ifndef BOOST_NO_CXX11_RVALUE_REFERENCES
+    explicit hashed_path(boost::filesystem::path&& p)
+      : m_path(std::move(p)), m_hash(hash_value(m_path)) {}
+# endif
+
+    // the gcc namespace/member name problem is described in class directory_entry
+    const boost::filesystem::path&  path() const BOOST_NOEXCEPT  { return m_path; }
+    operator const boost::filesystem::path&() const BOOST_NOEXCEPT { return m_path; }
+    std::size_t                     hash() const BOOST_NOEXCEPT  { return m_hash; }
+
+    void swap(hashed_path& rhs)
+    {
+      m_path.swap(rhs.m_path);
+      std::swap(m_hash, rhs.m_hash);
+    }
+
+  private:
+    boost::filesystem::path  m_path;
+    std::size_t              m_hash;
+  };
+
+  inline std::size_t hash_value(const hashed_path& x) { return x.hash(); }
+  inline void swap(hashed_path& lhs, hashed_path& rhs) { lhs.swap(rhs); }
+
+  //  hashed_path equality is native string identity (Windows: slash and backslash
+  //  are equal), i.e. the equivalence used by path_equal_to
+  inline bool operator==(const hashed_path& lhs, const hashed_path& rhs)
+  {
+    return lhs.hash() == rhs.hash()
+      && detail::native_equal(lhs.path().c_str(), lhs.path().native().size(),
+           rhs.path().c_str(), rhs.path().native().size());
+  }
+  inline bool operator!=(const hashed_path& lhs, const hashed_path& rhs)
+    { return !(lhs == rhs); }
+
+  //  path_hash and path_equal_to: transparent function objects for unordered containers
+  //  keyed by path, so lookups may use a path, hashed_path, native string, pointer to a
+  //  null terminated native string, or native string view without constructing a path.
+  //
+  //  Keys are compared in native format and are not converted; equivalence is native
+  //  string identity (Windows: slash and backslash are equal), which is cheaper than,
+  //  and for unnormalized paths finer than, the element-wise operator==.
+
+  namespace detail
+  {
+    struct native_key
+    {
+      const path::value_type*  data;
+      std::size_t              size;
+
+      native_key(const path& p) : data(p.c_str()), size(p.native().size()) {}
+      native_key(const hashed_path& p)
+        : data(p.path().c_str()), size(p.path().native().size()) {}
+      template <class Allocator>
+      native_key(const std::basic_string<path::value_type,
+        std::char_traits<path::value_type>, Allocator>& s)
+        : data(s.c_str()), size(s.size()) {}
+      native_key(const path::value_type* s)
+        : data(s), size(std::char_traits<path::value_type>::length(s)) {}
+      native_key(boost::basic_string_ref<path::value_type> s)
+        : data(s.data()), size(s.size()) {}
+#   ifndef BOOST_NO_CXX17_HDR_STRING_VIEW
+      native_key(std::basic_string_view<path::value_type> s)
+        : data(s.data()), size(s.size()) {}
+#   endif
+    };
+  }
+
+  struct path_hash
+  {
+    typedef void is_transparent;
+    typedef std::size_t result_type;
+
+    std::size_t operator()(const hashed_path& p) const BOOST_NOEXCEPT { return p.hash(); }
+    std::size_t operator()(detail::native_key k) const BOOST_NOEXCEPT
+      { return detail::hash_native(k.data, k.size); }
+  };
+
+  struct path_equal_to
+  {
+    typedef void is_transparent;
+    typedef bool result_type;
+
+    bool operator()(const hashed_path& lhs, const hashed_path& rhs) const
+      { return lhs == rhs; }
+    bool operator()(detail::native_key lhs, detail::native_key rhs) const BOOST_NOEXCEPT
+      { return detail::native_equal(lhs.data, lhs.size, rhs.data, rhs.size); }
+  };
+
+  inline path operator/(const path& lhs, const path& rhs)
+  {
+    const path* const elements[] = { &lhs, &rhs };
+    return detail::join(elements, elements + 2);
+  }
+
+  //  join() has the same result as applying operator/ left to right, but computes the
+  //  final length up front and so performs a single allocation. Prefer it to a chain
+  //  of operator/ such as a / b / c / d.
+
+# if !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+
+  namespace detail
+  {
+    template <class... Paths> inline
+    path join_paths(const Paths&... p)
+    {
+      const path* const elements[] = { &p... };
+      return join(elements, elements + sizeof...(p));
+    }
+  }
+
+  template <class... Sources> inline
+  path join(const path& p1, const path& p2, const Sources&... rest)
+  {
+    return detail::join_paths(p1, p2, static_cast<const path&>(rest)...);
+  }
+
+# else
+
+  inline path join(const path& p1, const path& p2)
+  {
+    return p1 / p2;
+  }
+
+  inline path join(const path& p1, const path& p2, const path& p3)
+  {
+    const path* const elements[] = { &p1, &p2, &p3 };
+    return detail::join(elements, elements + 3);
+  }
+
+  inline path join(const path& p1, const path& p2, const path& p3, const path& p4)
+  {
+    const path* const elements[] = { &p1, &p2, &p3, &p4 };
+    return detail::join(elements, elements + 4);
+  }
+
+  inline path join(const path& p1, const path& p2, const path& p3, const path& p4,
+    const path& p5)
+  {
+    const path* const elements[] = { &p1, &p2, &p3, &p4, &p5 };
+    return detail::join(elements, elements + 5);
+  }
+
+# endif
 
   //  inserters and extractors
   //    use boost::io::quoted() to handle spaces in paths
@@ -0,0 +1,171 @@
+//  boost/filesystem/path_pool.hpp  ----------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//--------------------------------------------------------------------------------------//
+
+#ifndef BOOST_FILESYSTEM_PATH_POOL_HPP
+#define BOOST_FILESYSTEM_PATH_POOL_HPP
+
+#include <boost/config.hpp>
+
+# if defined( BOOST_NO_STD_WSTRING )
+#   error Configuration not supported: Boost.Filesystem V3 and later requires std::wstring support
+# endif
+
+#include <boost/filesystem/config.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/system/error_code.hpp>
+#include <boost/cstdint.hpp>
+#include <vector>
+#include <cstddef>
+
+#include <boost/config/abi_prefix.hpp> // must be the last #include
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//                                   class path_pool                                    //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+//  A path_pool interns paths as a tree of (parent, name) nodes. Each distinct element
+//  name is stored once, and each distinct path prefix is a single 8-byte node, so large
+//  inventories of paths sharing long prefixes take a small fraction of the memory of
+//  independent path objects.
+//
+//  Paths are interned element by element, as delivered by path::iterator; the path
+//  returned by to_path() compares equal (operator==) to the path that was interned,
+//  although redundant separators are not preserved.
+//
+//  A handle is 32-bits. Handles obtained from the same pool are equal if and only if
+//  they designate equal paths. Handles are never invalidated except by clear().
+//
+//  Not thread-safe; concurrent const access is safe.
+
+namespace boost
+{
+namespace filesystem
+{
+
+  class BOOST_FILESYSTEM_DECL path_pool
+  {
+  public:
+
+    class handle
+    {
+    public:
+      handle() BOOST_NOEXCEPT : m_id(0) {}  // the empty path
+
+      bool             empty() const BOOST_NOEXCEPT  { return m_id == 0; }
+      boost::uint32_t  id() const BOOST_NOEXCEPT     { return m_id; }
+
+      bool operator==(handle rhs) const BOOST_NOEXCEPT { return m_id == rhs.m_id; }
+      bool operator!=(handle rhs) const BOOST_NOEXCEPT { return m_id != rhs.m_id; }
+      bool operator< (handle rhs) const BOOST_NOEXCEPT { return m_id < rhs.m_id; }
+
+    private:
+      friend class path_pool;
+      explicit handle(boost::uint32_t id) BOOST_NOEXCEPT : m_id(id) {}
+      boost::uint32_t  m_id;
+    };
+
+    path_pool();
+
+    //  -----  interning  -----
+
+    handle intern(const path& p);
+
+    //  interns the elements of relative appended to base
+    handle intern(handle base, const path& relative);
+
+    //  interns e.path().filename() within directory dir; dir must be the handle of
+    //  e.path().parent_path(), as when iterating over the directory dir designates
+    handle intern(handle dir, const directory_entry& e)
+    {
+      return intern(dir, e.path().filename());
+    }
+
+    //  appends a handle for each entry of directory dir to entries, and returns the
+    //  handle for dir itself
+    handle intern_directory(const path& dir, std::vector<handle>& entries)
+    {
+      return m_intern_directory(dir, entries, false, 0);
+    }
+    handle intern_directory(const path& dir, std::vector<handle>& entries,
+      system::error_code& ec)
+    {
+      return m_intern_directory(dir, entries, false, &ec);
+    }
+
+    //  as intern_directory, but recurses into subdirectories, as if by
+    //  recursive_directory_iterator
+    handle intern_tree(const path& root, std::vector<handle>& entries)
+    {
+      return m_intern_directory(root, entries, true, 0);
+    }
+    handle intern_tree(const path& root, std::vector<handle>& entries,
+      system::error_code& ec)
+    {
+      return m_intern_directory(root, entries, true, &ec);
+    }
+
+    //  -----  observers  -----
+
+    path    to_path(handle h) const;
+    path    filename(handle h) const;  // last element, as by path::iterator
+    handle  parent(handle h) const BOOST_NOEXCEPT;
+
+    std::size_t size() const BOOST_NOEXCEPT  { return m_nodes.size() - 1; }  // nodes
+    std::size_t name_count() const BOOST_NOEXCEPT { return m_name_offsets.size() - 2; }
+
+    //  -----  modifiers  -----
+
+    void clear();
+    void swap(path_pool& rhs);
+
+  private:
+    struct node
+    {
+      boost::uint32_t  parent;
+      boost::uint32_t  name;
+    };
+
+#   if defined(_MSC_VER)
+#     pragma warning(push) // Save warning settings
+#     pragma warning(disable : 4251) // disable warning: class 'std::vector<_Ty,_Ax>'
+#   endif                            // needs to have dll-interface...
+
+    std::vector<node>             m_nodes;         // m_nodes[0] is the empty path
+    std::vector<boost::uint32_t>  m_node_table;    // open addressing; 0 is an empty slot
+    path::string_type             m_chars;         // name characters, end to end
+    std::vector<boost::uint32_t>  m_name_offsets;  // name i is [offsets[i], offsets[i+1])
+    std::vector<boost::uint32_t>  m_name_table;    // open addressing; 0 is an empty slot
+
+#   if defined(_MSC_VER)
+#     pragma warning(pop) // restore warning settings.
+#   endif
+
+    boost::uint32_t m_intern_name(const path::value_type* s, std::size_t size);
+    boost::uint32_t m_intern_node(boost::uint32_t parent, boost::uint32_t name);
+    void m_grow_node_table();
+    void m_grow_name_table();
+    bool m_needs_separator(const node& n) const;
+    handle m_intern_directory(const path& dir, std::vector<handle>& entries,
+      bool recursive, system::error_code* ec);
+  };
+
+  inline std::size_t hash_value(path_pool::handle h) { return h.id(); }
+  inline void swap(path_pool& lhs, path_pool& rhs)   { lhs.swap(rhs); }
+
+}  // namespace filesystem
+}  // namespace boost
+
+#include <boost/config/abi_suffix.hpp> // pops abi_prefix.hpp pragmas
+
+#endif  // BOOST_FILESYSTEM_PATH_POOL_HPP
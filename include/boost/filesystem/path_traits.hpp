@@ -47,6 +47,7 @@ namespace boost { namespace filesystem {
   //              conversion was necessary.
 
   class directory_entry;
+  template <class Allocator> class basic_path;
   
 namespace path_traits {
  
@@ -78,6 +79,8 @@ namespace path_traits {
   template<> struct is_pathable<std::list<boost::char16> > {static const bool value = true;};
   template<> struct is_pathable<std::list<boost::char32> > {static const bool value = true;};
   template<> struct is_pathable<directory_entry>        {static const bool value = true;};
+  template <class Allocator>
+    struct is_pathable<basic_path<Allocator> >          {static const bool value = true;};
 
   //  Pathable empty
 
@@ -99,6 +102,10 @@ namespace path_traits {
      bool empty(T (&x)[N])
        { return !x[0]; }
 
+  template <class Allocator> inline
+    bool empty(const basic_path<Allocator>& p)
+      { return p.empty(); }
+
   // value types differ  ---------------------------------------------------------------//
   //
   //   A from_end argument of 0 is less efficient than a known end, so use only if needed
@@ -318,6 +325,14 @@ namespace path_traits {
     convert(c_str, to, cvt);
   }
   
+  //  basic_path
+  template <class Allocator, class U> inline
+  void dispatch(const basic_path<Allocator>& p, U& to, const codecvt_type& cvt)
+  {
+    if (!p.empty())
+      convert(p.c_str(), p.c_str() + p.native().size(), to, cvt);
+  }
+
   //  Note: there is no dispatch on C-style arrays because the array may
   //  contain a string smaller than the array size. 
 
@@ -0,0 +1,190 @@
+//  boost/filesystem/status_cache.hpp  -------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//--------------------------------------------------------------------------------------//
+
+#ifndef BOOST_FILESYSTEM_STATUS_CACHE_HPP
+#define BOOST_FILESYSTEM_STATUS_CACHE_HPP
+
+#include <boost/config.hpp>
+
+# if defined( BOOST_NO_STD_WSTRING )
+#   error Configuration not supported: Boost.Filesystem V3 and later requires std::wstring support
+# endif
+
+#include <boost/filesystem/config.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/system/error_code.hpp>
+#include <boost/chrono/system_clocks.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/cstdint.hpp>
+#include <cstddef>
+
+#include <boost/config/abi_prefix.hpp> // must be the last #include
+
+namespace boost
+{
+namespace filesystem
+{
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//                                 struct file_metadata                                 //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+  struct file_metadata
+  {
+    file_status                              status;
+    boost::uintmax_t                         size;             // if is_regular_file(status)
+    boost::chrono::system_clock::time_point  last_write_time;  // if exists(status)
+    boost::uintmax_t                         inode;            // POSIX st_ino, else 0
+  };
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//                                 class status_cache                                   //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+//  A status_cache remembers the status(), file_size() and last_write_time() of the
+//  paths queried through it, all three filled in by one system call, so repeated
+//  queries of the same paths are answered from memory. A path that does not exist is
+//  cached too; other errors are not.
+//
+//  Entries older than ttl are not used. The cache holds about max_entries paths, split
+//  across shards that each have their own lock, and when a shard is full its oldest
+//  entry is discarded. Since the cache cannot observe changes to the file system, call
+//  clear() or invalidate() after changing files that may be cached, or choose a ttl
+//  that bounds staleness. Paths are compared as given, so a file queried through two
+//  different paths is cached twice.
+//
+//  Thread-safe: all member functions may be called concurrently.
+
+  class BOOST_FILESYSTEM_DECL status_cache
+  {
+  public:
+    typedef boost::chrono::steady_clock  clock;
+
+    explicit status_cache(clock::duration ttl, std::size_t max_entries = 4096,
+      std::size_t shards = 16);
+    ~status_cache();
+
+    //  -----  invalidation  -----
+
+    void clear();
+    void invalidate(const path& p);  // p and every cached path below it
+    void erase(const path& p);       // p only
+
+    //  -----  observers  -----
+
+    std::size_t      size() const;
+    std::size_t      max_entries() const  { return m_max_entries; }
+    clock::duration  ttl() const          { return m_ttl; }
+    boost::uintmax_t hits() const;
+    boost::uintmax_t misses() const;
+
+    //  -----  lookup  -----
+
+    //  The metadata of p, from the cache or else from the file system. Reports errors
+    //  as status() does: a p that does not exist yields file_type::not_found and sets
+    //  *ec if ec is not 0; other errors throw filesystem_error if ec is 0.
+    file_metadata lookup(const path& p, system::error_code* ec=0);
+
+  private:
+    struct shard;
+
+    boost::scoped_array<shard>  m_shards;
+    std::size_t                 m_shard_count;
+    std::size_t                 m_max_entries;
+    clock::duration             m_ttl;
+
+    shard& m_shard(const path& p) const;
+
+    status_cache(const status_cache&);             // not copyable
+    status_cache& operator=(const status_cache&);
+  };
+
+  namespace detail
+  {
+    //  status(p, ec), and the size and last write time of the file p resolves to, from
+    //  one stat() or GetFileAttributesExW() call
+    BOOST_FILESYSTEM_DECL
+    file_metadata metadata(const path& p, system::error_code* ec=0);
+    //  as metadata(), but of a symlink itself rather than what it resolves to
+    BOOST_FILESYSTEM_DECL
+    file_metadata symlink_metadata(const path& p, system::error_code* ec=0);
+
+    BOOST_FILESYSTEM_DECL
+    boost::uintmax_t file_size(const path& p, status_cache& cache,
+      system::error_code* ec=0);
+    BOOST_FILESYSTEM_DECL
+    boost::chrono::system_clock::time_point
+      last_write_time_point(const path& p, status_cache& cache, system::error_code* ec=0);
+  }
+
+  //  Query functions using, and adding to, cache
+
+  inline
+  file_status status(const path& p, status_cache& cache)
+                                       {return cache.lookup(p).status;}
+  inline
+  file_status status(const path& p, status_cache& cache, system::error_code& ec)
+                                       {return cache.lookup(p, &ec).status;}
+  inline
+  bool exists(const path& p, status_cache& cache)
+                                       {return exists(cache.lookup(p).status);}
+  inline
+  bool exists(const path& p, status_cache& cache, system::error_code& ec)
+                                       {return exists(cache.lookup(p, &ec).status);}
+  inline
+  bool is_directory(const path& p, status_cache& cache)
+                                       {return is_directory(cache.lookup(p).status);}
+  inline
+  bool is_directory(const path& p, status_cache& cache, system::error_code& ec)
+                                       {return is_directory(cache.lookup(p, &ec).status);}
+  inline
+  bool is_regular_file(const path& p, status_cache& cache)
+                                       {return is_regular_file(cache.lookup(p).status);}
+  inline
+  bool is_regular_file(const path& p, status_cache& cache, system::error_code& ec)
+                                       {return is_regular_file(cache.lookup(p, &ec).status);}
+  inline
+  boost::uintmax_t file_size(const path& p, status_cache& cache)
+                                       {return detail::file_size(p, cache);}
+  inline
+  boost::uintmax_t file_size(const path& p, status_cache& cache, system::error_code& ec)
+                                       {return detail::file_size(p, cache, &ec);}
+
+  inline
+  file_time_type last_write_time(const path& p, status_cache& cache)
+#ifdef BOOST_FILESYSTEM_USE_TIME_T
+    {return boost::chrono::system_clock::to_time_t(
+      detail::last_write_time_point(p, cache));}
+#else
+    {return detail::last_write_time_point(p, cache);}
+#endif
+
+  inline
+  file_time_type last_write_time(const path& p, status_cache& cache,
+                                 system::error_code& ec)
+#ifdef BOOST_FILESYSTEM_USE_TIME_T
+    {return boost::chrono::system_clock::to_time_t(
+      detail::last_write_time_point(p, cache, &ec));}
+#else
+    {return detail::last_write_time_point(p, cache, &ec);}
+#endif
+
+}  // namespace filesystem
+}  // namespace boost
+
+#include <boost/config/abi_suffix.hpp> // pops abi_prefix.hpp pragmas
+
+#endif  // BOOST_FILESYSTEM_STATUS_CACHE_HPP
@@ -0,0 +1,180 @@
+//  boost/filesystem/tree_snapshot.hpp  ------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//--------------------------------------------------------------------------------------//
+
+#ifndef BOOST_FILESYSTEM_TREE_SNAPSHOT_HPP
+#define BOOST_FILESYSTEM_TREE_SNAPSHOT_HPP
+
+#include <boost/config.hpp>
+
+# if defined( BOOST_NO_STD_WSTRING )
+#   error Configuration not supported: Boost.Filesystem V3 and later requires std::wstring support
+# endif
+
+#include <boost/filesystem/config.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/system/error_code.hpp>
+#include <boost/chrono/system_clocks.hpp>
+#include <boost/cstdint.hpp>
+#include <vector>
+#include <cstddef>
+
+#include <boost/config/abi_prefix.hpp> // must be the last #include
+
+namespace boost
+{
+namespace filesystem
+{
+  struct tree_diff;
+  class directory_index;
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//                                 class tree_snapshot                                  //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+//  A tree_snapshot records the type, size, last write time and inode of every entry
+//  below a directory, as found by recursive_directory_iterator, without following
+//  symlinks. Entries are identified by their path relative to the root and kept sorted
+//  with separators ordered before any other character, so each directory is followed
+//  by its contents. The relative paths share one string, so a snapshot costs a few
+//  allocations regardless of the number of entries.
+
+  struct snapshot_entry
+  {
+    boost::filesystem::path                  relative_path;
+    BOOST_SCOPED_ENUM(file_type)             type;
+    boost::uintmax_t                         size;             // of regular files
+    boost::chrono::system_clock::time_point  last_write_time;
+    boost::uintmax_t                         inode;            // POSIX st_ino, else 0
+  };
+
+  class BOOST_FILESYSTEM_DECL tree_snapshot
+  {
+  public:
+    tree_snapshot() {}
+
+    //  Captures the tree below root; throws filesystem_error on error.
+    explicit tree_snapshot(const path& root)  { capture(root); }
+
+    //  Replaces the contents with the tree below root. On error, the snapshot is empty.
+    void capture(const path& root);
+    void capture(const path& root, system::error_code& ec);
+
+    void clear();
+    void swap(tree_snapshot& rhs);
+
+    //  -----  observers  -----
+
+    const boost::filesystem::path& root() const  { return m_root; }
+
+    //  The root's last write time, read before its contents were listed
+    boost::chrono::system_clock::time_point root_last_write_time() const
+                                                { return m_root_time; }
+    std::size_t  size() const                   { return m_entries.size(); }
+    bool         empty() const                  { return m_entries.empty(); }
+
+    snapshot_entry operator[](std::size_t i) const;
+    path relative_path(std::size_t i) const;
+
+    //  Returns: the index of the entry for relative, or size() if there is none
+    std::size_t find(const path& relative) const;
+
+    //  Sets result to the changes from *this to after; see diff()
+    void diff(const tree_snapshot& after, tree_diff& result) const;
+
+  private:
+    friend class directory_index;  // writes m_names and m_entries directly
+
+    struct entry
+    {
+      std::size_t                              name;       // offset in m_names
+      std::size_t                              name_size;
+      BOOST_SCOPED_ENUM(file_type)             type;
+      boost::uintmax_t                         size;
+      boost::chrono::system_clock::time_point  last_write_time;
+      boost::uintmax_t                         inode;
+    };
+
+#   if defined(_MSC_VER)
+#     pragma warning(push) // Save warning settings
+#     pragma warning(disable : 4251) // disable warning: class 'std::vector<_Ty,_Ax>'
+#   endif                            // needs to have dll-interface...
+
+    boost::filesystem::path  m_root;
+    boost::chrono::system_clock::time_point  m_root_time;
+    path::string_type        m_names;    // the relative paths, concatenated
+    std::vector<entry>       m_entries;  // sorted by relative path
+
+#   if defined(_MSC_VER)
+#     pragma warning(pop) // restore warning settings.
+#   endif
+
+    void m_capture(const path& root, system::error_code* ec);
+  };
+
+  inline void swap(tree_snapshot& lhs, tree_snapshot& rhs)  { lhs.swap(rhs); }
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//                                      tree_diff                                       //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+//  The differences between two snapshots, as paths relative to their roots, in
+//  snapshot order. An entry is modified if its type or inode changed, or for
+//  anything other than a directory, its size or last write time; a directory's own
+//  changes are the entries added to and removed from it.
+
+  struct tree_diff
+  {
+    std::vector<path>  added;
+    std::vector<path>  removed;
+    std::vector<path>  modified;
+
+    bool empty() const  { return added.empty() && removed.empty() && modified.empty(); }
+  };
+
+  //  Compares before and after in one merge pass over their sorted entries
+  inline
+  void diff(const tree_snapshot& before, const tree_snapshot& after, tree_diff& result)
+                                       {before.diff(after, result);}
+
+  inline
+  tree_diff diff(const tree_snapshot& before, const tree_snapshot& after)
+  {
+    tree_diff result;
+    diff(before, after, result);
+    return result;
+  }
+
+  //  Compares before with the tree now below before.root()
+  inline
+  tree_diff diff(const tree_snapshot& before)
+  {
+    return diff(before, tree_snapshot(before.root()));
+  }
+
+  inline
+  tree_diff diff(const tree_snapshot& before, system::error_code& ec)
+  {
+    tree_snapshot after;
+    after.capture(before.root(), ec);
+    return ec ? tree_diff() : diff(before, after);
+  }
+
+}  // namespace filesystem
+}  // namespace boost
+
+#include <boost/config/abi_suffix.hpp> // pops abi_prefix.hpp pragmas
+
+#endif  // BOOST_FILESYSTEM_TREE_SNAPSHOT_HPP
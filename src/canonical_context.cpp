@@ -0,0 +1,288 @@
+//  filesystem canonical_context.cpp  --------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//--------------------------------------------------------------------------------------//
+
+// define BOOST_FILESYSTEM_SOURCE so that <boost/filesystem/config.hpp> knows
+// the library is being built (possibly exporting rather than importing code)
+#define BOOST_FILESYSTEM_SOURCE
+
+#ifndef BOOST_SYSTEM_NO_DEPRECATED
+# define BOOST_SYSTEM_NO_DEPRECATED
+#endif
+
+#include <boost/filesystem/canonical_context.hpp>
+#include "path_scan.hpp"
+#include <boost/type_traits/make_unsigned.hpp>
+#include <algorithm>
+
+using boost::filesystem::path;
+using boost::system::error_code;
+using boost::filesystem::detail::is_at_or_below;
+
+namespace
+{
+  inline bool is_separator(path::value_type c)
+  {
+    return c == '/'
+#     ifdef BOOST_WINDOWS_API
+      || c == path::preferred_separator
+#     endif
+      ;
+  }
+
+  //  true if p has a "." or ".." element, or a trailing separator; such paths are left
+  //  to canonical() since their result does not follow from their parent's
+  bool has_dot_element(const path& p)
+  {
+    const path::string_type& s(p.native());
+    std::size_t start = 0;
+    for (std::size_t i = 0; i <= s.size(); ++i)
+    {
+      if (i != s.size() && !is_separator(s[i]))
+        continue;
+      std::size_t n = i - start;
+      if ((n == 1 && s[start] == '.')
+        || (n == 2 && s[start] == '.' && s[start+1] == '.')
+        || (n == 0 && i == s.size() && i != 0 && p.has_relative_path()))
+        return true;
+      start = i + 1;
+    }
+    return false;
+  }
+
+  //  orders indexes into a vector of paths so that separators sort before any other
+  //  character; every directory then sorts immediately before the paths below it,
+  //  and those paths are contiguous
+  class batch_less
+  {
+  public:
+    explicit batch_less(const std::vector<path>& paths) : m_paths(paths) {}
+
+    bool operator()(std::size_t a, std::size_t b) const
+    {
+      const path::string_type& lhs(m_paths[a].native());
+      const path::string_type& rhs(m_paths[b].native());
+      std::size_t n = std::min(lhs.size(), rhs.size());
+      for (std::size_t i = 0; i != n; ++i)
+      {
+        boost::uintmax_t l(key(lhs[i])), r(key(rhs[i]));
+        if (l != r)
+          return l < r;
+      }
+      return lhs.size() < rhs.size();
+    }
+
+  private:
+    const std::vector<path>& m_paths;
+
+    static boost::uintmax_t key(path::value_type c)
+    {
+      typedef boost::make_unsigned<path::value_type>::type unsigned_type;
+      return is_separator(c) ? 0 : static_cast<boost::uintmax_t>(
+        static_cast<unsigned_type>(c)) + 1;
+    }
+  };
+
+  //  resolves absolute paths, visited in batch_less order, keeping the chain of
+  //  directories above the current path so siblings reuse their parent's result
+  class batch_resolver
+  {
+  public:
+    struct resolved
+    {
+      path        source;  // absolute
+      path        result;  // canonical(source), or empty on error
+      error_code  ec;
+    };
+
+    batch_resolver(const path& base, boost::filesystem::canonical_context* ctx)
+      : m_base(base), m_ctx(ctx) {}
+
+    const resolved& resolve(const path& p)
+    {
+      while (!m_stack.empty() && !is_at_or_below(p, m_stack.back().source))
+        m_stack.pop_back();
+      if (!m_stack.empty() && m_stack.back().source.native().size() == p.native().size())
+        return m_stack.back();
+
+      resolved r;
+      r.source = p;
+      path parent(p.parent_path());
+      if (parent.empty() || !p.has_relative_path())
+        r.result = boost::filesystem::detail::canonical(p, m_base, m_ctx, &r.ec);
+      else
+      {
+        resolve(parent);  // now m_stack.back()
+        if (m_stack.back().ec)
+          r.ec = m_stack.back().ec;
+        else
+        {
+          // the parent is canonical, so only the last element can be a symlink
+          r.result = join(m_stack.back().result, p.filename());
+          path target;
+          bool is_link = m_ctx
+            ? m_ctx->lookup_symlink(r.result, target, &r.ec)
+            : is_symlink(boost::filesystem::detail::symlink_status(r.result, &r.ec));
+          if (r.ec || is_link)
+            r.result = boost::filesystem::detail::canonical(r.result, m_base, m_ctx, &r.ec);
+        }
+      }
+      if (r.ec)
+        r.result.clear();
+      m_stack.push_back(r);
+      return m_stack.back();
+    }
+
+  private:
+    path                                    m_base;
+    boost::filesystem::canonical_context*   m_ctx;
+    std::vector<resolved>                   m_stack;  // each element below the one before
+  };
+
+}  // unnamed namespace
+
+namespace boost
+{
+namespace filesystem
+{
+
+  canonical_context::canonical_context(std::size_t max_entries, clock::duration ttl)
+    : m_max_entries(max_entries ? max_entries : 1), m_ttl(ttl),
+      m_hits(0), m_misses(0), m_sequence(0)
+  {}
+
+  void canonical_context::clear()
+  {
+    m_map.clear();
+    m_order.clear();
+  }
+
+  void canonical_context::invalidate(const path& p)
+  {
+    for (map_type::iterator it = m_map.begin(); it != m_map.end();)
+    {
+      if (is_at_or_below(it->first, p))
+        it = m_map.erase(it);
+      else
+        ++it;
+    }
+  }
+
+  void canonical_context::m_make_room()
+  {
+    // discard the oldest entries; m_order elements whose sequence no longer matches
+    // the map were invalidated or replaced and are skipped
+    while (m_map.size() >= m_max_entries && !m_order.empty())
+    {
+      map_type::iterator it(m_map.find(m_order.front().first));
+      if (it != m_map.end() && it->second.sequence == m_order.front().second)
+        m_map.erase(it);
+      m_order.pop_front();
+    }
+
+    // keep stale elements from accumulating without bound
+    if (m_order.size() > 2 * m_max_entries)
+    {
+      std::deque<std::pair<path, boost::uintmax_t> > order;
+      for (std::size_t i = 0; i != m_order.size(); ++i)
+      {
+        map_type::const_iterator it(m_map.find(m_order[i].first));
+        if (it != m_map.end() && it->second.sequence == m_order[i].second)
+          order.push_back(m_order[i]);
+      }
+      m_order.swap(order);
+    }
+  }
+
+  bool canonical_context::lookup_symlink(const path& prefix, path& target,
+    system::error_code* ec)
+  {
+    // the clock is only read if entries can expire
+    const bool expires(m_ttl != clock::duration::max());
+    clock::time_point now;
+    if (expires)
+      now = clock::now();
+
+    map_type::iterator it(m_map.find(prefix));
+    if (it != m_map.end())
+    {
+      if (!expires || now - it->second.inserted <= m_ttl)
+      {
+        ++m_hits;
+        if (ec != 0)
+          ec->clear();
+        if (it->second.is_symlink)
+          target = it->second.target;
+        return it->second.is_symlink;
+      }
+      m_map.erase(it);  // expired
+    }
+
+    ++m_misses;
+    entry e;
+    e.is_symlink = is_symlink(detail::symlink_status(prefix, ec));
+    if (ec != 0 && *ec)
+      return false;
+    if (e.is_symlink)
+    {
+      e.target = detail::read_symlink(prefix, ec);
+      if (ec != 0 && *ec)
+        return false;
+      target = e.target;
+    }
+    e.inserted = now;
+    e.sequence = ++m_sequence;
+
+    m_make_room();
+    m_map[prefix] = e;
+    m_order.push_back(std::make_pair(prefix, e.sequence));
+    return e.is_symlink;
+  }
+
+//--------------------------------------------------------------------------------------//
+//                                  canonical_batch                                     //
+//--------------------------------------------------------------------------------------//
+
+  BOOST_FILESYSTEM_DECL
+  void canonical_batch(const std::vector<path>& paths, const path& base,
+    std::vector<path>& results, std::vector<system::error_code>& errors,
+    canonical_context* ctx)
+  {
+    results.assign(paths.size(), path());
+    errors.assign(paths.size(), error_code());
+
+    std::vector<path> sources;
+    sources.reserve(paths.size());
+    std::vector<std::size_t> order;
+    order.reserve(paths.size());
+    for (std::size_t i = 0; i != paths.size(); ++i)
+    {
+      sources.push_back(paths[i].is_absolute() ? paths[i] : absolute(paths[i], base));
+      order.push_back(i);
+    }
+    std::sort(order.begin(), order.end(), batch_less(sources));
+
+    batch_resolver resolver(base, ctx);
+    for (std::size_t i = 0; i != order.size(); ++i)
+    {
+      std::size_t k = order[i];
+      if (has_dot_element(sources[k]))
+        results[k] = detail::canonical(sources[k], base, ctx, &errors[k]);
+      else
+      {
+        const batch_resolver::resolved& r(resolver.resolve(sources[k]));
+        results[k] = r.result;
+        errors[k] = r.ec;
+      }
+    }
+  }
+
+}  // namespace filesystem
+}  // namespace boost
@@ -0,0 +1,551 @@
+//  filesystem directory_index.cpp  ----------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//--------------------------------------------------------------------------------------//
+
+// define BOOST_FILESYSTEM_SOURCE so that <boost/filesystem/config.hpp> knows
+// the library is being built (possibly exporting rather than importing code)
+#define BOOST_FILESYSTEM_SOURCE
+
+#ifndef BOOST_SYSTEM_NO_DEPRECATED
+# define BOOST_SYSTEM_NO_DEPRECATED
+#endif
+
+#include <boost/filesystem/directory_index.hpp>
+#include <boost/filesystem/status_cache.hpp>  // for detail::metadata
+#include <boost/filesystem/fstream.hpp>
+#include "error_report.hpp"
+#include "path_scan.hpp"
+#include <cstring>
+
+using boost::filesystem::path;
+using boost::filesystem::directory_index;
+using boost::system::error_code;
+using boost::filesystem::detail::compare_tree_order;
+using boost::filesystem::detail::report;
+namespace chrono = boost::chrono;
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  File format, in the byte order of the writer:                                       //
+//                                                                                      //
+//    index_header                                                                      //
+//    one column per field, count entries each                                          //
+//    the relative paths, concatenated in entry order (path::value_type)                //
+//    the root path (path::value_type)                                                  //
+//                                                                                      //
+//  Each section starts on an 8 byte boundary, so the mapped columns are aligned.       //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+namespace
+{
+  const char format_magic[8] = {'B', 'F', 'S', 'I', 'N', 'D', 'E', 'X'};
+  const boost::uint32_t format_version = 1;
+  const boost::uint32_t byte_order_mark = 0x01020304;
+  const boost::uint64_t no_parent = ~boost::uint64_t(0);
+
+  enum column
+  {
+    name_column,         // uint64_t offset in the name table
+    name_size_column,    // uint32_t
+    type_column,         // uint32_t file_type
+    parent_column,       // uint64_t entry index, or no_parent
+    subtree_end_column,  // uint64_t entry index
+    size_column,         // uint64_t
+    mtime_column,        // int64_t nanoseconds since the epoch
+    inode_column,        // uint64_t
+    column_count
+  };
+
+  const std::size_t column_width[column_count] = {8, 4, 4, 8, 8, 8, 8, 8};
+
+  struct index_header
+  {
+    char             magic[8];
+    boost::uint32_t  version;
+    boost::uint32_t  byte_order;       // byte_order_mark, as written
+    boost::uint32_t  char_size;        // sizeof(path::value_type)
+    boost::uint32_t  reserved;
+    boost::uint64_t  file_size;
+    boost::uint64_t  count;
+    boost::int64_t   root_time;
+    boost::uint64_t  root;             // offset of the root path
+    boost::uint64_t  root_size;        // in path::value_type units
+    boost::uint64_t  names;            // offset of the name table
+    boost::uint64_t  names_size;       // in path::value_type units
+    boost::uint64_t  columns[column_count];  // offsets
+  };
+
+  boost::uint64_t align(boost::uint64_t offset)
+  {
+    return (offset + 7) & ~boost::uint64_t(7);
+  }
+
+  //  sets the offsets and file_size of h from its count, names_size and root_size
+  void layout(index_header& h)
+  {
+    boost::uint64_t offset = align(sizeof(index_header));
+    for (int c = 0; c != column_count; ++c)
+    {
+      h.columns[c] = offset;
+      offset = align(offset + h.count * column_width[c]);
+    }
+    h.names = offset;
+    offset = align(offset + h.names_size * sizeof(path::value_type));
+    h.root = offset;
+    h.file_size = offset + h.root_size * sizeof(path::value_type);
+  }
+
+  boost::int64_t to_nanoseconds(chrono::system_clock::time_point t)
+  {
+    return chrono::duration_cast<chrono::nanoseconds>(t.time_since_epoch()).count();
+  }
+
+  chrono::system_clock::time_point from_nanoseconds(boost::int64_t ns)
+  {
+    return chrono::system_clock::time_point(
+      chrono::duration_cast<chrono::system_clock::duration>(chrono::nanoseconds(ns)));
+  }
+
+  inline bool is_separator(path::value_type c)
+  {
+    return c == '/'
+#     ifdef BOOST_WINDOWS_API
+      || c == '\\'
+#     endif
+      ;
+  }
+
+  //  Returns: true if p is a directory last written at ns, false if it is not or does
+  //  not exist. Other errors set ec.
+  bool unchanged(const path& p, bool follow, boost::int64_t ns, error_code& ec)
+  {
+    using boost::filesystem::file_type;
+    boost::filesystem::file_metadata md(follow
+      ? boost::filesystem::detail::metadata(p, &ec)
+      : boost::filesystem::detail::symlink_metadata(p, &ec));
+    if (ec)
+    {
+      if (md.status.type() == file_type::not_found)
+        ec.clear();
+      return false;
+    }
+    return md.status.type() == file_type::directory
+      && to_nanoseconds(md.last_write_time) == ns;
+  }
+
+  template <class T>
+  void put(std::ostream& os, T value)
+  {
+    os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void pad_to(std::ostream& os, boost::uint64_t offset, boost::uint64_t& position)
+  {
+    static const char zeros[8] = {0};
+    os.write(zeros, static_cast<std::streamsize>(offset - position));
+    position = offset;
+  }
+
+}  // unnamed namespace
+
+namespace boost
+{
+namespace filesystem
+{
+
+  const std::size_t directory_index::npos;
+
+  void directory_index::m_init()
+  {
+    m_count = 0;
+    m_root_time = chrono::system_clock::time_point();
+    m_names = 0;
+    m_names_size = 0;
+    m_name = m_parent = m_subtree_end = m_file_size = m_inode = 0;
+    m_name_size = m_type = 0;
+    m_mtime = 0;
+  }
+
+  //  -----  writing  -----
+
+  void directory_index::write(const tree_snapshot& snapshot, const path& index_file)
+  {
+    m_write(snapshot, index_file, 0);
+  }
+
+  void directory_index::write(const tree_snapshot& snapshot, const path& index_file,
+    system::error_code& ec)
+  {
+    m_write(snapshot, index_file, &ec);
+  }
+
+  void directory_index::m_write(const tree_snapshot& snapshot, const path& index_file,
+    system::error_code* ec)
+  {
+    typedef tree_snapshot::entry entry;
+    const std::vector<entry>& entries(snapshot.m_entries);
+    const path::value_type* names(snapshot.m_names.c_str());
+    const std::size_t count = entries.size();
+
+    // parent and subtree_end: the directories enclosing the current entry form a
+    // stack, since each is followed by everything below it
+    std::vector<boost::uint64_t> parent(count), subtree_end(count);
+    std::vector<std::size_t> open_dirs;
+    for (std::size_t i = 0; i != count; ++i)
+    {
+      const entry& e(entries[i]);
+      while (!open_dirs.empty())
+      {
+        const entry& d(entries[open_dirs.back()]);
+        if (e.name_size > d.name_size
+          && std::char_traits<path::value_type>::compare(names + e.name, names + d.name,
+            d.name_size) == 0
+          && is_separator(names[e.name + d.name_size]))
+          break;
+        subtree_end[open_dirs.back()] = i;
+        open_dirs.pop_back();
+      }
+      parent[i] = open_dirs.empty() ? no_parent : open_dirs.back();
+      subtree_end[i] = i + 1;
+      if (e.type == file_type::directory)
+        open_dirs.push_back(i);
+    }
+    for (; !open_dirs.empty(); open_dirs.pop_back())
+      subtree_end[open_dirs.back()] = count;
+
+    index_header h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, format_magic, sizeof(h.magic));
+    h.version = format_version;
+    h.byte_order = byte_order_mark;
+    h.char_size = sizeof(path::value_type);
+    h.count = count;
+    h.root_time = to_nanoseconds(snapshot.m_root_time);
+    h.root_size = snapshot.m_root.native().size();
+    h.names_size = snapshot.m_names.size();
+    layout(h);
+
+    // written under a temporary name, then renamed over index_file
+    atomic_ofstream os(index_file);
+    if (!os.is_open())
+    {
+      report(os.rdbuf()->error(), index_file, ec,
+        "boost::filesystem::directory_index::write");
+      return;
+    }
+
+    boost::uint64_t position = sizeof(h);
+    os.write(reinterpret_cast<const char*>(&h), sizeof(h));
+
+    pad_to(os, h.columns[name_column], position);
+    boost::uint64_t name_offset = 0;
+    for (std::size_t i = 0; i != count; ++i)
+    {
+      put<boost::uint64_t>(os, name_offset);
+      name_offset += entries[i].name_size;
+    }
+    position += count * column_width[name_column];
+
+    pad_to(os, h.columns[name_size_column], position);
+    for (std::size_t i = 0; i != count; ++i)
+      put<boost::uint32_t>(os, static_cast<boost::uint32_t>(entries[i].name_size));
+    position += count * column_width[name_size_column];
+
+    pad_to(os, h.columns[type_column], position);
+    for (std::size_t i = 0; i != count; ++i)
+      put<boost::uint32_t>(os, static_cast<boost::uint32_t>(entries[i].type));
+    position += count * column_width[type_column];
+
+    pad_to(os, h.columns[parent_column], position);
+    for (std::size_t i = 0; i != count; ++i)
+      put<boost::uint64_t>(os, parent[i]);
+    position += count * column_width[parent_column];
+
+    pad_to(os, h.columns[subtree_end_column], position);
+    for (std::size_t i = 0; i != count; ++i)
+      put<boost::uint64_t>(os, subtree_end[i]);
+    position += count * column_width[subtree_end_column];
+
+    pad_to(os, h.columns[size_column], position);
+    for (std::size_t i = 0; i != count; ++i)
+      put<boost::uint64_t>(os, entries[i].size);
+    position += count * column_width[size_column];
+
+    pad_to(os, h.columns[mtime_column], position);
+    for (std::size_t i = 0; i != count; ++i)
+      put<boost::int64_t>(os, to_nanoseconds(entries[i].last_write_time));
+    position += count * column_width[mtime_column];
+
+    pad_to(os, h.columns[inode_column], position);
+    for (std::size_t i = 0; i != count; ++i)
+      put<boost::uint64_t>(os, entries[i].inode);
+    position += count * column_width[inode_column];
+
+    pad_to(os, h.names, position);
+    for (std::size_t i = 0; i != count; ++i)
+      os.write(reinterpret_cast<const char*>(names + entries[i].name),
+        static_cast<std::streamsize>(entries[i].name_size * sizeof(path::value_type)));
+    position += h.names_size * sizeof(path::value_type);
+
+    pad_to(os, h.root, position);
+    os.write(reinterpret_cast<const char*>(snapshot.m_root.c_str()),
+      static_cast<std::streamsize>(h.root_size * sizeof(path::value_type)));
+
+    error_code local_ec;
+    if (!os)
+    {
+      local_ec = os.rdbuf()->error();
+      if (!local_ec)
+        local_ec = system::errc::make_error_code(system::errc::io_error);
+      os.discard();
+    }
+    else  // the contents reach the storage device before the rename replaces the index
+      os.commit(commit_options::durable, local_ec);
+    if (local_ec)
+    {
+      report(local_ec, index_file, ec, "boost::filesystem::directory_index::write");
+      return;
+    }
+    if (ec != 0)
+      ec->clear();
+  }
+
+  //  -----  reading  -----
+
+  void directory_index::open(const path& index_file)
+  {
+    m_open(index_file, 0);
+  }
+
+  void directory_index::open(const path& index_file, system::error_code& ec)
+  {
+    m_open(index_file, &ec);
+  }
+
+  void directory_index::close()
+  {
+    m_file.close();
+    m_root.clear();
+    m_index_file.clear();
+    m_init();
+  }
+
+  void directory_index::m_open(const path& index_file, system::error_code* ec)
+  {
+    close();
+
+    error_code local_ec;
+    m_file.open(index_file, map_mode::read_only, map_options::none, local_ec);
+    if (local_ec)
+    {
+      report(local_ec, index_file, ec, "boost::filesystem::directory_index::open");
+      return;
+    }
+    // lookups are binary searches, so reading ahead would mostly be wasted
+    m_file.advise(map_advice::random, local_ec);
+    const char* data = m_file.const_data();
+    const std::size_t size = m_file.size();
+
+    // check the header, so that every column lies within the file; the entries are
+    // checked as they are read, so opening does not read every page of the index
+    index_header h;
+    bool valid = size >= sizeof(h);
+    if (valid)
+    {
+      std::memcpy(&h, data, sizeof(h));
+      valid = std::memcmp(h.magic, format_magic, sizeof(h.magic)) == 0
+        && h.version == format_version
+        && h.byte_order == byte_order_mark
+        && h.char_size == sizeof(path::value_type)
+        && h.file_size == size
+        && h.count <= size / 8 && h.names_size <= size && h.root_size <= size;
+    }
+    if (valid)
+    {
+      index_header expected(h);
+      layout(expected);
+      valid = std::memcmp(&expected, &h, sizeof(h)) == 0;
+    }
+
+    if (valid)
+    {
+      m_count = static_cast<std::size_t>(h.count);
+      m_names = reinterpret_cast<const path::value_type*>(data + h.names);
+      m_name = reinterpret_cast<const boost::uint64_t*>(data + h.columns[name_column]);
+      m_name_size
+        = reinterpret_cast<const boost::uint32_t*>(data + h.columns[name_size_column]);
+      m_type = reinterpret_cast<const boost::uint32_t*>(data + h.columns[type_column]);
+      m_parent
+        = reinterpret_cast<const boost::uint64_t*>(data + h.columns[parent_column]);
+      m_subtree_end
+        = reinterpret_cast<const boost::uint64_t*>(data + h.columns[subtree_end_column]);
+      m_file_size
+        = reinterpret_cast<const boost::uint64_t*>(data + h.columns[size_column]);
+      m_mtime = reinterpret_cast<const boost::int64_t*>(data + h.columns[mtime_column]);
+      m_inode = reinterpret_cast<const boost::uint64_t*>(data + h.columns[inode_column]);
+      m_names_size = h.names_size;
+    }
+
+    if (!valid)
+    {
+      m_file.close();
+      m_init();
+      report(system::errc::make_error_code(system::errc::bad_message), index_file, ec,
+        "boost::filesystem::directory_index::open");
+      return;
+    }
+
+    const path::value_type* root(reinterpret_cast<const path::value_type*>(data + h.root));
+    m_root = path(root, root + h.root_size);
+    m_root_time = from_nanoseconds(h.root_time);
+    m_index_file = index_file;
+    if (ec != 0)
+      ec->clear();
+  }
+
+  //  -----  entries  -----
+
+  //  Each accessor checks the stored values it reads that would otherwise send a
+  //  caller out of bounds, which costs a compare or two against data already loaded
+
+  void directory_index::m_damaged() const
+  {
+    BOOST_FILESYSTEM_THROW(filesystem_error("boost::filesystem::directory_index",
+      m_index_file, system::errc::make_error_code(system::errc::bad_message)));
+  }
+
+  const path::value_type* directory_index::m_name_at(std::size_t i) const
+  {
+    if (m_name[i] > m_names_size || m_name_size[i] > m_names_size - m_name[i])
+      m_damaged();
+    return m_names + m_name[i];
+  }
+
+  snapshot_entry directory_index::operator[](std::size_t i) const
+  {
+    snapshot_entry result;
+    result.relative_path = relative_path(i);
+    result.type = type(i);
+    result.size = file_size(i);
+    result.last_write_time = last_write_time(i);
+    result.inode = inode(i);
+    return result;
+  }
+
+  path directory_index::relative_path(std::size_t i) const
+  {
+    const path::value_type* name(m_name_at(i));
+    return path(name, name + m_name_size[i]);
+  }
+
+  BOOST_SCOPED_ENUM(file_type) directory_index::type(std::size_t i) const
+  {
+    if (m_type[i] > static_cast<boost::uint32_t>(file_type::reparse_point))
+      m_damaged();
+    return static_cast<BOOST_SCOPED_ENUM(file_type)>(m_type[i]);
+  }
+
+  chrono::system_clock::time_point directory_index::last_write_time(std::size_t i) const
+  {
+    return from_nanoseconds(m_mtime[i]);
+  }
+
+  std::size_t directory_index::parent(std::size_t i) const
+  {
+    if (m_parent[i] == no_parent)
+      return npos;
+    if (m_parent[i] >= i)  // a directory precedes its contents
+      m_damaged();
+    return static_cast<std::size_t>(m_parent[i]);
+  }
+
+  std::size_t directory_index::subtree_end(std::size_t i) const
+  {
+    if (m_subtree_end[i] <= i || m_subtree_end[i] > m_count)
+      m_damaged();
+    return static_cast<std::size_t>(m_subtree_end[i]);
+  }
+
+  std::size_t directory_index::find(const path& relative) const
+  {
+    const path::string_type& s(relative.native());
+    std::size_t lo = 0, hi = m_count;
+    while (lo < hi)
+    {
+      std::size_t mid = lo + (hi - lo) / 2;
+      int cmp = compare_tree_order(m_name_at(mid), m_name_size[mid],
+        s.c_str(), s.size());
+      if (cmp == 0)
+        return mid;
+      if (cmp < 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return m_count;
+  }
+
+  std::pair<std::size_t, std::size_t> directory_index::below(const path& relative) const
+  {
+    if (relative.empty())
+      return std::make_pair(std::size_t(0), m_count);
+    std::size_t i = find(relative);
+    if (i == m_count || type(i) != file_type::directory)
+      return std::make_pair(m_count, m_count);
+    return std::make_pair(i + 1, subtree_end(i));
+  }
+
+  bool directory_index::is_current(std::vector<path>* stale) const
+  {
+    return m_is_current(stale, 0);
+  }
+
+  bool directory_index::is_current(std::vector<path>* stale, system::error_code& ec) const
+  {
+    return m_is_current(stale, &ec);
+  }
+
+  bool directory_index::m_is_current(std::vector<path>* stale,
+    system::error_code* ec) const
+  {
+    // the root's time was read following symlinks, as capture() lists it; those of
+    // the directories below it were read from the directories themselves
+    error_code local_ec;
+    path p(m_root);
+    bool current = unchanged(p, true, to_nanoseconds(m_root_time), local_ec);
+    if (!current && !local_ec && stale != 0)
+      stale->push_back(path());
+
+    for (std::size_t i = 0; !local_ec && (current || stale != 0) && i != m_count; ++i)
+    {
+      if (type(i) != file_type::directory)
+        continue;
+      p = m_root / relative_path(i);
+      if (!unchanged(p, false, m_mtime[i], local_ec) && !local_ec)
+      {
+        current = false;
+        if (stale != 0)
+          stale->push_back(relative_path(i));
+      }
+    }
+
+    if (local_ec)
+    {
+      report(local_ec, p, ec, "boost::filesystem::directory_index::is_current");
+      return false;
+    }
+    if (ec != 0)
+      ec->clear();
+    return current;
+  }
+
+}  // namespace filesystem
+}  // namespace boost
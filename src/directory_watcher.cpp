@@ -0,0 +1,497 @@
+//  filesystem directory_watcher.cpp  --------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//--------------------------------------------------------------------------------------//
+
+// define BOOST_FILESYSTEM_SOURCE so that <boost/filesystem/config.hpp> knows
+// the library is being built (possibly exporting rather than importing code)
+#define BOOST_FILESYSTEM_SOURCE
+
+#ifndef BOOST_SYSTEM_NO_DEPRECATED
+# define BOOST_SYSTEM_NO_DEPRECATED
+#endif
+
+#include <boost/filesystem/directory_watcher.hpp>
+#include <boost/filesystem/status_cache.hpp>
+#include "error_report.hpp"
+#include "path_scan.hpp"
+#include <boost/system/system_error.hpp>
+#include <climits>
+#include <cerrno>
+
+#ifdef BOOST_FILESYSTEM_HAS_DIRECTORY_WATCHER
+# include <sys/inotify.h>
+# include <poll.h>
+# include <unistd.h>
+#endif
+
+using boost::filesystem::path;
+using boost::filesystem::directory_watcher;
+using boost::filesystem::watch_event;
+using boost::filesystem::change_kind;
+using boost::system::error_code;
+using boost::system::system_category;
+using boost::filesystem::detail::report;
+
+namespace
+{
+#ifdef BOOST_FILESYSTEM_HAS_DIRECTORY_WATCHER
+
+  const boost::uint32_t watch_mask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB
+    | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR
+#   ifdef IN_EXCL_UNLINK
+    | IN_EXCL_UNLINK  // no events for files already unlinked but still open
+#   endif
+    ;
+
+  //  room for many events per read(); each is at most sizeof(inotify_event)+NAME_MAX+1
+  const std::size_t buffer_size = 64 * 1024;
+
+  watch_event make_event(BOOST_SCOPED_ENUM(change_kind) kind, const path& p,
+    bool is_directory)
+  {
+    watch_event e;
+    e.kind = kind;
+    e.path = p;
+    e.is_directory = is_directory;
+    return e;
+  }
+
+  //  the first error met by read(); it is reported once all pending events are decoded
+  struct first_error
+  {
+    error_code  code;
+    path        p;
+
+    void note(const error_code& e, const path& at)
+    {
+      if (e && !code)
+      {
+        code = e;
+        p = at;
+      }
+    }
+  };
+
+  //  p with its leading old_prefix replaced by new_prefix
+  path reprefix(const path& p, const path& old_prefix, const path& new_prefix)
+  {
+    return path(new_prefix.native() + p.native().substr(old_prefix.native().size()));
+  }
+
+#endif
+
+}  // unnamed namespace
+
+namespace boost
+{
+namespace filesystem
+{
+
+  directory_watcher::directory_watcher() : m_fd(-1), m_cache(0)
+  {
+    m_open(0);
+  }
+
+  directory_watcher::directory_watcher(system::error_code& ec) : m_fd(-1), m_cache(0)
+  {
+    m_open(&ec);
+  }
+
+  directory_watcher::~directory_watcher()
+  {
+#   ifdef BOOST_FILESYSTEM_HAS_DIRECTORY_WATCHER
+    if (m_fd != -1)
+      ::close(m_fd);
+#   endif
+  }
+
+  void directory_watcher::add(const path& dir, bool recursive)
+  {
+    m_add(dir, recursive, true, 0, 0);
+  }
+
+  void directory_watcher::add(const path& dir, bool recursive, system::error_code& ec)
+  {
+    ec.clear();
+    m_add(dir, recursive, true, 0, &ec);
+  }
+
+  void directory_watcher::remove(const path& dir)
+  {
+    m_remove(dir, 0);
+  }
+
+  void directory_watcher::remove(const path& dir, system::error_code& ec)
+  {
+    ec.clear();
+    m_remove(dir, &ec);
+  }
+
+  std::size_t directory_watcher::read(std::vector<watch_event>& events,
+    boost::chrono::milliseconds timeout)
+  {
+    return m_read(events, timeout, 0);
+  }
+
+  std::size_t directory_watcher::read(std::vector<watch_event>& events,
+    boost::chrono::milliseconds timeout, system::error_code& ec)
+  {
+    ec.clear();
+    return m_read(events, timeout, &ec);
+  }
+
+  void directory_watcher::m_invalidate(const watch_event& e)
+  {
+    if (m_cache == 0)
+      return;
+    switch (e.kind)
+    {
+    case change_kind::overflow:
+      m_cache->clear();
+      break;
+    case change_kind::modified:
+      m_cache->erase(e.path);
+      break;
+    case change_kind::renamed:
+      m_cache->invalidate(e.old_path);
+      m_cache->erase(e.old_path.parent_path());
+      // fall through
+    default:  // created, removed: the parent directory changed too
+      m_cache->invalidate(e.path);
+      m_cache->erase(e.path.parent_path());
+      break;
+    }
+  }
+
+#ifdef BOOST_FILESYSTEM_HAS_DIRECTORY_WATCHER
+
+  void directory_watcher::m_open(system::error_code* ec)
+  {
+    m_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd == -1)
+    {
+      report(errno, path(), ec, "boost::filesystem::directory_watcher");
+      return;
+    }
+    m_buffer.resize(buffer_size);
+    if (ec != 0)
+      ec->clear();
+  }
+
+  //  Watch dir and, if recursive, every directory below it. If existing is not 0, the
+  //  contents found while adding recursively are appended to it as created events.
+  void directory_watcher::m_add(const path& dir, bool recursive, bool root,
+    std::vector<watch_event>* existing, system::error_code* ec)
+  {
+    if (m_fd == -1)
+    {
+      report(EBADF, dir, ec, "boost::filesystem::directory_watcher::add");
+      return;
+    }
+
+    // symlinks are followed only for the directories passed to add(), as
+    // recursive_directory_iterator does by default
+    int wd = ::inotify_add_watch(m_fd, dir.c_str(),
+      watch_mask | (root ? 0 : IN_DONT_FOLLOW));
+    if (wd == -1)
+    {
+      int errval = errno;
+      // a subdirectory removed before it could be watched is not an error; its
+      // removal is reported by the watch on its parent
+      if (!root && (errval == ENOENT || errval == ENOTDIR))
+        return;
+      report(errval, dir, ec, "boost::filesystem::directory_watcher::add");
+      return;
+    }
+
+    // inotify returns the existing descriptor if dir is already watched
+    watch_map::iterator it(m_watches.find(wd));
+    if (it == m_watches.end())
+    {
+      watch w;
+      w.dir = dir;
+      w.recursive = recursive;
+      w.root = root;
+      m_watches[wd] = w;
+    }
+    else
+    {
+      it->second.dir = dir;
+      it->second.recursive = it->second.recursive || recursive;
+      it->second.root = it->second.root || root;
+    }
+
+    if (!recursive)
+      return;
+
+    system::error_code local_ec;
+    for (directory_iterator itr(dir, local_ec), end; !local_ec && itr != end;
+      itr.increment(local_ec))
+    {
+      system::error_code status_ec;
+      bool is_dir = is_directory(itr->symlink_status(status_ec));
+      if (existing)
+        existing->push_back(make_event(change_kind::created, itr->path(), is_dir));
+      if (is_dir)
+      {
+        m_add(itr->path(), true, false, existing, ec);
+        if (ec != 0 && *ec)
+          return;
+      }
+    }
+
+    // as for inotify_add_watch(), a directory that vanished is not an error
+    if (local_ec && local_ec.value() != ENOENT && local_ec.value() != ENOTDIR)
+      report(local_ec.value(), dir, ec, "boost::filesystem::directory_watcher::add");
+  }
+
+  void directory_watcher::m_remove(const path& dir, system::error_code* ec)
+  {
+    bool recursive = false;
+    bool found = false;
+    for (watch_map::iterator it = m_watches.begin(); it != m_watches.end(); ++it)
+    {
+      if (path_equal_to()(it->second.dir, dir))
+      {
+        found = true;
+        recursive = it->second.recursive;
+        break;
+      }
+    }
+    if (!found)
+    {
+      report(EINVAL, dir, ec, "boost::filesystem::directory_watcher::remove");
+      return;
+    }
+
+    for (watch_map::iterator it = m_watches.begin(); it != m_watches.end();)
+    {
+      if (recursive ? detail::is_at_or_below(it->second.dir, dir)
+                    : path_equal_to()(it->second.dir, dir))
+      {
+        ::inotify_rm_watch(m_fd, it->first);
+        it = m_watches.erase(it);
+      }
+      else
+        ++it;
+    }
+  }
+
+  std::size_t directory_watcher::m_read(std::vector<watch_event>& events,
+    boost::chrono::milliseconds timeout, system::error_code* ec)
+  {
+    if (m_fd == -1)
+    {
+      report(EBADF, path(), ec, "boost::filesystem::directory_watcher::read");
+      return 0;
+    }
+
+    struct pollfd pfd;
+    pfd.fd = m_fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    int ms = timeout.count() < 0 ? -1
+      : timeout.count() > INT_MAX ? INT_MAX : static_cast<int>(timeout.count());
+    int ready;
+    while ((ready = ::poll(&pfd, 1, ms)) == -1 && errno == EINTR) {}
+    if (ready == -1)
+    {
+      report(errno, path(), ec, "boost::filesystem::directory_watcher::read");
+      return 0;
+    }
+
+    const std::size_t first = events.size();
+
+    // IN_MOVED_FROM events waiting for the IN_MOVED_TO with the same cookie; the
+    // kernel queues the pair together, so an unmatched one left after the queue is
+    // drained was a move out of the watched directories
+    boost::unordered_map<boost::uint32_t, std::size_t> moves;  // cookie, event index
+
+    // a directory that cannot be watched does not stop the rest of the queue from
+    // being decoded, since events left in m_buffer would otherwise be lost
+    first_error failure;
+
+    while (ready > 0)
+    {
+      ssize_t n = ::read(m_fd, &m_buffer[0], m_buffer.size());
+      if (n == -1)
+      {
+        if (errno == EINTR)
+          continue;
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+          failure.note(error_code(errno, system_category()), path());
+        break;
+      }
+
+      for (const char* p = &m_buffer[0]; p < &m_buffer[0] + n;)
+      {
+        const struct inotify_event* ev = reinterpret_cast<const struct inotify_event*>(p);
+        p += sizeof(struct inotify_event) + ev->len;
+
+        if (ev->mask & IN_Q_OVERFLOW)
+        {
+          events.push_back(make_event(change_kind::overflow, path(), false));
+          continue;
+        }
+
+        watch_map::iterator it(m_watches.find(ev->wd));
+        if (it == m_watches.end())
+          continue;  // from a watch already removed
+        if (ev->mask & IN_IGNORED)
+        {
+          m_watches.erase(it);
+          continue;
+        }
+
+        // a directory's own deletion or move is reported by its parent's watch, so
+        // is only reported here for the directories passed to add()
+        if (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+        {
+          if (it->second.root)
+          {
+            events.push_back(make_event(change_kind::removed, it->second.dir, true));
+            if (ev->mask & IN_MOVE_SELF)  // the watch would follow it elsewhere
+            {
+              ::inotify_rm_watch(m_fd, ev->wd);
+              m_watches.erase(it);
+            }
+          }
+          continue;
+        }
+
+        const bool is_dir = (ev->mask & IN_ISDIR) != 0;
+        const bool recursive = it->second.recursive;
+        path entry(ev->len ? it->second.dir / ev->name : it->second.dir);
+
+        if (ev->mask & IN_CREATE)
+        {
+          events.push_back(make_event(change_kind::created, entry, is_dir));
+          if (is_dir && recursive)
+          {
+            system::error_code add_ec;
+            m_add(entry, true, false, &events, &add_ec);
+            failure.note(add_ec, entry);
+          }
+        }
+        else if (ev->mask & IN_DELETE)
+          events.push_back(make_event(change_kind::removed, entry, is_dir));
+        else if (ev->mask & (IN_MODIFY | IN_ATTRIB))
+          events.push_back(make_event(change_kind::modified, entry, is_dir));
+        else if (ev->mask & IN_MOVED_FROM)
+        {
+          moves[ev->cookie] = events.size();
+          events.push_back(make_event(change_kind::removed, entry, is_dir));
+        }
+        else if (ev->mask & IN_MOVED_TO)
+        {
+          boost::unordered_map<boost::uint32_t, std::size_t>::iterator
+            from(moves.find(ev->cookie));
+          if (from == moves.end())
+          {
+            events.push_back(make_event(change_kind::created, entry, is_dir));
+            if (is_dir && recursive)
+            {
+              system::error_code add_ec;
+              m_add(entry, true, false, &events, &add_ec);
+              failure.note(add_ec, entry);
+            }
+            continue;
+          }
+
+          // turn the pending removal into the rename, keeping its place in order
+          watch_event& e(events[from->second]);
+          e.kind = change_kind::renamed;
+          e.old_path = e.path;
+          e.path = entry;
+          moves.erase(from);
+
+          if (is_dir)
+          {
+            // the watches below it remain valid, under the new name
+            bool watched = false;
+            for (watch_map::iterator w = m_watches.begin(); w != m_watches.end(); ++w)
+            {
+              if (detail::is_at_or_below(w->second.dir, e.old_path))
+              {
+                w->second.dir = reprefix(w->second.dir, e.old_path, entry);
+                watched = true;
+              }
+            }
+            if (!watched && recursive)
+            {
+              system::error_code add_ec;
+              m_add(entry, true, false, 0, &add_ec);
+              failure.note(add_ec, entry);
+            }
+          }
+        }
+      }
+    }
+
+    // moves out of the watched directories; stop watching any directory moved out
+    for (boost::unordered_map<boost::uint32_t, std::size_t>::iterator it = moves.begin();
+      it != moves.end(); ++it)
+    {
+      const watch_event& e(events[it->second]);
+      if (!e.is_directory)
+        continue;
+      for (watch_map::iterator w = m_watches.begin(); w != m_watches.end();)
+      {
+        if (detail::is_at_or_below(w->second.dir, e.path))
+        {
+          ::inotify_rm_watch(m_fd, w->first);
+          w = m_watches.erase(w);
+        }
+        else
+          ++w;
+      }
+    }
+
+    // events appended are kept, and invalidated, even if an error is then reported
+    for (std::size_t i = first; i != events.size(); ++i)
+      m_invalidate(events[i]);
+    if (failure.code)
+      report(failure.code, failure.p, ec, "boost::filesystem::directory_watcher::read");
+    return events.size() - first;
+  }
+
+#else  // no inotify
+
+  void directory_watcher::m_open(system::error_code* ec)
+  {
+    report(system::errc::make_error_code(system::errc::not_supported), path(), ec,
+      "boost::filesystem::directory_watcher");
+  }
+
+  void directory_watcher::m_add(const path& dir, bool, bool,
+    std::vector<watch_event>*, system::error_code* ec)
+  {
+    report(system::errc::make_error_code(system::errc::not_supported), dir, ec,
+      "boost::filesystem::directory_watcher::add");
+  }
+
+  void directory_watcher::m_remove(const path& dir, system::error_code* ec)
+  {
+    report(system::errc::make_error_code(system::errc::not_supported), dir, ec,
+      "boost::filesystem::directory_watcher::remove");
+  }
+
+  std::size_t directory_watcher::m_read(std::vector<watch_event>&,
+    boost::chrono::milliseconds, system::error_code* ec)
+  {
+    report(system::errc::make_error_code(system::errc::not_supported), path(), ec,
+      "boost::filesystem::directory_watcher::read");
+    return 0;
+  }
+
+#endif
+
+}  // namespace filesystem
+}  // namespace boost
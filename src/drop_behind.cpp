@@ -0,0 +1,101 @@
+//  filesystem drop_behind.cpp  --------------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+// define BOOST_FILESYSTEM_SOURCE so that <boost/filesystem/config.hpp> knows
+// the library is being built (possibly exporting rather than importing code)
+#define BOOST_FILESYSTEM_SOURCE
+
+#ifndef BOOST_SYSTEM_NO_DEPRECATED
+# define BOOST_SYSTEM_NO_DEPRECATED
+#endif
+
+#include "drop_behind.hpp"
+
+#ifdef BOOST_POSIX_API
+
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+//  sync_file_range() starts and waits for writeback of part of a file; elsewhere
+//  written pages are dropped only if the kernel has already written them back.
+#if defined(__linux__) && defined(SYNC_FILE_RANGE_WRITE)
+# define BOOST_FILESYSTEM_SYNC_FILE_RANGE
+#endif
+#if defined(_POSIX_ADVISORY_INFO) && _POSIX_ADVISORY_INFO > 0
+# define BOOST_FILESYSTEM_FADVISE
+#endif
+
+namespace boost
+{
+namespace filesystem
+{
+namespace detail
+{
+  bool set_uncached(int fd)
+  {
+#   ifdef F_NOCACHE
+    return ::fcntl(fd, F_NOCACHE, 1) != -1;
+#   else
+    (void)fd;
+    return false;
+#   endif
+  }
+
+  void drop_behind(int fd, boost::uintmax_t& begin, boost::uintmax_t& mark,
+    boost::uintmax_t pos, bool written)
+  {
+    if (pos < mark + drop_window)  // includes a small move back, over unread input
+      return;
+#   ifdef BOOST_FILESYSTEM_SYNC_FILE_RANGE
+    if (written)
+      ::sync_file_range(fd, static_cast<off_t>(mark), static_cast<off_t>(pos - mark),
+        SYNC_FILE_RANGE_WRITE);
+#   endif
+    if (mark != begin)
+    {
+#     ifdef BOOST_FILESYSTEM_SYNC_FILE_RANGE
+      if (written)
+        ::sync_file_range(fd, static_cast<off_t>(begin), static_cast<off_t>(mark - begin),
+          SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE
+          | SYNC_FILE_RANGE_WAIT_AFTER);
+#     endif
+#     ifdef BOOST_FILESYSTEM_FADVISE
+      ::posix_fadvise(fd, static_cast<off_t>(begin), static_cast<off_t>(mark - begin),
+        POSIX_FADV_DONTNEED);
+#     endif
+      begin = mark;
+    }
+    mark = pos;
+    (void)fd;
+    (void)written;
+  }
+
+  void drop_all(int fd, boost::uintmax_t begin, bool written)
+  {
+    // a length of 0 means to the end of the file
+#   ifdef BOOST_FILESYSTEM_SYNC_FILE_RANGE
+    if (written)
+      ::sync_file_range(fd, static_cast<off_t>(begin), 0,
+        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE
+        | SYNC_FILE_RANGE_WAIT_AFTER);
+#   endif
+#   ifdef BOOST_FILESYSTEM_FADVISE
+    ::posix_fadvise(fd, static_cast<off_t>(begin), 0, POSIX_FADV_DONTNEED);
+#   endif
+    (void)fd;
+    (void)begin;
+    (void)written;
+  }
+
+}  // namespace detail
+}  // namespace filesystem
+}  // namespace boost
+
+#endif  // BOOST_POSIX_API
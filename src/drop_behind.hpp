@@ -0,0 +1,53 @@
+//  filesystem drop_behind.hpp  --------------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//  Page cache control for uncached sequential I/O, used by native_filebuf and
+//  copy_file(). Private to the library implementation.
+
+#ifndef BOOST_FILESYSTEM3_DROP_BEHIND_HPP
+#define BOOST_FILESYSTEM3_DROP_BEHIND_HPP
+
+#include <boost/filesystem/config.hpp>
+#include <boost/cstdint.hpp>
+
+#ifdef BOOST_POSIX_API
+
+namespace boost
+{
+namespace filesystem
+{
+namespace detail
+{
+  //  Pages are dropped once the file position has moved this far past them
+  const boost::uintmax_t drop_window = 8 * 1024 * 1024;
+
+  //  Asks that fd's data not be cached at all, where the operating system can be asked
+  //  that for a whole file (F_NOCACHE). Returns: true if it was, so there is nothing
+  //  for drop_behind() to do.
+  bool set_uncached(int fd);
+
+  //  Drops from the page cache the pages of fd that pos has moved drop_window past.
+  //  [begin, mark) are the pages not yet dropped whose writeback has been started if
+  //  written is true, kept between calls; both start as the position I/O starts at.
+  //  Written pages can only be dropped once they reach the storage device, so each
+  //  window's writeback is started as it fills and waited for a window later.
+  void drop_behind(int fd, boost::uintmax_t& begin, boost::uintmax_t& mark,
+    boost::uintmax_t pos, bool written);
+
+  //  Drops the pages of fd from begin to the end of the file, first waiting for any
+  //  written ones to reach the storage device if written is true
+  void drop_all(int fd, boost::uintmax_t begin, bool written);
+
+}  // namespace detail
+}  // namespace filesystem
+}  // namespace boost
+
+#endif  // BOOST_POSIX_API
+
+#endif  // BOOST_FILESYSTEM3_DROP_BEHIND_HPP
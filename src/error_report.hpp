@@ -0,0 +1,52 @@
+//  filesystem error_report.hpp  -------------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//  Error reporting for the classes that follow the operations.cpp convention, where a
+//  null error_code pointer means throw. Private to the library implementation.
+
+#ifndef BOOST_FILESYSTEM3_ERROR_REPORT_HPP
+#define BOOST_FILESYSTEM3_ERROR_REPORT_HPP
+
+#include <boost/filesystem/config.hpp>
+#include <boost/filesystem/operations.hpp>  // for filesystem_error
+#include <boost/system/error_code.hpp>
+
+namespace boost
+{
+namespace filesystem
+{
+namespace detail
+{
+  //  Reports result for p: throws filesystem_error if ec is 0, otherwise sets *ec
+  inline void report(const system::error_code& result, const path& p,
+    system::error_code* ec, const char* message)
+  {
+    if (ec == 0)
+      BOOST_FILESYSTEM_THROW(filesystem_error(message, p, result));
+    *ec = result;
+  }
+
+  //  errval is an errno or GetLastError() value
+  inline void report(int errval, const path& p, system::error_code* ec,
+    const char* message)
+  {
+    report(system::error_code(errval, system::system_category()), p, ec, message);
+  }
+
+  inline void report(system::errc::errc_t value, const path& p, system::error_code* ec,
+    const char* message)
+  {
+    report(system::errc::make_error_code(value), p, ec, message);
+  }
+
+}  // namespace detail
+}  // namespace filesystem
+}  // namespace boost
+
+#endif  // BOOST_FILESYSTEM3_ERROR_REPORT_HPP
@@ -0,0 +1,1004 @@
+//  filesystem fstream.cpp  ------------------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//--------------------------------------------------------------------------------------//
+
+// define BOOST_FILESYSTEM_SOURCE so that <boost/filesystem/config.hpp> knows
+// the library is being built (possibly exporting rather than importing code)
+#define BOOST_FILESYSTEM_SOURCE
+
+#ifndef BOOST_SYSTEM_NO_DEPRECATED
+# define BOOST_SYSTEM_NO_DEPRECATED
+#endif
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/filesystem/operations.hpp>
+#include "drop_behind.hpp"
+#include "error_report.hpp"
+#include <vector>
+#include <deque>
+#include <utility>
+#include <cstring>
+#include <cerrno>
+
+#ifdef BOOST_POSIX_API
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <fcntl.h>
+# include <unistd.h>
+# include <pthread.h>
+# define BOOST_FILESYSTEM_WRITER_THREAD
+#else
+# include <windows.h>
+# include <process.h>
+# if _WIN32_WINNT >= 0x0600  // condition variables
+#   define BOOST_FILESYSTEM_WRITER_THREAD
+# endif
+#endif
+
+using boost::filesystem::path;
+using boost::filesystem::native_filebuf;
+using boost::filesystem::async_filebuf;
+using boost::filesystem::access_hint;
+using boost::filesystem::commit_options;
+using boost::system::error_code;
+using boost::system::system_category;
+namespace errc = boost::system::errc;
+using boost::filesystem::detail::report;
+using std::ios_base;
+
+namespace
+{
+#ifdef BOOST_POSIX_API
+  const int invalid_handle = -1;
+
+  //  modes for files created, before the umask is applied
+  const unsigned owner_mode = S_IRUSR | S_IWUSR;
+  const unsigned default_mode = owner_mode | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH;
+
+  inline error_code last_error()  { return error_code(errno, system_category()); }
+#else
+  const HANDLE invalid_handle = INVALID_HANDLE_VALUE;
+
+  const unsigned owner_mode = 0;  // not used by CreateFileW()
+  const unsigned default_mode = 0;
+
+  inline error_code last_error()
+  {
+    return error_code(::GetLastError(), system_category());
+  }
+#endif
+
+  const ios_base::openmode in = ios_base::in;
+  const ios_base::openmode out = ios_base::out;
+  const ios_base::openmode trunc = ios_base::trunc;
+  const ios_base::openmode app = ios_base::app;
+
+  //  tries at a temporary file name before giving up; collisions are only likely if
+  //  another process is creating the same names
+  const int max_temp_attempts = 10;
+
+  //  Writes the directory entries of dir to the storage device
+  error_code sync_directory(const path& dir)
+  {
+#   ifdef BOOST_POSIX_API
+    int flags = O_RDONLY;
+#     ifdef O_DIRECTORY
+    flags |= O_DIRECTORY;
+#     endif
+#     ifdef O_CLOEXEC
+    flags |= O_CLOEXEC;
+#     endif
+    int fd = ::open(dir.empty() ? "." : dir.c_str(), flags);
+    if (fd == -1)
+      return last_error();
+    error_code result;
+    // some file systems cannot sync a directory, and say so with EINVAL
+    if (::fsync(fd) != 0 && errno != EINVAL)
+      result = last_error();
+    ::close(fd);
+    return result;
+#   else
+    (void)dir;
+    return error_code();  // MoveFileExW() has no directory to flush
+#   endif
+  }
+
+#ifdef BOOST_FILESYSTEM_WRITER_THREAD
+
+  //  A mutex, and a condition that is signalled whatever changes; waiters recheck
+  class monitor
+  {
+  public:
+#   ifdef BOOST_POSIX_API
+    monitor()            { ::pthread_mutex_init(&m_mutex, 0);
+                           ::pthread_cond_init(&m_cond, 0); }
+    ~monitor()           { ::pthread_cond_destroy(&m_cond);
+                           ::pthread_mutex_destroy(&m_mutex); }
+    void lock()          { ::pthread_mutex_lock(&m_mutex); }
+    void unlock()        { ::pthread_mutex_unlock(&m_mutex); }
+    void wait()          { ::pthread_cond_wait(&m_cond, &m_mutex); }
+    void notify_all()    { ::pthread_cond_broadcast(&m_cond); }
+  private:
+    pthread_mutex_t  m_mutex;
+    pthread_cond_t   m_cond;
+#   else
+    monitor()            { ::InitializeCriticalSection(&m_mutex);
+                           ::InitializeConditionVariable(&m_cond); }
+    ~monitor()           { ::DeleteCriticalSection(&m_mutex); }
+    void lock()          { ::EnterCriticalSection(&m_mutex); }
+    void unlock()        { ::LeaveCriticalSection(&m_mutex); }
+    void wait()          { ::SleepConditionVariableCS(&m_cond, &m_mutex, INFINITE); }
+    void notify_all()    { ::WakeAllConditionVariable(&m_cond); }
+  private:
+    CRITICAL_SECTION    m_mutex;
+    CONDITION_VARIABLE  m_cond;
+#   endif
+  };
+
+#else
+
+  class monitor  // one thread, so nothing to exclude or wait for
+  {
+  public:
+    void lock()          {}
+    void unlock()        {}
+    void wait()          {}
+    void notify_all()    {}
+  };
+
+#endif
+
+  struct runnable
+  {
+    virtual void run() = 0;
+  protected:
+    ~runnable() {}
+  };
+
+#ifdef BOOST_FILESYSTEM_WRITER_THREAD
+#   ifdef BOOST_POSIX_API
+  extern "C" void* run_thread(void* r)
+#   else
+  unsigned __stdcall run_thread(void* r)
+#   endif
+  {
+    static_cast<runnable*>(r)->run();
+    return 0;
+  }
+#endif
+
+  class scoped_lock
+  {
+  public:
+    explicit scoped_lock(monitor& m) : m_monitor(m)  { m_monitor.lock(); }
+    ~scoped_lock()                                   { m_monitor.unlock(); }
+  private:
+    monitor& m_monitor;
+    scoped_lock(const scoped_lock&);
+    scoped_lock& operator=(const scoped_lock&);
+  };
+
+}  // unnamed namespace
+
+namespace boost
+{
+namespace filesystem
+{
+
+  const std::size_t native_filebuf::default_buffer_size;
+
+  native_filebuf::native_filebuf(std::size_t buffer_size)
+    : m_handle(invalid_handle), m_buffer(0), m_buffer_size(0), m_one(0),
+      m_mode(ios_base::openmode()), m_uncached(false), m_drop_begin(0), m_drop_mark(0)
+  {
+    if (buffer_size != 0)
+    {
+      m_owned.reset(new char[buffer_size]);
+      m_buffer = m_owned.get();
+      m_buffer_size = buffer_size;
+    }
+  }
+
+  native_filebuf::~native_filebuf()
+  {
+    close();
+  }
+
+  bool native_filebuf::is_open() const
+  {
+    return m_handle != invalid_handle;
+  }
+
+  native_filebuf* native_filebuf::open(const path& p, ios_base::openmode mode,
+    const open_hints& hints)
+  {
+    return m_open(p, mode, hints, false, default_mode);
+  }
+
+  native_filebuf* native_filebuf::m_open(const path& p, ios_base::openmode mode,
+    const open_hints& hints, bool exclusive, unsigned create_mode)
+  {
+    if (is_open())
+    {
+      m_error = system::errc::make_error_code(system::errc::device_or_resource_busy);
+      return 0;
+    }
+
+    // the combinations std::basic_filebuf accepts, and the fopen() modes they imply
+    const ios_base::openmode m = mode & (in | out | trunc | app);
+    const bool reading = (m & in) != 0;
+    const bool writing = (m & (out | app)) != 0;
+    const bool append = (m & app) != 0;
+    const bool truncate = (m & trunc) != 0 || m == out;
+    if ((!reading && !writing) || (truncate && append)
+      || ((m & trunc) != 0 && (m & out) == 0))
+    {
+      m_error = system::errc::make_error_code(system::errc::invalid_argument);
+      return 0;
+    }
+
+#   ifdef BOOST_POSIX_API
+    int flags = reading && writing ? O_RDWR : writing ? O_WRONLY : O_RDONLY;
+    if (writing && (truncate || append || !reading))
+      flags |= O_CREAT;
+    if (exclusive)
+      flags |= O_CREAT | O_EXCL;
+    else if (truncate)
+      flags |= O_TRUNC;
+    if (append)
+      flags |= O_APPEND;
+#     ifdef O_CLOEXEC
+    flags |= O_CLOEXEC;
+#     endif
+
+    int fd;
+    while ((fd = ::open(p.c_str(), flags, static_cast<mode_t>(create_mode))) == -1
+      && errno == EINTR) {}
+    if (fd == -1)
+    {
+      m_error = last_error();
+      return 0;
+    }
+
+    // hints; failures are ignored
+#     if defined(_POSIX_ADVISORY_INFO) && _POSIX_ADVISORY_INFO > 0
+    int advice = POSIX_FADV_NORMAL;
+    switch (hints.access)
+    {
+      case access_hint::sequential: advice = POSIX_FADV_SEQUENTIAL; break;
+      case access_hint::random:     advice = POSIX_FADV_RANDOM;     break;
+      case access_hint::noreuse:    advice = POSIX_FADV_NOREUSE;    break;
+      default: break;
+    }
+    if (advice != POSIX_FADV_NORMAL)
+      ::posix_fadvise(fd, 0, 0, advice);
+    if (hints.willneed)
+      ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#     endif
+#     if defined(__linux__) && defined(FALLOC_FL_KEEP_SIZE)
+    if (writing && hints.preallocate != 0)
+      ::fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(hints.preallocate));
+#     endif
+    m_uncached = hints.uncached && !detail::set_uncached(fd);
+    m_handle = fd;
+#   else
+    DWORD access = 0;
+    if (reading)
+      access |= GENERIC_READ;
+    if (append)
+      access |= FILE_APPEND_DATA | SYNCHRONIZE;  // every write goes to the end
+    else if (writing)
+      access |= GENERIC_WRITE;
+    (void)create_mode;
+    DWORD disposition = exclusive ? CREATE_NEW : truncate ? CREATE_ALWAYS
+      : writing && (append || !reading) ? OPEN_ALWAYS : OPEN_EXISTING;
+    DWORD attributes = FILE_ATTRIBUTE_NORMAL;
+    if (hints.access == access_hint::sequential)
+      attributes |= FILE_FLAG_SEQUENTIAL_SCAN;
+    else if (hints.access == access_hint::random)
+      attributes |= FILE_FLAG_RANDOM_ACCESS;
+
+    HANDLE h = ::CreateFileW(p.c_str(), access,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 0, disposition,
+      attributes, 0);
+    if (h == INVALID_HANDLE_VALUE)
+    {
+      m_error = last_error();
+      return 0;
+    }
+#     if _WIN32_WINNT >= 0x0600
+    if (writing && hints.preallocate != 0)
+    {
+      FILE_ALLOCATION_INFO info;
+      info.AllocationSize.QuadPart = static_cast<LONGLONG>(hints.preallocate);
+      ::SetFileInformationByHandle(h, FileAllocationInfo, &info, sizeof(info));
+    }
+#     endif
+    m_handle = h;
+#   endif
+
+    m_mode = mode;
+    setg(0, 0, 0);
+    setp(0, 0);
+    boost::intmax_t pos = 0;
+    if ((mode & ios_base::ate) && !m_seek(0, ios_base::end, pos))
+    {
+      error_code ec(m_error);
+      close();
+      m_error = ec;
+      return 0;
+    }
+    m_drop_begin = m_drop_mark = static_cast<boost::uintmax_t>(pos);
+    m_error.clear();
+    return this;
+  }
+
+  native_filebuf* native_filebuf::close()
+  {
+    if (!is_open())
+      return 0;
+
+    bool ok = pbase() == 0 || m_flush();
+    setg(0, 0, 0);
+    setp(0, 0);
+#   ifdef BOOST_POSIX_API
+    if (m_uncached)
+      detail::drop_all(m_handle, m_drop_begin, (m_mode & (out | app)) != 0);
+    m_uncached = false;
+    // the descriptor is released even if close() fails, so it must not be retried
+    if (::close(m_handle) != 0 && ok)
+#   else
+    if (!::CloseHandle(m_handle) && ok)
+#   endif
+    {
+      m_error = last_error();
+      ok = false;
+    }
+    m_handle = invalid_handle;
+    return ok ? this : 0;
+  }
+
+  //  -----  native I/O  -----
+
+  bool native_filebuf::m_write(const char* s, std::size_t n)
+  {
+    while (n != 0)
+    {
+#     ifdef BOOST_POSIX_API
+      ssize_t written = ::write(m_handle, s, n);
+      if (written == -1)
+      {
+        if (errno == EINTR)
+          continue;
+        m_error = last_error();
+        return false;
+      }
+#     else
+      DWORD written;
+      DWORD chunk = n > 0x40000000 ? 0x40000000 : static_cast<DWORD>(n);
+      if (!::WriteFile(m_handle, s, chunk, &written, 0))
+      {
+        m_error = last_error();
+        return false;
+      }
+#     endif
+      s += written;
+      n -= static_cast<std::size_t>(written);
+    }
+    m_drop_behind();
+    return true;
+  }
+
+  //  Returns: the number of bytes read, 0 at end of file, or -1 on error
+  std::streamsize native_filebuf::m_read(char* s, std::size_t n)
+  {
+#   ifdef BOOST_POSIX_API
+    ssize_t result;
+    while ((result = ::read(m_handle, s, n)) == -1 && errno == EINTR)
+      {}
+    if (result == -1)
+      m_error = last_error();
+    else if (result != 0)
+      m_drop_behind();
+    return static_cast<std::streamsize>(result);
+#   else
+    DWORD result;
+    DWORD chunk = n > 0x40000000 ? 0x40000000 : static_cast<DWORD>(n);
+    if (!::ReadFile(m_handle, s, chunk, &result, 0))
+    {
+      if (::GetLastError() == ERROR_BROKEN_PIPE)
+        return 0;
+      m_error = last_error();
+      return -1;
+    }
+    return static_cast<std::streamsize>(result);
+#   endif
+  }
+
+  bool native_filebuf::m_seek(boost::intmax_t off, ios_base::seekdir way,
+    boost::intmax_t& pos)
+  {
+#   ifdef BOOST_POSIX_API
+    int whence = way == ios_base::beg ? SEEK_SET : way == ios_base::cur ? SEEK_CUR
+      : SEEK_END;
+    off_t result = ::lseek(m_handle, static_cast<off_t>(off), whence);
+    if (result == -1)
+    {
+      m_error = last_error();
+      return false;
+    }
+    pos = result;
+#   else
+    DWORD method = way == ios_base::beg ? FILE_BEGIN : way == ios_base::cur
+      ? FILE_CURRENT : FILE_END;
+    LARGE_INTEGER distance, result;
+    distance.QuadPart = off;
+    if (!::SetFilePointerEx(m_handle, distance, &result, method))
+    {
+      m_error = last_error();
+      return false;
+    }
+    pos = result.QuadPart;
+#   endif
+    return true;
+  }
+
+  void native_filebuf::m_drop_behind()
+  {
+#   ifdef BOOST_POSIX_API
+    if (!m_uncached)
+      return;
+    off_t pos = ::lseek(m_handle, 0, SEEK_CUR);
+    if (pos != -1)
+      detail::drop_behind(m_handle, m_drop_begin, m_drop_mark,
+        static_cast<boost::uintmax_t>(pos), (m_mode & (out | app)) != 0);
+#   endif
+  }
+
+  bool native_filebuf::m_flush()
+  {
+    bool ok = m_write(pbase(), static_cast<std::size_t>(pptr() - pbase()));
+    setp(0, 0);
+    return ok;
+  }
+
+  bool native_filebuf::m_stop_reading()
+  {
+    std::ptrdiff_t unread = egptr() - gptr();
+    setg(0, 0, 0);
+    boost::intmax_t pos;
+    return unread == 0 || m_seek(-unread, ios_base::cur, pos);
+  }
+
+  //  -----  std::streambuf overrides  -----
+
+  native_filebuf::int_type native_filebuf::underflow()
+  {
+    if (gptr() < egptr())
+      return traits_type::to_int_type(*gptr());
+    if (!is_open() || !(m_mode & in))
+      return traits_type::eof();
+    if (pbase() != 0 && !m_flush())
+      return traits_type::eof();
+
+    char* buf = m_buffer_size != 0 ? m_buffer : &m_one;
+    std::streamsize n = m_read(buf, m_buffer_size != 0 ? m_buffer_size : 1);
+    if (n <= 0)
+    {
+      setg(0, 0, 0);
+      return traits_type::eof();
+    }
+    setg(buf, buf, buf + n);
+    return traits_type::to_int_type(*gptr());
+  }
+
+  native_filebuf::int_type native_filebuf::overflow(int_type c)
+  {
+    if (!is_open() || !(m_mode & (out | app)))
+      return traits_type::eof();
+    if (eback() != 0 && !m_stop_reading())
+      return traits_type::eof();
+    if (pbase() != 0 && !m_flush())
+      return traits_type::eof();
+    if (traits_type::eq_int_type(c, traits_type::eof()))
+      return traits_type::not_eof(c);
+
+    char ch = traits_type::to_char_type(c);
+    if (m_buffer_size == 0)
+      return m_write(&ch, 1) ? c : traits_type::eof();
+    setp(m_buffer, m_buffer + m_buffer_size);
+    *pptr() = ch;
+    pbump(1);
+    return c;
+  }
+
+  int native_filebuf::sync()
+  {
+    return pbase() == 0 || m_flush() ? 0 : -1;
+  }
+
+  std::streamsize native_filebuf::xsputn(const char* s, std::streamsize n)
+  {
+    if (n <= 0)
+      return 0;
+    if (pbase() != 0 && n <= epptr() - pptr())
+    {
+      std::memcpy(pptr(), s, static_cast<std::size_t>(n));
+      pbump(static_cast<int>(n));
+      return n;
+    }
+    if (static_cast<std::size_t>(n) < m_buffer_size)
+      return std::streambuf::xsputn(s, n);  // fills and flushes the buffer
+
+    // as large as the buffer: write it directly, after anything already buffered
+    if (!is_open() || !(m_mode & (out | app))
+      || (eback() != 0 && !m_stop_reading())
+      || (pbase() != 0 && !m_flush())
+      || !m_write(s, static_cast<std::size_t>(n)))
+      return 0;
+    return n;
+  }
+
+  std::streamsize native_filebuf::xsgetn(char* s, std::streamsize n)
+  {
+    if (n <= 0)
+      return 0;
+    std::streamsize avail = egptr() - gptr();
+    if (n <= avail)
+    {
+      std::memcpy(s, gptr(), static_cast<std::size_t>(n));
+      gbump(static_cast<int>(n));
+      return n;
+    }
+    if (static_cast<std::size_t>(n - avail) < m_buffer_size)
+      return std::streambuf::xsgetn(s, n);  // refills the buffer
+
+    // at least a buffer's worth remains: read it directly, after what is buffered
+    if (avail != 0)
+      std::memcpy(s, gptr(), static_cast<std::size_t>(avail));
+    setg(0, 0, 0);
+    std::streamsize done = avail;
+    if (!is_open() || !(m_mode & in) || (pbase() != 0 && !m_flush()))
+      return done;
+    while (done != n)
+    {
+      std::streamsize got = m_read(s + done, static_cast<std::size_t>(n - done));
+      if (got <= 0)
+        break;
+      done += got;
+    }
+    return done;
+  }
+
+  native_filebuf::pos_type native_filebuf::seekoff(off_type off, ios_base::seekdir way,
+    ios_base::openmode)
+  {
+    if (!is_open() || (pbase() != 0 && !m_flush()))
+      return pos_type(off_type(-1));
+    if (way == ios_base::cur)
+      off -= egptr() - gptr();  // the file position is past the unread input
+    setg(0, 0, 0);
+    boost::intmax_t pos;
+    if (!m_seek(off, way, pos))
+      return pos_type(off_type(-1));
+    // pages from a seek back are dropped with the rest, once the position is past them
+    if (m_uncached && static_cast<boost::uintmax_t>(pos) < m_drop_begin)
+      m_drop_begin = static_cast<boost::uintmax_t>(pos);
+    return pos_type(off_type(pos));
+  }
+
+  native_filebuf::pos_type native_filebuf::seekpos(pos_type pos,
+    ios_base::openmode which)
+  {
+    return seekoff(off_type(pos), ios_base::beg, which);
+  }
+
+  std::streambuf* native_filebuf::setbuf(char* s, std::streamsize n)
+  {
+    if ((pbase() != 0 && !m_flush()) || (eback() != 0 && !m_stop_reading()))
+      return 0;
+
+    if (n <= 0)  // unbuffered
+    {
+      m_owned.reset();
+      m_buffer = 0;
+      m_buffer_size = 0;
+    }
+    else if (s == 0)  // a buffer of n bytes, allocated here
+    {
+      if (static_cast<std::size_t>(n) != m_buffer_size || !m_owned)
+      {
+        m_owned.reset(new char[static_cast<std::size_t>(n)]);
+        m_buffer = m_owned.get();
+        m_buffer_size = static_cast<std::size_t>(n);
+      }
+    }
+    else  // the caller's buffer
+    {
+      m_owned.reset();
+      m_buffer = s;
+      m_buffer_size = static_cast<std::size_t>(n);
+    }
+    return this;
+  }
+
+//--------------------------------------------------------------------------------------//
+//                                   atomic_ofstream                                    //
+//--------------------------------------------------------------------------------------//
+
+  atomic_ofstream::~atomic_ofstream()
+  {
+    discard();
+  }
+
+  void atomic_ofstream::open(const path& p, const open_hints& hints)
+  {
+    if (is_open())
+    {
+      this->setstate(ios_base::failbit);
+      return;
+    }
+
+    // until it is given the target's permissions, no one but the owner may read the
+    // new contents; with no target, it is created as any new file would be
+    unsigned create_mode = default_mode;
+#   ifdef BOOST_POSIX_API
+    struct stat st;
+    const bool replacing = ::stat(p.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+    if (replacing)
+      create_mode = owner_mode;
+#   endif
+
+    // a sibling of p, so that the rename does not cross file systems; a name already
+    // taken is never opened, so is only a collision to retry
+    path temp;
+    for (int attempt = 0;; ++attempt)
+    {
+      temp = p.native() + unique_path(".%%%%-%%%%.tmp").native();
+      if (m_buf.m_open(temp, out | trunc, hints, true, create_mode))
+        break;
+      if (m_buf.error() != errc::file_exists || attempt == max_temp_attempts)
+      {
+        this->setstate(ios_base::failbit);
+        return;
+      }
+    }
+
+#   ifdef BOOST_POSIX_API
+    // readers of the target must still be able to read it once it is replaced
+    if (replacing && ::fchmod(m_buf.native_handle(), st.st_mode & (S_IRWXU | S_IRWXG
+      | S_IRWXO | S_ISUID | S_ISGID | S_ISVTX)) != 0)
+    {
+      error_code fchmod_ec(last_error());
+      m_buf.close();
+      error_code ignored;
+      filesystem::remove(temp, ignored);
+      m_buf.m_error = fchmod_ec;
+      this->setstate(ios_base::failbit);
+      return;
+    }
+#   endif
+
+    m_target = p;
+    m_temp = temp;
+    this->clear();
+  }
+
+  void atomic_ofstream::discard()
+  {
+    if (!is_open())
+      return;
+    m_buf.close();
+    error_code ignored;
+    filesystem::remove(m_temp, ignored);
+    m_temp.clear();
+  }
+
+  void atomic_ofstream::m_commit(BOOST_SCOPED_ENUM(commit_options) options,
+    error_code* ec)
+  {
+    if (!is_open())
+    {
+      this->setstate(ios_base::failbit);
+      report(errc::make_error_code(errc::bad_file_descriptor), m_target, ec,
+        "boost::filesystem::atomic_ofstream::commit");
+      return;
+    }
+
+    error_code local_ec;
+    if (m_buf.pubsync() != 0)
+      local_ec = m_buf.error();
+    else if ((options & commit_options::sync_file) == commit_options::sync_file)
+    {
+#     ifdef BOOST_POSIX_API
+      if (::fsync(m_buf.native_handle()) != 0)
+#     else
+      if (!::FlushFileBuffers(m_buf.native_handle()))
+#     endif
+        local_ec = last_error();
+    }
+    if (!m_buf.close() && !local_ec)
+      local_ec = m_buf.error();
+
+    if (!local_ec)
+      filesystem::rename(m_temp, m_target, local_ec);
+    if (local_ec)
+    {
+      error_code ignored;
+      filesystem::remove(m_temp, ignored);
+      m_temp.clear();
+      this->setstate(ios_base::failbit);
+      report(local_ec, m_target, ec, "boost::filesystem::atomic_ofstream::commit");
+      return;
+    }
+    m_temp.clear();
+
+    if ((options & commit_options::sync_directory) == commit_options::sync_directory)
+    {
+      local_ec = sync_directory(m_target.parent_path());
+      if (local_ec)
+      {
+        this->setstate(ios_base::failbit);
+        report(local_ec, m_target, ec, "boost::filesystem::atomic_ofstream::commit");
+        return;
+      }
+    }
+    if (ec != 0)
+      ec->clear();
+  }
+
+//--------------------------------------------------------------------------------------//
+//                                    async_filebuf                                     //
+//--------------------------------------------------------------------------------------//
+
+  //  The buffers, and the thread that writes them. Each buffer is always in exactly one
+  //  place: the put area, the free list, the queue, or being written by the thread.
+  struct async_filebuf::writer : runnable
+  {
+    typedef std::pair<char*, std::size_t> job;
+
+    monitor              mon;       // guards everything below
+    std::vector<char*>   free;      // buffers ready to be filled
+    std::deque<job>      queue;     // filled buffers waiting to be written, oldest first
+    bool                 busy;      // the thread is writing a buffer
+    bool                 stop;      // the thread is to finish the queue and return
+    error_code           error;     // the first write that failed
+    native_filebuf*      file;
+    boost::scoped_array<char> storage;
+
+#   ifdef BOOST_POSIX_API
+    pthread_t            thread;
+#   else
+    HANDLE               thread;
+#   endif
+
+    writer() : busy(false), stop(false), file(0) {}
+
+    void write(const job& j);
+    void run();
+    bool start();
+    void join();
+  };
+
+  void async_filebuf::writer::write(const job& j)
+  {
+    // error is only set, and the file only written, by this thread, so after one
+    // failure the rest of the output is dropped
+    if (error)
+      return;
+    if (file->sputn(j.first, static_cast<std::streamsize>(j.second))
+      != static_cast<std::streamsize>(j.second))
+    {
+      scoped_lock lock(mon);
+      error = file->error() ? file->error() : errc::make_error_code(errc::io_error);
+    }
+  }
+
+  void async_filebuf::writer::run()
+  {
+    scoped_lock lock(mon);
+    for (;;)
+    {
+      while (queue.empty() && !stop)
+        mon.wait();
+      if (queue.empty())
+        return;
+      job j(queue.front());
+      queue.pop_front();
+      busy = true;
+      mon.unlock();
+      write(j);
+      mon.lock();
+      busy = false;
+      free.push_back(j.first);
+      mon.notify_all();
+    }
+  }
+
+#ifdef BOOST_FILESYSTEM_WRITER_THREAD
+  bool async_filebuf::writer::start()
+  {
+    stop = false;
+#   ifdef BOOST_POSIX_API
+    return ::pthread_create(&thread, 0, run_thread, static_cast<runnable*>(this)) == 0;
+#   else
+    thread = reinterpret_cast<HANDLE>(
+      ::_beginthreadex(0, 0, run_thread, static_cast<runnable*>(this), 0, 0));
+    return thread != 0;
+#   endif
+  }
+
+  void async_filebuf::writer::join()
+  {
+    {
+      scoped_lock lock(mon);
+      stop = true;
+      mon.notify_all();
+    }
+#   ifdef BOOST_POSIX_API
+    ::pthread_join(thread, 0);
+#   else
+    ::WaitForSingleObject(thread, INFINITE);
+    ::CloseHandle(thread);
+#   endif
+  }
+#else
+  bool async_filebuf::writer::start()  { return true; }
+  void async_filebuf::writer::join()   {}
+#endif
+
+  const std::size_t async_filebuf::default_buffer_size;
+  const std::size_t async_filebuf::default_buffer_count;
+
+  async_filebuf::async_filebuf(std::size_t buffer_size, std::size_t buffer_count)
+    : m_writer(new writer), m_file(0),
+      m_buffer_size(buffer_size != 0 ? buffer_size : 1),
+      m_buffer_count(buffer_count >= 2 ? buffer_count : 2)
+  {
+    m_writer->file = &m_file;
+    m_writer->storage.reset(new char[m_buffer_size * m_buffer_count]);
+  }
+
+  async_filebuf::~async_filebuf()
+  {
+    close();
+  }
+
+  async_filebuf* async_filebuf::open(const path& p, ios_base::openmode mode,
+    const open_hints& hints)
+  {
+    if (mode & in)
+    {
+      m_error = errc::make_error_code(errc::invalid_argument);
+      return 0;
+    }
+    if (!m_file.open(p, mode, hints))
+    {
+      m_error = m_file.error();
+      return 0;
+    }
+
+    writer& w(*m_writer);
+    w.free.clear();
+    w.queue.clear();
+    w.error.clear();
+    for (std::size_t i = 1; i != m_buffer_count; ++i)
+      w.free.push_back(w.storage.get() + i * m_buffer_size);
+    if (!w.start())
+    {
+      m_file.close();
+      m_error = errc::make_error_code(errc::resource_unavailable_try_again);
+      return 0;
+    }
+    setp(w.storage.get(), w.storage.get() + m_buffer_size);
+    m_error.clear();
+    return this;
+  }
+
+  async_filebuf* async_filebuf::close()
+  {
+    if (!is_open())
+      return 0;
+
+    bool ok = m_submit() && m_drain();
+    m_writer->join();
+    setp(0, 0);
+    if (!m_file.close() && ok)
+    {
+      m_error = m_file.error();
+      ok = false;
+    }
+    return ok ? this : 0;
+  }
+
+  bool async_filebuf::m_submit()
+  {
+    if (!is_open())
+      return false;
+
+    writer& w(*m_writer);
+    std::size_t n = static_cast<std::size_t>(pptr() - pbase());
+    if (n != 0)
+    {
+#     ifdef BOOST_FILESYSTEM_WRITER_THREAD
+      scoped_lock lock(w.mon);
+      w.queue.push_back(writer::job(pbase(), n));
+      w.mon.notify_all();
+      while (w.free.empty())  // every buffer is queued or being written
+        w.mon.wait();
+#     else
+      w.write(writer::job(pbase(), n));
+      w.free.push_back(pbase());
+#     endif
+      char* next = w.free.back();
+      w.free.pop_back();
+      setp(next, next + m_buffer_size);
+    }
+
+    scoped_lock lock(w.mon);
+    if (w.error)
+    {
+      m_error = w.error;
+      return false;
+    }
+    return true;
+  }
+
+  bool async_filebuf::m_drain()
+  {
+    writer& w(*m_writer);
+    scoped_lock lock(w.mon);
+    while (!w.queue.empty() || w.busy)
+      w.mon.wait();
+    if (w.error)
+    {
+      m_error = w.error;
+      return false;
+    }
+    return true;
+  }
+
+  async_filebuf::int_type async_filebuf::overflow(int_type c)
+  {
+    if (!m_submit())
+      return traits_type::eof();
+    if (traits_type::eq_int_type(c, traits_type::eof()))
+      return traits_type::not_eof(c);
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+    return c;
+  }
+
+  int async_filebuf::sync()
+  {
+    if (!is_open())
+      return 0;
+    return m_submit() && m_drain() ? 0 : -1;
+  }
+
+  std::streamsize async_filebuf::xsputn(const char* s, std::streamsize n)
+  {
+    std::streamsize done = 0;
+    while (done < n)
+    {
+      if (pptr() == epptr() && !m_submit())
+        break;
+      std::streamsize chunk = epptr() - pptr();
+      if (chunk > n - done)
+        chunk = n - done;
+      std::memcpy(pptr(), s + done, static_cast<std::size_t>(chunk));
+      pbump(static_cast<int>(chunk));
+      done += chunk;
+    }
+    return done;
+  }
+
+}  // namespace filesystem
+}  // namespace boost
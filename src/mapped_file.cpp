@@ -0,0 +1,453 @@
+//  filesystem mapped_file.cpp  --------------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//--------------------------------------------------------------------------------------//
+
+// define BOOST_FILESYSTEM_SOURCE so that <boost/filesystem/config.hpp> knows
+// the library is being built (possibly exporting rather than importing code)
+#define BOOST_FILESYSTEM_SOURCE
+
+#ifndef BOOST_SYSTEM_NO_DEPRECATED
+# define BOOST_SYSTEM_NO_DEPRECATED
+#endif
+
+#include <boost/filesystem/mapped_file.hpp>
+#include "error_report.hpp"
+#include <boost/cstdint.hpp>
+#include <cerrno>
+
+#ifdef BOOST_POSIX_API
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/mman.h>
+# include <fcntl.h>
+# include <unistd.h>
+# if defined(__linux__) && defined(MADV_HUGEPAGE)
+#   define BOOST_FILESYSTEM_MAP_HUGE_PAGES
+# endif
+#else
+# include <windows.h>
+#endif
+
+using boost::filesystem::path;
+using boost::filesystem::mapped_file;
+using boost::filesystem::map_mode;
+using boost::filesystem::map_options;
+using boost::filesystem::map_advice;
+using boost::system::error_code;
+using boost::system::system_category;
+namespace errc = boost::system::errc;
+using boost::filesystem::detail::report;
+
+namespace
+{
+#ifdef BOOST_POSIX_API
+
+  const int invalid_handle = -1;
+
+  std::size_t page_size()
+  {
+    static const std::size_t size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    return size;
+  }
+
+# ifdef BOOST_FILESYSTEM_MAP_HUGE_PAGES
+  //  the PMD size with 4K pages on x86-64 and AArch64; mappings smaller than this gain
+  //  nothing from huge_pages
+  const std::size_t huge_page_size = 2 * 1024 * 1024;
+# endif
+
+#else
+
+  const HANDLE invalid_handle = INVALID_HANDLE_VALUE;
+
+#endif
+
+}  // unnamed namespace
+
+namespace boost
+{
+namespace filesystem
+{
+
+  void mapped_file::m_init()
+  {
+    m_data = 0;
+    m_size = 0;
+    m_handle = invalid_handle;
+    m_is_open = false;
+    m_mode = map_mode::read_only;
+    m_options = map_options::none;
+  }
+
+  void mapped_file::close()
+  {
+    if (!m_is_open)
+      return;
+    m_unmap();
+#   ifdef BOOST_POSIX_API
+    ::close(m_handle);
+#   else
+    ::CloseHandle(m_handle);
+#   endif
+    m_path.clear();
+    m_init();
+  }
+
+  void mapped_file::m_open(const path& p, BOOST_SCOPED_ENUM(map_mode) mode,
+    BOOST_SCOPED_ENUM(map_options) options, system::error_code* ec)
+  {
+    close();
+
+    const bool writable = mode == map_mode::read_write;
+    const bool create = writable
+      && (options & map_options::create) == map_options::create;
+    boost::uintmax_t size;
+
+#   ifdef BOOST_POSIX_API
+    int flags = writable ? O_RDWR : O_RDONLY;
+    if (create)
+      flags |= O_CREAT;
+#     ifdef O_CLOEXEC
+    flags |= O_CLOEXEC;
+#     endif
+    int fd = ::open(p.c_str(), flags,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+    if (fd == -1)
+    {
+      report(error_code(errno, system_category()), p, ec,
+        "boost::filesystem::mapped_file::open");
+      return;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+      int errval = errno;
+      ::close(fd);
+      report(error_code(errval, system_category()), p, ec,
+        "boost::filesystem::mapped_file::open");
+      return;
+    }
+    size = static_cast<boost::uintmax_t>(st.st_size);
+#   else
+    HANDLE fd = ::CreateFileW(p.c_str(),
+      writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 0,
+      create ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (fd == INVALID_HANDLE_VALUE)
+    {
+      report(error_code(::GetLastError(), system_category()), p, ec,
+        "boost::filesystem::mapped_file::open");
+      return;
+    }
+    LARGE_INTEGER file_size;
+    if (!::GetFileSizeEx(fd, &file_size))
+    {
+      DWORD errval = ::GetLastError();
+      ::CloseHandle(fd);
+      report(error_code(errval, system_category()), p, ec,
+        "boost::filesystem::mapped_file::open");
+      return;
+    }
+    size = static_cast<boost::uintmax_t>(file_size.QuadPart);
+#   endif
+
+    if (size > static_cast<std::size_t>(-1))  // larger than the address space
+    {
+#     ifdef BOOST_POSIX_API
+      ::close(fd);
+#     else
+      ::CloseHandle(fd);
+#     endif
+      report(errc::file_too_large, p, ec, "boost::filesystem::mapped_file::open");
+      return;
+    }
+
+    m_handle = fd;
+    m_size = static_cast<std::size_t>(size);
+    m_mode = mode;
+    m_options = options;
+    m_path = p;
+    m_is_open = true;
+
+    error_code local_ec;
+    if (!m_map(local_ec))
+    {
+      close();
+      report(local_ec, p, ec, "boost::filesystem::mapped_file::open");
+      return;
+    }
+    if (ec != 0)
+      ec->clear();
+  }
+
+  //  maps [0, m_size) of m_handle; an empty file is not mapped
+  bool mapped_file::m_map(system::error_code& ec)
+  {
+    m_data = 0;
+    if (m_size == 0)
+      return true;
+
+    const bool writable = m_mode == map_mode::read_write;
+    const bool populate = (m_options & map_options::populate) == map_options::populate;
+
+#   ifdef BOOST_POSIX_API
+    int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ;
+    int flags = MAP_SHARED;
+#     ifdef MAP_POPULATE
+    if (populate)
+      flags |= MAP_POPULATE;
+#     endif
+
+    void* addr = 0;
+#     ifdef BOOST_FILESYSTEM_MAP_HUGE_PAGES
+    // reserve enough address space to find a huge page boundary in, map the file
+    // over the reservation at that boundary, then release the rest
+    const bool huge = (m_options & map_options::huge_pages) == map_options::huge_pages
+      && m_size >= huge_page_size;
+    char* reserved = 0;
+    const std::size_t reserved_size = m_size + huge_page_size;
+    if (huge)
+    {
+      void* r = ::mmap(0, reserved_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (r != MAP_FAILED)
+      {
+        reserved = static_cast<char*>(r);
+        addr = reinterpret_cast<void*>(
+          (reinterpret_cast<boost::uintptr_t>(reserved) + huge_page_size - 1)
+            & ~(boost::uintptr_t(huge_page_size) - 1));
+        flags |= MAP_FIXED;
+      }
+    }
+#     endif
+
+    void* data = ::mmap(addr, m_size, prot, flags, m_handle, 0);
+    if (data == MAP_FAILED)
+    {
+      ec.assign(errno, system_category());
+#     ifdef BOOST_FILESYSTEM_MAP_HUGE_PAGES
+      if (reserved != 0)
+        ::munmap(reserved, reserved_size);
+#     endif
+      return false;
+    }
+
+#     ifdef BOOST_FILESYSTEM_MAP_HUGE_PAGES
+    if (reserved != 0)
+    {
+      char* begin = static_cast<char*>(data);
+      char* end = begin + (m_size + page_size() - 1) / page_size() * page_size();
+      if (begin != reserved)
+        ::munmap(reserved, begin - reserved);
+      if (end != reserved + reserved_size)
+        ::munmap(end, reserved + reserved_size - end);
+    }
+    if (huge)
+      ::madvise(data, m_size, MADV_HUGEPAGE);  // only a hint; ignore errors
+#     endif
+#     ifndef MAP_POPULATE
+    if (populate)
+      ::madvise(data, m_size, MADV_WILLNEED);
+#     endif
+
+    m_data = static_cast<char*>(data);
+#   else
+    (void)populate;
+    HANDLE mapping = ::CreateFileMappingW(m_handle, 0,
+      writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, 0);
+    if (mapping == 0)
+    {
+      ec.assign(::GetLastError(), system_category());
+      return false;
+    }
+    void* data = ::MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ,
+      0, 0, m_size);
+    if (data == 0)
+      ec.assign(::GetLastError(), system_category());
+    ::CloseHandle(mapping);  // the view keeps the mapping open
+    if (data == 0)
+      return false;
+    m_data = static_cast<char*>(data);
+#   endif
+    return true;
+  }
+
+  void mapped_file::m_unmap()
+  {
+    if (m_data == 0)
+      return;
+#   ifdef BOOST_POSIX_API
+    ::munmap(m_data, m_size);
+#   else
+    ::UnmapViewOfFile(m_data);
+#   endif
+    m_data = 0;
+  }
+
+  void mapped_file::m_advise(BOOST_SCOPED_ENUM(map_advice) advice, std::size_t offset,
+    std::size_t length, system::error_code* ec)
+  {
+    if (!m_is_open)
+    {
+      report(errc::bad_file_descriptor, m_path, ec,
+        "boost::filesystem::mapped_file::advise");
+      return;
+    }
+    if (offset > m_size)
+    {
+      report(errc::invalid_argument, m_path, ec,
+        "boost::filesystem::mapped_file::advise");
+      return;
+    }
+    if (length > m_size - offset)
+      length = m_size - offset;
+
+#   ifdef BOOST_POSIX_API
+    if (m_data != 0 && length != 0)
+    {
+      int value = MADV_NORMAL;
+      switch (advice)
+      {
+        case map_advice::normal:     value = MADV_NORMAL;     break;
+        case map_advice::sequential: value = MADV_SEQUENTIAL; break;
+        case map_advice::random:     value = MADV_RANDOM;     break;
+        case map_advice::willneed:   value = MADV_WILLNEED;   break;
+        case map_advice::dontneed:   value = MADV_DONTNEED;   break;
+      }
+      // madvise() wants a page aligned start
+      std::size_t start = offset / page_size() * page_size();
+      if (::madvise(m_data + start, offset - start + length, value) != 0)
+      {
+        report(error_code(errno, system_category()), m_path, ec,
+          "boost::filesystem::mapped_file::advise");
+        return;
+      }
+    }
+#   else
+    (void)advice;  // Windows has no equivalent for mapped views; a hint may be ignored
+#   endif
+    if (ec != 0)
+      ec->clear();
+  }
+
+  void mapped_file::m_resize(std::size_t new_size, system::error_code* ec)
+  {
+    if (!m_is_open)
+    {
+      report(errc::bad_file_descriptor, m_path, ec,
+        "boost::filesystem::mapped_file::resize");
+      return;
+    }
+    if (m_mode != map_mode::read_write)
+    {
+      report(errc::operation_not_permitted, m_path, ec,
+        "boost::filesystem::mapped_file::resize");
+      return;
+    }
+    if (new_size == m_size)
+    {
+      if (ec != 0)
+        ec->clear();
+      return;
+    }
+
+    error_code local_ec;
+#   ifdef BOOST_POSIX_API
+    if (new_size > m_size)
+    {
+      // allocate first, while the old mapping is intact, so that running out of
+      // space is an error here rather than SIGBUS on a later write
+      int err = EINVAL;
+#     if defined(_POSIX_ADVISORY_INFO) && _POSIX_ADVISORY_INFO > 0
+      err = ::posix_fallocate(m_handle, 0, static_cast<off_t>(new_size));
+#     endif
+      if (err == EINVAL || err == EOPNOTSUPP)  // not supported by the file system
+        err = ::ftruncate(m_handle, static_cast<off_t>(new_size)) == 0 ? 0 : errno;
+      if (err != 0)
+      {
+        report(error_code(err, system_category()), m_path, ec,
+          "boost::filesystem::mapped_file::resize");
+        return;
+      }
+      m_unmap();
+    }
+    else
+    {
+      m_unmap();
+      if (::ftruncate(m_handle, static_cast<off_t>(new_size)) != 0)
+      {
+        int errval = errno;
+        if (!m_map(local_ec))  // restore the old mapping
+          close();
+        report(error_code(errval, system_category()), m_path, ec,
+          "boost::filesystem::mapped_file::resize");
+        return;
+      }
+    }
+#   else
+    m_unmap();
+    LARGE_INTEGER end;
+    end.QuadPart = static_cast<LONGLONG>(new_size);
+    if (!::SetFilePointerEx(m_handle, end, 0, FILE_BEGIN) || !::SetEndOfFile(m_handle))
+    {
+      DWORD errval = ::GetLastError();
+      if (!m_map(local_ec))  // restore the old mapping
+        close();
+      report(error_code(errval, system_category()), m_path, ec,
+        "boost::filesystem::mapped_file::resize");
+      return;
+    }
+#   endif
+
+    m_size = new_size;
+    if (!m_map(local_ec))
+    {
+      path p(m_path);
+      close();
+      report(local_ec, p, ec, "boost::filesystem::mapped_file::resize");
+      return;
+    }
+    if (ec != 0)
+      ec->clear();
+  }
+
+  void mapped_file::m_flush(system::error_code* ec)
+  {
+    if (!m_is_open)
+    {
+      report(errc::bad_file_descriptor, m_path, ec,
+        "boost::filesystem::mapped_file::flush");
+      return;
+    }
+    if (m_mode == map_mode::read_write)
+    {
+#     ifdef BOOST_POSIX_API
+      if ((m_data != 0 && ::msync(m_data, m_size, MS_SYNC) != 0)
+        || ::fsync(m_handle) != 0)
+      {
+        report(error_code(errno, system_category()), m_path, ec,
+          "boost::filesystem::mapped_file::flush");
+        return;
+      }
+#     else
+      if ((m_data != 0 && !::FlushViewOfFile(m_data, 0))
+        || !::FlushFileBuffers(m_handle))
+      {
+        report(error_code(::GetLastError(), system_category()), m_path, ec,
+          "boost::filesystem::mapped_file::flush");
+        return;
+      }
+#     endif
+    }
+    if (ec != 0)
+      ec->clear();
+  }
+
+}  // namespace filesystem
+}  // namespace boost
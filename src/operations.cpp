@@ -61,6 +61,9 @@
 #endif
 
 #include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/canonical_context.hpp>
+#include <boost/filesystem/status_cache.hpp>
+#include "drop_behind.hpp"
 #include <boost/scoped_array.hpp>
 #include <boost/detail/workaround.hpp>
 #include <vector> 
@@ -225,7 +228,8 @@ typedef struct _REPARSE_DATA_BUFFER {
 #   define BOOST_DELETE_FILE(P)(::unlink(P)== 0)
 #   define BOOST_CREATE_DIRECTORY_FROM_EXISTING(P,From)(!(::stat(From, &from_stat)!= 0\
          || ::mkdir(P,from_stat.st_mode)!= 0))
-#   define BOOST_COPY_FILE(F,T,FailIfExistsBool)copy_file_api(F, T, FailIfExistsBool)
+#   define BOOST_COPY_FILE(F,T,FailIfExistsBool,Uncached)\
+         copy_file_api(F, T, FailIfExistsBool, Uncached)
 #   define BOOST_MOVE_FILE(OLD,NEW)(::rename(OLD, NEW)== 0)
 #   define BOOST_RESIZE_FILE(P,SZ)(::truncate(P, SZ)== 0)
 
@@ -243,7 +247,14 @@ typedef struct _REPARSE_DATA_BUFFER {
 #   define BOOST_REMOVE_DIRECTORY(P)(::RemoveDirectoryW(P)!= 0)
 #   define BOOST_DELETE_FILE(P)(::DeleteFileW(P)!= 0)
 #   define BOOST_CREATE_DIRECTORY_FROM_EXISTING(P,From)(::CreateDirectoryExW(From, P, 0)!= 0)
-#   define BOOST_COPY_FILE(F,T,FailIfExistsBool)(::CopyFileW(F, T, FailIfExistsBool)!= 0)
+#   if defined(COPY_FILE_NO_BUFFERING)
+#     define BOOST_COPY_FILE(F,T,FailIfExistsBool,Uncached)(::CopyFileExW(F, T, 0, 0, 0,\
+         ((FailIfExistsBool) ? COPY_FILE_FAIL_IF_EXISTS : 0)\
+         | ((Uncached) ? COPY_FILE_NO_BUFFERING : 0))!= 0)
+#   else
+#     define BOOST_COPY_FILE(F,T,FailIfExistsBool,Uncached)\
+         (::CopyFileW(F, T, FailIfExistsBool)!= 0)
+#   endif
 #   define BOOST_MOVE_FILE(OLD,NEW)(::MoveFileExW(OLD, NEW, MOVEFILE_REPLACE_EXISTING|MOVEFILE_COPY_ALLOWED)!= 0)
 #   define BOOST_RESIZE_FILE(P,SZ)(resize_file_api(P, SZ)!= 0)
 #   define BOOST_READ_SYMLINK(P,T)
@@ -436,18 +447,60 @@ namespace
     return errno == ENOENT || errno == ENOTDIR;
   }
 
+  //  open(), then O_DIRECT if direct and the file system accepts it. O_DIRECT is set
+  //  afterwards rather than passed to open(), so a file system that refuses it (EINVAL)
+  //  costs no second open(), which could not keep the guarantees of O_EXCL; the file is
+  //  then used through the cache, with its pages dropped behind the I/O.
+  int open_direct(const char* p, int oflag, mode_t mode, bool direct)
+  {
+    int fd = ::open(p, oflag, mode);
+#   ifdef O_DIRECT
+    if (fd >= 0 && direct)
+    {
+      int flags = ::fcntl(fd, F_GETFL);
+      if (flags != -1)
+        ::fcntl(fd, F_SETFL, flags | O_DIRECT);
+    }
+#   else
+    (void)direct;
+#   endif
+    return fd;
+  }
+
+  //  Returns: true if fd was using O_DIRECT, which it now is not
+  bool clear_direct(int fd)
+  {
+#   ifdef O_DIRECT
+    int flags = ::fcntl(fd, F_GETFL);
+    if (flags != -1 && (flags & O_DIRECT) != 0)
+      return ::fcntl(fd, F_SETFL, flags & ~O_DIRECT) != -1;
+#   else
+    (void)fd;
+#   endif
+    return false;
+  }
+
   bool // true if ok
   copy_file_api(const std::string& from_p,
-    const std::string& to_p, bool fail_if_exists)
-  {
-    const std::size_t buf_sz = 32768;
-    boost::scoped_array<char> buf(new char [buf_sz]);
+    const std::string& to_p, bool fail_if_exists, bool uncached)
+  {
+    // uncached copies use O_DIRECT where the file system allows it, which needs larger
+    // transfers from an aligned buffer; an unaligned tail, or a file system that
+    // refuses O_DIRECT reads or writes with EINVAL, falls back to cached I/O, dropping
+    // the pages behind the copy as it goes
+    const std::size_t direct_align = 4096;
+    const std::size_t buf_sz = uncached ? 1024 * 1024 : 32768;
+    boost::scoped_array<char> storage(new char [buf_sz + (uncached ? direct_align : 0)]);
+    char* buf = storage.get();
+    if (uncached)
+      buf += (direct_align - reinterpret_cast<std::size_t>(buf) % direct_align)
+        % direct_align;
     int infile=-1, outfile=-1;  // -1 means not open
 
     // bug fixed: code previously did a stat()on the from_file first, but that
     // introduced a gratuitous race condition; the stat()is now done after the open()
 
-    if ((infile = ::open(from_p.c_str(), O_RDONLY))< 0)
+    if ((infile = open_direct(from_p.c_str(), O_RDONLY, 0, uncached))< 0)
       { return false; }
 
     struct stat from_stat;
@@ -460,7 +513,7 @@ namespace
     int oflag = O_CREAT | O_WRONLY | O_TRUNC;
     if (fail_if_exists)
       oflag |= O_EXCL;
-    if ((outfile = ::open(to_p.c_str(), oflag, from_stat.st_mode))< 0)
+    if ((outfile = open_direct(to_p.c_str(), oflag, from_stat.st_mode, uncached))< 0)
     {
       int open_errno = errno;
       BOOST_ASSERT(infile >= 0);
@@ -469,25 +522,49 @@ namespace
       return false;
     }
 
+    bool drop = uncached;
+    if (uncached && fs::detail::set_uncached(infile) && fs::detail::set_uncached(outfile))
+      drop = false;  // F_NOCACHE
+    boost::uintmax_t copied = 0, in_begin = 0, in_mark = 0, out_begin = 0, out_mark = 0;
+
     ssize_t sz, sz_read=1, sz_write;
-    while (sz_read > 0
-      && (sz_read = ::read(infile, buf.get(), buf_sz))> 0)
+    while (sz_read > 0)
     {
+      if ((sz_read = ::read(infile, buf, buf_sz)) < 0 && errno == EINVAL
+        && clear_direct(infile))
+        sz_read = ::read(infile, buf, buf_sz);
+      if (sz_read <= 0)
+        break;
+
       // Allow for partial writes - see Advanced Unix Programming (2nd Ed.),
       // Marc Rochkind, Addison-Wesley, 2004, page 94
       sz_write = 0;
       do
       {
-        if ((sz = ::write(outfile, buf.get() + sz_write,
+        if ((sz = ::write(outfile, buf + sz_write,
           sz_read - sz_write))< 0)
         { 
+          if (errno == EINVAL && clear_direct(outfile))
+            continue;   // retry through the cache
           sz_read = sz; // cause read loop termination
           break;        //  and error to be thrown after closes
         }
         sz_write += sz;
       } while (sz_write < sz_read);
+
+      if (drop && sz_read > 0)
+      {
+        copied += static_cast<boost::uintmax_t>(sz_read);
+        fs::detail::drop_behind(infile, in_begin, in_mark, copied, false);
+        fs::detail::drop_behind(outfile, out_begin, out_mark, copied, true);
+      }
     }
 
+    if (drop)
+    {
+      fs::detail::drop_all(infile, in_begin, false);
+      fs::detail::drop_all(outfile, out_begin, true);
+    }
     if (::close(infile)< 0)sz_read = -1;
     if (::close(outfile)< 0)sz_read = -1;
 
@@ -499,6 +576,81 @@ namespace
     return fs::detail::symlink_status(p, ec).type();
   }
 
+  //  Set the modification time of p to sec + nsec, leaving the access time alone.
+  //  utimensat() is POSIX.1-2008; older systems get whole seconds from utime().
+  bool // true if ok
+  set_mtime(const char* p, std::time_t sec, long nsec)
+  {
+#   if defined(UTIME_OMIT)
+    struct timespec times[2];
+    times[0].tv_sec = 0;
+    times[0].tv_nsec = UTIME_OMIT;
+    times[1].tv_sec = sec;
+    times[1].tv_nsec = nsec;
+    return ::utimensat(AT_FDCWD, p, times, 0) == 0;
+#   else
+    (void)nsec;
+    struct stat path_stat;
+    if (::stat(p, &path_stat)!= 0)
+      return false;
+    ::utimbuf buf;
+    buf.actime = path_stat.st_atime; // utime()updates access time too:-(
+    buf.modtime = sec;
+    return ::utime(p, &buf)== 0;
+#   endif
+  }
+
+  fs::file_status process_status_failure(int errval, const char* p, error_code* ec)
+  {
+    if (ec != 0)                            // always report errno, even though some
+      ec->assign(errval, system_category());  // errno values are not file_type::nones
+
+    if (not_found_error(errval))
+    {
+      return fs::file_status(fs::file_type::not_found, fs::no_perms);
+    }
+    if (ec == 0)
+      BOOST_FILESYSTEM_THROW(filesystem_error("boost::filesystem::status",
+        p, error_code(errval, system_category())));
+    return fs::file_status(fs::file_type::none);
+  }
+
+  //  the status() of a file whose stat() st_mode is mode
+  fs::file_status mode_status(mode_t mode)
+  {
+    perms prms(static_cast<perms>(mode) & fs::perms_mask);
+    if (S_ISDIR(mode))
+      return fs::file_status(fs::file_type::directory, prms);
+    if (S_ISREG(mode))
+      return fs::file_status(fs::file_type::regular, prms);
+    if (S_ISBLK(mode))
+      return fs::file_status(fs::file_type::block_file, prms);
+    if (S_ISCHR(mode))
+      return fs::file_status(fs::file_type::character_file, prms);
+    if (S_ISFIFO(mode))
+      return fs::file_status(fs::file_type::fifo_file, prms);
+    if (S_ISSOCK(mode))
+      return fs::file_status(fs::file_type::socket_file, prms);
+    if (S_ISLNK(mode))  // from lstat() only
+      return fs::file_status(fs::file_type::symlink, prms);
+    return fs::file_status(fs::file_type::unknown);
+  }
+
+  //  st_mtim is POSIX.1-2008, and where present st_mtime is a macro naming its tv_sec.
+  //  Darwin calls it st_mtimespec. Otherwise only whole seconds are available.
+  boost::chrono::system_clock::time_point mtime_point(const struct stat& st)
+  {
+    using namespace boost::chrono;
+#   if defined(__APPLE__)
+    nanoseconds d(seconds(st.st_mtimespec.tv_sec) + nanoseconds(st.st_mtimespec.tv_nsec));
+#   elif defined(st_mtime)
+    nanoseconds d(seconds(st.st_mtim.tv_sec) + nanoseconds(st.st_mtim.tv_nsec));
+#   else
+    seconds d(st.st_mtime);
+#   endif
+    return system_clock::time_point(duration_cast<system_clock::duration>(d));
+  }
+
 # else
 
 //--------------------------------------------------------------------------------------//
@@ -570,6 +722,31 @@ namespace
     ft.dwHighDateTime = static_cast<DWORD>(temp >> 32);
   }
 
+  //  FILETIME counts 100 nanosecond intervals since 1601-01-01
+  typedef boost::chrono::duration<boost::int64_t, boost::ratio<1, 10000000> >
+    filetime_duration;
+
+  boost::chrono::system_clock::time_point to_time_point(const FILETIME & ft)
+  {
+    __int64 t = (static_cast<__int64>(ft.dwHighDateTime)<< 32)
+      + ft.dwLowDateTime;
+    t -= 116444736000000000LL;
+    return boost::chrono::system_clock::time_point(
+      boost::chrono::duration_cast<boost::chrono::system_clock::duration>(
+        filetime_duration(t)));
+  }
+
+#   ifndef BOOST_FILESYSTEM_USE_TIME_T
+  void to_FILETIME(boost::chrono::system_clock::time_point t, FILETIME & ft)
+  {
+    __int64 temp = boost::chrono::duration_cast<filetime_duration>(
+      t.time_since_epoch()).count();
+    temp += 116444736000000000LL;
+    ft.dwLowDateTime = static_cast<DWORD>(temp);
+    ft.dwHighDateTime = static_cast<DWORD>(temp >> 32);
+  }
+#   endif
+
   // Thanks to Jeremy Maitin-Shepard for much help and for permission to
   // base the equivalent()implementation on portions of his 
   // file-equivalence-win32.cpp experimental code.
@@ -596,6 +773,28 @@ namespace
       hTemplateFile);
   }
 
+  //  the last write time of what p resolves to, as last_write_time_point() reports it;
+  //  metadata() needs it in both the time_point and time_t configurations
+  boost::chrono::system_clock::time_point mtime_point(const path& p, error_code* ec)
+  {
+    handle_wrapper hw(
+      create_file_handle(p.c_str(), 0,
+        FILE_SHARE_DELETE | FILE_SHARE_READ | FILE_SHARE_WRITE, 0,
+        OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, 0));
+
+    if (error(hw.handle == INVALID_HANDLE_VALUE,
+      p, ec, "boost::filesystem::last_write_time"))
+        return boost::chrono::system_clock::from_time_t(std::time_t(-1));
+
+    FILETIME lwt;
+
+    if (error(::GetFileTime(hw.handle, 0, 0, &lwt)== 0,
+      p, ec, "boost::filesystem::last_write_time"))
+        return boost::chrono::system_clock::from_time_t(std::time_t(-1));
+
+    return to_time_point(lwt);
+  }
+
   bool is_reparse_point_a_symlink(const path& p)
   {
     handle_wrapper h(create_file_handle(p, FILE_READ_EA,
@@ -822,6 +1021,38 @@ namespace detail
 
   BOOST_FILESYSTEM_DECL
   path canonical(const path& p, const path& base, system::error_code* ec)
+  {
+    return canonical(p, base, static_cast<canonical_context*>(0), ec);
+  }
+
+  BOOST_FILESYSTEM_DECL
+  path canonical(const path& p, const path& base, canonical_context* ctx,
+    system::error_code* ec)
+  {
+    path source (p.is_absolute() ? p : absolute(p, base));
+
+#   ifdef BOOST_POSIX_API
+    //  Fast path: realpath() resolves the whole path in one call. If it fails, the scan
+    //  runs and reports the error. A context means the caller wants its cache used, so
+    //  the scan is used directly.
+    if (ctx == 0)
+    {
+      if (char* resolved = ::realpath(source.c_str(), 0))
+      {
+        path result(resolved);
+        std::free(resolved);
+        if (ec != 0)
+          ec->clear();
+        return result;
+      }
+    }
+#   endif
+    return canonical_scan(source, base, ctx, ec);
+  }
+
+  BOOST_FILESYSTEM_DECL
+  path canonical_scan(const path& p, const path& base, canonical_context* ctx,
+    system::error_code* ec)
   {
     path source (p.is_absolute() ? p : absolute(p, base));
     path result;
@@ -864,15 +1095,21 @@ namespace detail
 
         result /= *itr;
 
-        bool is_sym (is_symlink(detail::symlink_status(result, ec)));
+        bool is_sym;
+        path link;
+        if (ctx != 0)
+          is_sym = ctx->lookup_symlink(result, link, ec);
+        else
+        {
+          is_sym = is_symlink(detail::symlink_status(result, ec));
+          if (is_sym && !(ec && *ec))
+            link = detail::read_symlink(result, ec);
+        }
         if (ec && *ec)
           return path();
 
         if (is_sym)
         {
-          path link(detail::read_symlink(result, ec));
-          if (ec && *ec)
-            return path();
           result.remove_filename();
 
           if (link.is_absolute())
@@ -979,7 +1216,7 @@ namespace detail
           it = fs::directory_iterator(from);
         for (; it != fs::directory_iterator(); ++it)
         {
-          copy(it->path(), to / it->path().filename(),
+          copy(it->path(), join(to, it->path().filename()),
             options | copy_options::_detail_sub_directory, ec);
           if (ec != 0 && *ec) return;
         }
@@ -1003,23 +1240,27 @@ namespace detail
                   error_code* ec)
   {
     BOOST_ASSERT_MSG((valid_existing(options)), "Too many existing-group copy_options");
+    const bool uncached((options & copy_options::uncached) == copy_options::uncached);
 
     if ((options & copy_options::skip_existing) == copy_options::skip_existing)
     {
       if (!exists(to))
-        return !error(!BOOST_COPY_FILE(from.c_str(), to.c_str(), FAIL_IF_EXISTS),
+        return !error(!BOOST_COPY_FILE(from.c_str(), to.c_str(), FAIL_IF_EXISTS,
+          uncached),
           from, to, ec, "boost::filesystem::copy_file");
       return false;
     }
     else if ((options & copy_options::update_existing) == copy_options::update_existing)
     {
       if (!exists(to) || fs::last_write_time(from) > fs::last_write_time(to))
-        return !error(!BOOST_COPY_FILE(from.c_str(), to.c_str(), !FAIL_IF_EXISTS),
+        return !error(!BOOST_COPY_FILE(from.c_str(), to.c_str(), !FAIL_IF_EXISTS,
+          uncached),
           from, to, ec, "boost::filesystem::copy_file");
       return false;
     }
     return !error(!BOOST_COPY_FILE(from.c_str(), to.c_str(),
-      (options & copy_options::overwrite_existing) != copy_options::overwrite_existing),
+      (options & copy_options::overwrite_existing) != copy_options::overwrite_existing,
+      uncached),
       from, to, ec, "boost::filesystem::copy_file");
   }
 
@@ -1379,16 +1620,7 @@ namespace detail
   {
 #   ifdef BOOST_POSIX_API
 
-    struct stat path_stat;
-    if (error(::stat(p.c_str(), &path_stat)!= 0,
-        p, ec, "boost::filesystem::file_size"))
-      return static_cast<boost::uintmax_t>(-1);
-   if (error(!S_ISREG(path_stat.st_mode),
-      error_code(EPERM, system_category()),
-        p, ec, "boost::filesystem::file_size"))
-      return static_cast<boost::uintmax_t>(-1);
-
-    return static_cast<boost::uintmax_t>(path_stat.st_size);
+    return file_size(p.c_str(), ec);
 
 #   else  // Windows
 
@@ -1410,6 +1642,38 @@ namespace detail
 #   endif
   }
 
+  BOOST_FILESYSTEM_DECL
+  boost::uintmax_t file_size(const path::value_type* p, error_code* ec)
+  {
+#   ifdef BOOST_POSIX_API
+
+    // a path is only constructed if there is an error to report
+    struct stat path_stat;
+    if (::stat(p, &path_stat)!= 0)
+    {
+      int errval = errno;
+      error(true, error_code(errval, system_category()),
+        path(p), ec, "boost::filesystem::file_size");
+      return static_cast<boost::uintmax_t>(-1);
+    }
+    if (!S_ISREG(path_stat.st_mode))
+    {
+      error(true, error_code(EPERM, system_category()),
+        path(p), ec, "boost::filesystem::file_size");
+      return static_cast<boost::uintmax_t>(-1);
+    }
+
+    if (ec != 0)
+      ec->clear();
+    return static_cast<boost::uintmax_t>(path_stat.st_size);
+
+#   else  // Windows
+
+    return file_size(path(p), ec);
+
+#   endif
+  }
+
   //------------------------------  hard_link_count  -----------------------------------//
 
   BOOST_FILESYSTEM_DECL
@@ -1490,11 +1754,7 @@ namespace detail
   {
 #   ifdef BOOST_POSIX_API
 
-    struct stat path_stat;
-    if (error(::stat(p.c_str(), &path_stat)!= 0,
-      p, ec, "boost::filesystem::last_write_time"))
-        return std::time_t(-1);
-    return path_stat.st_mtime;
+    return last_write_time(p.c_str(), ec);
 
 #   else
 
@@ -1517,6 +1777,30 @@ namespace detail
 #   endif
   }
 
+  BOOST_FILESYSTEM_DECL
+  std::time_t last_write_time(const path::value_type* p, system::error_code* ec)
+  {
+#   ifdef BOOST_POSIX_API
+
+    struct stat path_stat;
+    if (::stat(p, &path_stat)!= 0)
+    {
+      int errval = errno;
+      error(true, error_code(errval, system_category()),
+        path(p), ec, "boost::filesystem::last_write_time");
+      return std::time_t(-1);
+    }
+    if (ec != 0)
+      ec->clear();
+    return path_stat.st_mtime;
+
+#   else
+
+    return last_write_time(path(p), ec);
+
+#   endif
+  }
+
   //-------------------------  (set) last_write_time  ----------------------------------//
 
   BOOST_FILESYSTEM_DECL
@@ -1525,14 +1809,84 @@ namespace detail
   {
 #   ifdef BOOST_POSIX_API
 
-    struct stat path_stat;
-    if (error(::stat(p.c_str(), &path_stat)!= 0,
+    error(!set_mtime(p.c_str(), new_time, 0),
+      p, ec, "boost::filesystem::last_write_time");
+
+#   else
+
+    handle_wrapper hw(
+      create_file_handle(p.c_str(), FILE_WRITE_ATTRIBUTES,
+        FILE_SHARE_DELETE | FILE_SHARE_READ | FILE_SHARE_WRITE, 0,
+        OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, 0));
+
+    if (error(hw.handle == INVALID_HANDLE_VALUE,
       p, ec, "boost::filesystem::last_write_time"))
         return;
-    ::utimbuf buf;
-    buf.actime = path_stat.st_atime; // utime()updates access time too:-(
-    buf.modtime = new_time;
-    error(::utime(p.c_str(), &buf)!= 0,
+
+    FILETIME lwt;
+    to_FILETIME(new_time, lwt);
+
+    error(::SetFileTime(hw.handle, 0, 0, &lwt)== 0,
+      p, ec, "boost::filesystem::last_write_time");
+#   endif
+  }
+
+  //-------------------------  last_write_time, time_point forms  ----------------------//
+
+# ifndef BOOST_FILESYSTEM_USE_TIME_T
+
+  BOOST_FILESYSTEM_DECL
+  boost::chrono::system_clock::time_point
+  last_write_time_point(const path& p, system::error_code* ec)
+  {
+#   ifdef BOOST_POSIX_API
+
+    return last_write_time_point(p.c_str(), ec);
+
+#   else
+
+    return mtime_point(p, ec);
+#   endif
+  }
+
+  BOOST_FILESYSTEM_DECL
+  boost::chrono::system_clock::time_point
+  last_write_time_point(const path::value_type* p, system::error_code* ec)
+  {
+#   ifdef BOOST_POSIX_API
+
+    struct stat path_stat;
+    if (::stat(p, &path_stat)!= 0)
+    {
+      int errval = errno;
+      error(true, error_code(errval, system_category()),
+        path(p), ec, "boost::filesystem::last_write_time");
+      return boost::chrono::system_clock::from_time_t(std::time_t(-1));
+    }
+    if (ec != 0)
+      ec->clear();
+    return mtime_point(path_stat);
+
+#   else
+
+    return last_write_time_point(path(p), ec);
+
+#   endif
+  }
+
+  BOOST_FILESYSTEM_DECL
+  void last_write_time(const path& p, boost::chrono::system_clock::time_point new_time,
+                       system::error_code* ec)
+  {
+#   ifdef BOOST_POSIX_API
+
+    using namespace boost::chrono;
+    nanoseconds d(duration_cast<nanoseconds>(new_time.time_since_epoch()));
+    seconds sec(duration_cast<seconds>(d));
+    if (sec > d)   // duration_cast truncates toward zero; tv_nsec must not be negative
+      sec -= seconds(1);
+    error(!set_mtime(p.c_str(), static_cast<std::time_t>(sec.count()),
+        static_cast<long>((d - sec).count())),
       p, ec, "boost::filesystem::last_write_time");
 
 #   else
@@ -1554,6 +1908,8 @@ namespace detail
 #   endif
   }
 
+# endif  // BOOST_FILESYSTEM_USE_TIME_T
+
 # ifdef BOOST_POSIX_API
     const perms active_bits(all_all | set_uid_on_exe | set_gid_on_exe | sticky_bit);
     inline mode_t mode_cast(perms prms) { return prms & active_bits; }
@@ -1811,41 +2167,7 @@ namespace detail
   {
 #   ifdef BOOST_POSIX_API
 
-    struct stat path_stat;
-    if (::stat(p.c_str(), &path_stat)!= 0)
-    {
-      if (ec != 0)                            // always report errno, even though some
-        ec->assign(errno, system_category());   // errno values are not file_type::nones
-
-      if (not_found_error(errno))
-      {
-        return fs::file_status(fs::file_type::not_found, fs::no_perms);
-      }
-      if (ec == 0)
-        BOOST_FILESYSTEM_THROW(filesystem_error("boost::filesystem::status",
-          p, error_code(errno, system_category())));
-      return fs::file_status(fs::file_type::none);
-    }
-    if (ec != 0) ec->clear();;
-    if (S_ISDIR(path_stat.st_mode))
-      return fs::file_status(fs::file_type::directory,
-        static_cast<perms>(path_stat.st_mode) & fs::perms_mask);
-    if (S_ISREG(path_stat.st_mode))
-      return fs::file_status(fs::file_type::regular,
-        static_cast<perms>(path_stat.st_mode) & fs::perms_mask);
-    if (S_ISBLK(path_stat.st_mode))
-      return fs::file_status(fs::file_type::block_file,
-        static_cast<perms>(path_stat.st_mode) & fs::perms_mask);
-    if (S_ISCHR(path_stat.st_mode))
-      return fs::file_status(fs::file_type::character_file,
-        static_cast<perms>(path_stat.st_mode) & fs::perms_mask);
-    if (S_ISFIFO(path_stat.st_mode))
-      return fs::file_status(fs::file_type::fifo_file,
-        static_cast<perms>(path_stat.st_mode) & fs::perms_mask);
-    if (S_ISSOCK(path_stat.st_mode))
-      return fs::file_status(fs::file_type::socket_file,
-        static_cast<perms>(path_stat.st_mode) & fs::perms_mask);
-    return fs::file_status(fs::file_type::unknown);
+    return status(p.c_str(), ec);
 
 #   else  // Windows
 
@@ -1886,6 +2208,130 @@ namespace detail
 #   endif
   }
 
+  BOOST_FILESYSTEM_DECL
+  file_status status(const path::value_type* p, error_code* ec)
+  {
+#   ifdef BOOST_POSIX_API
+
+    struct stat path_stat;
+    if (::stat(p, &path_stat)!= 0)
+      return process_status_failure(errno, p, ec);
+    if (ec != 0) ec->clear();
+    return mode_status(path_stat.st_mode);
+
+#   else  // Windows
+
+    return status(path(p), ec);
+
+#   endif
+  }
+
+  //------------------------------  metadata  ------------------------------------------//
+
+  BOOST_FILESYSTEM_DECL
+  file_metadata metadata(const path& p, error_code* ec)
+  {
+    file_metadata md;
+    md.size = 0;
+    md.inode = 0;
+
+#   ifdef BOOST_POSIX_API
+
+    struct stat path_stat;
+    if (::stat(p.c_str(), &path_stat)!= 0)
+    {
+      md.status = process_status_failure(errno, p.c_str(), ec);
+      return md;
+    }
+    if (ec != 0) ec->clear();
+    md.status = mode_status(path_stat.st_mode);
+    md.size = static_cast<boost::uintmax_t>(path_stat.st_size);
+    md.last_write_time = mtime_point(path_stat);
+    md.inode = static_cast<boost::uintmax_t>(path_stat.st_ino);
+
+#   else  // Windows
+
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    if (::GetFileAttributesExW(p.c_str(), ::GetFileExInfoStandard, &fad)== 0)
+    {
+      md.status = process_status_failure(p, ec);
+      return md;
+    }
+
+    //  a reparse point's attributes are its own, not those of what it resolves to
+    if (fad.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
+    {
+      md.status = status(p, ec);
+      if (exists(md.status))
+      {
+        error_code dummy;
+        if (is_regular_file(md.status))
+          md.size = file_size(p, &dummy);
+        md.last_write_time = mtime_point(p, &dummy);
+      }
+      return md;
+    }
+
+    if (ec != 0) ec->clear();
+    md.status = (fad.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+      ? file_status(file_type::directory, make_permissions(p, fad.dwFileAttributes))
+      : file_status(file_type::regular, make_permissions(p, fad.dwFileAttributes));
+    md.size = (static_cast<boost::uintmax_t>(fad.nFileSizeHigh)
+              << (sizeof(fad.nFileSizeLow)*8)) + fad.nFileSizeLow;
+    md.last_write_time = to_time_point(fad.ftLastWriteTime);
+
+#   endif
+    return md;
+  }
+
+  BOOST_FILESYSTEM_DECL
+  file_metadata symlink_metadata(const path& p, error_code* ec)
+  {
+    file_metadata md;
+    md.size = 0;
+    md.inode = 0;
+
+#   ifdef BOOST_POSIX_API
+
+    struct stat path_stat;
+    if (::lstat(p.c_str(), &path_stat)!= 0)
+    {
+      md.status = process_status_failure(errno, p.c_str(), ec);
+      return md;
+    }
+    if (ec != 0) ec->clear();
+    md.status = mode_status(path_stat.st_mode);
+    md.size = static_cast<boost::uintmax_t>(path_stat.st_size);
+    md.last_write_time = mtime_point(path_stat);
+    md.inode = static_cast<boost::uintmax_t>(path_stat.st_ino);
+
+#   else  // Windows
+
+    //  GetFileAttributesExW() does not follow reparse points
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    if (::GetFileAttributesExW(p.c_str(), ::GetFileExInfoStandard, &fad)== 0)
+    {
+      md.status = process_status_failure(p, ec);
+      return md;
+    }
+
+    if (fad.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
+      md.status = symlink_status(p, ec);
+    else
+    {
+      if (ec != 0) ec->clear();
+      md.status = (fad.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        ? file_status(file_type::directory, make_permissions(p, fad.dwFileAttributes))
+        : file_status(file_type::regular, make_permissions(p, fad.dwFileAttributes));
+    }
+    md.size = (static_cast<boost::uintmax_t>(fad.nFileSizeHigh)
+              << (sizeof(fad.nFileSizeLow)*8)) + fad.nFileSizeLow;
+    md.last_write_time = to_time_point(fad.ftLastWriteTime);
+
+#   endif
+    return md;
+  }
+
   //------------------------------  symlink_status  ------------------------------------//
 
   BOOST_FILESYSTEM_DECL
@@ -1893,19 +2339,49 @@ namespace detail
   {
 #   ifdef BOOST_POSIX_API
 
+    return symlink_status(p.c_str(), ec);
+
+#   else  // Windows
+
+    DWORD attr(::GetFileAttributesW(p.c_str()));
+    if (attr == 0xFFFFFFFF)
+    {
+      return process_status_failure(p, ec);
+    }
+
+    if (ec != 0) ec->clear();
+
+    if (attr & FILE_ATTRIBUTE_REPARSE_POINT)
+      return is_reparse_point_a_symlink(p)
+             ? file_status(file_type::symlink, make_permissions(p, attr))
+             : file_status(file_type::reparse_point, make_permissions(p, attr));
+
+    return (attr & FILE_ATTRIBUTE_DIRECTORY)
+      ? file_status(file_type::directory, make_permissions(p, attr))
+      : file_status(file_type::regular, make_permissions(p, attr));
+
+#   endif
+  }
+
+  BOOST_FILESYSTEM_DECL
+  file_status symlink_status(const path::value_type* p, error_code* ec)
+  {
+#   ifdef BOOST_POSIX_API
+
     struct stat path_stat;
-    if (::lstat(p.c_str(), &path_stat)!= 0)
+    if (::lstat(p, &path_stat)!= 0)
     {
+      int errval = errno;
       if (ec != 0)                            // always report errno, even though some
-        ec->assign(errno, system_category());   // errno values are not file_type::nones
+        ec->assign(errval, system_category());  // errno values are not file_type::nones
 
-      if (errno == ENOENT || errno == ENOTDIR) // these are not errors
+      if (errval == ENOENT || errval == ENOTDIR) // these are not errors
       {
         return fs::file_status(fs::file_type::not_found, fs::no_perms);
       }
       if (ec == 0)
         BOOST_FILESYSTEM_THROW(filesystem_error("boost::filesystem::status",
-          p, error_code(errno, system_category())));
+          p, error_code(errval, system_category())));
       return fs::file_status(fs::file_type::none);
     }
     if (ec != 0) ec->clear();
@@ -1934,22 +2410,7 @@ namespace detail
 
 #   else  // Windows
 
-    DWORD attr(::GetFileAttributesW(p.c_str()));
-    if (attr == 0xFFFFFFFF)
-    {
-      return process_status_failure(p, ec);
-    }
-
-    if (ec != 0) ec->clear();
-
-    if (attr & FILE_ATTRIBUTE_REPARSE_POINT)
-      return is_reparse_point_a_symlink(p)
-             ? file_status(file_type::symlink, make_permissions(p, attr))
-             : file_status(file_type::reparse_point, make_permissions(p, attr));
-
-    return (attr & FILE_ATTRIBUTE_DIRECTORY)
-      ? file_status(file_type::directory, make_permissions(p, attr))
-      : file_status(file_type::regular, make_permissions(p, attr));
+    return symlink_status(path(p), ec);
 
 #   endif
   }
@@ -2383,7 +2844,7 @@ namespace detail
       it.m_imp.reset(); // eof, so make end iterator
     else // not eof
     {
-      it.m_imp->dir_entry.assign(p / filename, file_stat, symlink_file_stat);
+      it.m_imp->dir_entry.assign(join(p, filename), file_stat, symlink_file_stat);
       if (filename[0] == dot // dot or dot-dot
         && (filename.size()== 1
           || (filename[1] == dot
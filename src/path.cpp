@@ -24,19 +24,24 @@
 
 #include <boost/filesystem/config.hpp>
 #include <boost/filesystem/path.hpp>
+#include "path_scan.hpp"
 #include <boost/scoped_array.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/system/error_code.hpp>
 #include <boost/assert.hpp>
 #include <algorithm>
 #include <cstddef>
 #include <cstring>
 #include <cassert>
+#include <stdexcept>
+#include "utf8_transcode.hpp"
+
+#include <boost/filesystem/detail/utf8_codecvt_facet.hpp>
+#include <boost/atomic.hpp>
 
 #ifdef BOOST_WINDOWS_API
 # include "windows_file_codecvt.hpp"
 # include <windows.h>
-#elif defined(macintosh) || defined(__APPLE__) || defined(__APPLE_CC__)
-# include <boost/filesystem/detail/utf8_codecvt_facet.hpp>
 #endif
 
 #ifdef BOOST_FILESYSTEM_DEBUG
@@ -114,6 +119,16 @@ namespace
       ;
   }
 
+  inline bool is_dot(const string_type& str, size_type first, size_type last)
+  {
+    return last - first == 1 && str[first] == dot;
+  }
+
+  inline bool is_dot_dot(const string_type& str, size_type first, size_type last)
+  {
+    return last - first == 2 && str[first] == dot && str[first+1] == dot;
+  }
+
   bool is_root_separator(const string_type& str, size_type pos);
     // pos is position of the separator
 
@@ -124,6 +139,17 @@ namespace
   size_type root_directory_start(const string_type& path, size_type size);
   //  Returns:  npos if no root_directory found
 
+  size_type root_name_size(const string_type& str);
+  //  Returns: size of the root-name, or 0 if none
+
+  size_type relative_path_start(const string_type& str);
+  //  Returns: position following the root-name and root-directory separators
+
+  bool next_element(const string_type& str, size_type& pos,
+                    size_type& first, size_type& last);
+  //  Sets [first, last) to the relative path element at or after pos, and advances pos.
+  //  A trailing separator yields a final empty element. Returns: false if no element
+
   void first_element(
       const string_type& src,
       size_type& element_pos,
@@ -188,6 +214,33 @@ namespace filesystem
     return *this;
   }
 
+  namespace detail
+  {
+    BOOST_FILESYSTEM_DECL
+    path join(const path* const* first, const path* const* last)
+    {
+      // each element adds at most one separator, so this is an upper bound; it is one
+      // character over for the first element and for every element that adds no
+      // separator, such as one that starts with a separator
+      std::size_t length = 0;
+      for (const path* const* it = first; it != last; ++it)
+        length += (*it)->m_pathname.size() + 1;
+
+      path result;
+      result.m_pathname.reserve(length);
+      for (const path* const* it = first; it != last; ++it)
+      {
+        const path::string_type& s = (*it)->m_pathname;
+        if (s.empty())
+          continue;
+        if (!is_separator(s[0]))  // the operator/= logic
+          result.m_append_separator_if_needed();
+        result.m_pathname += s;
+      }
+      return result;
+    }
+  }
+
   int path::compare(const path& p) const BOOST_NOEXCEPT
   {
     return detail::lex_compare(begin(), end(), p.begin(), p.end());
@@ -367,7 +420,8 @@ namespace filesystem
   {
     path name(filename());
     if (name == dot_path || name == dot_dot_path) return name;
-    size_type pos(name.m_pathname.rfind(dot));
+    size_type pos(detail::find_last_dot(name.m_pathname.c_str(),
+      name.m_pathname.size()));
     return pos == string_type::npos
       ? name
       : path(name.m_pathname.c_str(), name.m_pathname.c_str() + pos);
@@ -377,12 +431,159 @@ namespace filesystem
   {
     path name(filename());
     if (name == dot_path || name == dot_dot_path) return path();
-    size_type pos(name.m_pathname.rfind(dot));
+    size_type pos(detail::find_last_dot(name.m_pathname.c_str(),
+      name.m_pathname.size()));
     return pos == string_type::npos
       ? path()
       : path(name.m_pathname.c_str() + pos);
   }
 
+  //  lexical operations  --------------------------------------------------------------//
+
+  //  These follow the C++17 std::filesystem specification. Each is a single scan of the
+  //  native strings that appends to one result string reserved up front.
+
+  path path::lexically_normal() const
+  {
+    if (m_pathname.empty())
+      return path();
+
+    const size_type size(m_pathname.size());
+    path result;
+    string_type& out(result.m_pathname);
+    out.reserve(size + 1);
+
+    // root-name, with preferred separators; a single preferred root-directory
+    size_type pos(root_name_size(m_pathname));
+    out.assign(m_pathname, 0, pos);
+#   ifdef BOOST_WINDOWS_API
+    std::replace(out.begin(), out.end(), L'/', L'\\');
+#   endif
+    const bool has_root_dir(pos < size && is_separator(m_pathname[pos]));
+    if (has_root_dir)
+      out += preferred_separator;
+    const size_type rel_start(out.size());
+    pos = relative_path_start(m_pathname);
+
+    // each retained element is written followed by a separator; the final separator
+    // is removed at the end unless it should be kept
+    bool keep_trailing_separator(false);
+    size_type first, last;
+    while (next_element(m_pathname, pos, first, last))
+    {
+      if (first == last)  // trailing separator; already accounted for
+        continue;
+      if (is_dot(m_pathname, first, last))
+        keep_trailing_separator = true;
+      else if (is_dot_dot(m_pathname, first, last))
+      {
+        // start of the last element written, if any
+        size_type prev(out.size() == rel_start ? string_type::npos
+          : detail::find_last_separator(out.c_str() + rel_start,
+              out.size() - rel_start - 1));
+        prev = prev == string_type::npos ? rel_start : rel_start + prev + 1;
+
+        if (prev != out.size() && !is_dot_dot(out, prev, out.size() - 1))
+        {
+          out.erase(prev);  // "name/.." cancels
+          keep_trailing_separator = true;
+        }
+        else if (prev == out.size() && has_root_dir)
+          keep_trailing_separator = true;  // ".." at the root is the root
+        else
+        {
+          out.append(m_pathname, first, 2);
+          out += preferred_separator;
+          keep_trailing_separator = false;
+        }
+      }
+      else
+      {
+        out.append(m_pathname, first, last - first);
+        out += preferred_separator;
+        keep_trailing_separator = last < size;
+      }
+    }
+
+    // a last element of ".." is not followed by a separator
+    if (keep_trailing_separator && out.size() >= rel_start + 3
+      && is_dot_dot(out, out.size() - 3, out.size() - 1)
+      && (out.size() == rel_start + 3 || is_separator(out[out.size() - 4])))
+      keep_trailing_separator = false;
+    if (out.size() > rel_start && !keep_trailing_separator)
+      out.erase(out.size() - 1);
+    if (out.empty())
+      out = dot_path.m_pathname;
+    return result;
+  }
+
+  path path::lexically_relative(const path& base) const
+  {
+    const string_type& b(base.m_pathname);
+
+    // root-names must match, and both or neither path must have a root-directory
+    size_type root_size(root_name_size(m_pathname));
+    if (m_pathname.compare(0, root_size, b, 0, root_name_size(b)) != 0)
+      return path();
+    if ((root_size < m_pathname.size() && is_separator(m_pathname[root_size]))
+      != (root_size < b.size() && is_separator(b[root_size])))
+      return path();
+
+    // skip the common elements
+    size_type pos(relative_path_start(m_pathname)), base_pos(relative_path_start(b));
+    // a path with no relative elements leaves first and last at its end
+    size_type first(m_pathname.size()), last(first);
+    size_type base_first(b.size()), base_last(base_first);
+    bool more(next_element(m_pathname, pos, first, last));
+    bool base_more(next_element(b, base_pos, base_first, base_last));
+    while (more && base_more
+      && m_pathname.compare(first, last - first, b, base_first, base_last - base_first) == 0)
+    {
+      more = next_element(m_pathname, pos, first, last);
+      base_more = next_element(b, base_pos, base_first, base_last);
+    }
+    if (!more && !base_more)
+      return dot_path;
+
+    // each remaining base element, other than dot and empty, is a level to climb
+    std::ptrdiff_t n(0);
+    for (; base_more; base_more = next_element(b, base_pos, base_first, base_last))
+    {
+      if (is_dot_dot(b, base_first, base_last))
+        --n;
+      else if (base_first != base_last && !is_dot(b, base_first, base_last))
+        ++n;
+    }
+    if (n < 0)
+      return path();
+    if (n == 0 && (!more || first == last))
+      return dot_path;
+
+    path result;
+    string_type& out(result.m_pathname);
+    out.reserve(3 * n + (m_pathname.size() - first));
+    for (; n; --n)
+    {
+      if (!out.empty())
+        out += preferred_separator;
+      out += dot;
+      out += dot;
+    }
+    for (; more; more = next_element(m_pathname, pos, first, last))
+    {
+      if (!out.empty())
+        out += preferred_separator;
+      out.append(m_pathname, first, last - first);
+    }
+    return result;
+  }
+
+  path path::lexically_proximate(const path& base) const
+  {
+    path result(lexically_relative(base));
+    return result.empty() ? *this : result;
+  }
+
   // m_normalize  ----------------------------------------------------------------------//
 
   path& path::m_normalize()
@@ -507,7 +708,7 @@ namespace
       return end_pos-1;
     
     // set pos to start of last element
-    size_type pos(str.find_last_of(separators, end_pos-1));
+    size_type pos(fs::detail::find_last_separator(str.c_str(), end_pos));
 
 #   ifdef BOOST_WINDOWS_API
     if (pos == string_type::npos)
@@ -633,6 +834,101 @@ namespace
     return;
   }
 
+  //  root_name_size  ------------------------------------------------------------------//
+
+  size_type root_name_size(const string_type& str)
+  {
+    size_type element_pos, element_size;
+    first_element(str, element_pos, element_size);
+    if (element_size > 1 && is_separator(str[0]) && is_separator(str[1]))
+      return element_size;  // "//net"
+#   ifdef BOOST_WINDOWS_API
+    if (element_size && str[element_size-1] == colon)
+      return element_size;  // "c:"
+#   endif
+    return 0;
+  }
+
+  //  relative_path_start  -------------------------------------------------------------//
+
+  size_type relative_path_start(const string_type& str)
+  {
+    size_type pos(root_name_size(str));
+    while (pos < str.size() && is_separator(str[pos]))
+      ++pos;
+    return pos;
+  }
+
+  //  next_element  --------------------------------------------------------------------//
+
+  bool next_element(const string_type& str, size_type& pos,
+                    size_type& first, size_type& last)
+  {
+    if (pos >= str.size())
+      return false;
+    while (pos < str.size() && is_separator(str[pos]))
+      ++pos;
+    first = pos;
+    while (pos < str.size() && !is_separator(str[pos]))
+      ++pos;
+    last = pos;
+    return true;
+  }
+
+  //  hash_native helpers  -------------------------------------------------------------//
+  //   the mixing steps are those of Yann Collet's xxHash64
+
+  const boost::uint64_t prime1 = UINT64_C(11400714785074694791);
+  const boost::uint64_t prime2 = UINT64_C(14029467366897019727);
+  const boost::uint64_t prime3 = UINT64_C(1609587929392839161);
+  const boost::uint64_t prime4 = UINT64_C(9650029242287828579);
+  const boost::uint64_t prime5 = UINT64_C(2870177450012600261);
+
+  // number of value_type characters consumed per 64-bit word
+  const std::size_t word_chars = sizeof(boost::uint64_t) / sizeof(value_type);
+
+  inline boost::uint64_t rotl(boost::uint64_t x, int r)
+  {
+    return (x << r) | (x >> (64 - r));
+  }
+
+  inline boost::uint64_t hash_round(boost::uint64_t acc, boost::uint64_t input)
+  {
+    acc += input * prime2;
+    acc = rotl(acc, 31);
+    return acc * prime1;
+  }
+
+  inline boost::uint64_t hash_merge(boost::uint64_t acc, boost::uint64_t val)
+  {
+    acc ^= hash_round(0, val);
+    return acc * prime1 + prime4;
+  }
+
+  // Windows: slash and backslash must hash the same
+  inline value_type hash_char(value_type c)
+  {
+#   ifdef BOOST_WINDOWS_API
+    return c == L'/' ? L'\\' : c;
+#   else
+    return c;
+#   endif
+  }
+
+  inline boost::uint64_t load_word(const value_type* p)
+  {
+    boost::uint64_t w;
+#   ifdef BOOST_WINDOWS_API
+    value_type tmp[word_chars];
+    for (std::size_t i = 0; i != word_chars; ++i)
+      tmp[i] = hash_char(p[i]);
+    std::memcpy(&w, tmp, sizeof(w));
+#   else
+    std::memcpy(&w, p, sizeof(w));
+#   endif
+    return w;
+  }
+
 }  // unnamed namespace
 
 
@@ -642,6 +938,62 @@ namespace filesystem
 {
   namespace detail
   {
+    BOOST_FILESYSTEM_DECL
+      std::size_t hash_native(const path::value_type* s, std::size_t size) BOOST_NOEXCEPT
+    {
+      const value_type* p = s;
+      const value_type* const end = s + size;
+      boost::uint64_t h;
+
+      if (size >= 4 * word_chars)
+      {
+        // four independent lanes; the loop carries no dependency between them
+        boost::uint64_t v1 = prime1 + prime2;
+        boost::uint64_t v2 = prime2;
+        boost::uint64_t v3 = 0;
+        boost::uint64_t v4 = 0 - prime1;
+        const value_type* const limit = end - 4 * word_chars;
+        do
+        {
+          v1 = hash_round(v1, load_word(p));
+          v2 = hash_round(v2, load_word(p + word_chars));
+          v3 = hash_round(v3, load_word(p + 2 * word_chars));
+          v4 = hash_round(v4, load_word(p + 3 * word_chars));
+          p += 4 * word_chars;
+        } while (p <= limit);
+
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = hash_merge(h, v1);
+        h = hash_merge(h, v2);
+        h = hash_merge(h, v3);
+        h = hash_merge(h, v4);
+      }
+      else
+        h = prime5;
+
+      h += static_cast<boost::uint64_t>(size) * sizeof(value_type);
+
+      for (; end - p >= static_cast<std::ptrdiff_t>(word_chars); p += word_chars)
+      {
+        h ^= hash_round(0, load_word(p));
+        h = rotl(h, 27) * prime1 + prime4;
+      }
+
+      for (; p != end; ++p)
+      {
+        h ^= static_cast<boost::uint64_t>(hash_char(*p)) * prime5;
+        h = rotl(h, 11) * prime1;
+      }
+
+      // final avalanche
+      h ^= h >> 33;
+      h *= prime2;
+      h ^= h >> 29;
+      h *= prime3;
+      h ^= h >> 32;
+      return static_cast<std::size_t>(h);
+    }
+
     BOOST_FILESYSTEM_DECL
       int lex_compare(path::iterator first1, path::iterator last1,
         path::iterator first2, path::iterator last2)
@@ -796,80 +1148,142 @@ namespace
   //                              locale helpers                                        //
   //------------------------------------------------------------------------------------//
 
-#if defined(BOOST_WINDOWS_API) && defined(BOOST_FILESYSTEM_STATIC_LINK)
+  //  The path locale is published to readers as a single atomic pointer to an immutable
+  //  locale_holder, so codecvt() is one load, and imbue() is one exchange that readers
+  //  never wait for. A holder replaced by imbue() is never deleted, since references
+  //  returned by codecvt() may be held indefinitely. Instead every holder is kept on a
+  //  list, and imbue() reuses one whose locale compares equal to the one imbued, so
+  //  the memory held is one holder per distinct locale, not one per call. Switching
+  //  back to the locale imbue() returned costs nothing.
+  //
+  //  The default locale is created on first use, not during static initialization, so
+  //  path may be used by other translation units' static constructors, and so that
+  //  std::locale(""), which may throw, throws after main() starts and can be caught.
 
-  inline std::locale default_locale()
+  struct locale_holder
   {
-    std::locale global_loc = std::locale();
-    std::locale loc(global_loc, new windows_file_codecvt);
-    return loc;
-  }
+    explicit locale_holder(const std::locale& l)
+      : loc(l), facet(&std::use_facet<path::codecvt_type>(loc)),
+        utf8(fs::detail::is_utf8_locale(loc)), next(0) {}
+
+    std::locale                loc;
+    const path::codecvt_type*  facet;
+    bool                       utf8;  // facet is the standard library's UTF-8 facet
+    const locale_holder*       next;  // in all_locales
+  };
 
-  inline std::locale& path_locale()
+  //  constant initialized, so valid before any dynamic initialization
+  boost::atomic<const locale_holder*> current_locale(0);
+  boost::atomic<const locale_holder*> all_locales(0);  // every holder ever published
+
+  std::locale default_locale()
   {
-    static std::locale loc(default_locale());
-    return loc;
+# if defined(BOOST_WINDOWS_API)
+    return std::locale(std::locale(), new windows_file_codecvt);
+# elif defined(macintosh) || defined(__APPLE__) || defined(__APPLE_CC__)
+    // "All BSD system functions expect their string parameters to be in UTF-8 encoding
+    // and nothing else." See
+    // http://developer.apple.com/mac/library/documentation/MacOSX/Conceptual/BPInternational/Articles/FileEncodings.html
+    //
+    // "The kernel will reject any filename that is not a valid UTF-8 string, and it will
+    // even be normalized (to Unicode NFD) before stored on disk, at least when using HFS.
+    // The right way to deal with it would be to always convert the filename to UTF-8
+    // before trying to open/create a file." See
+    // http://lists.apple.com/archives/unix-porting/2007/Sep/msg00023.html
+    //
+    // "How a file name looks at the API level depends on the API. Current Carbon APIs
+    // handle file names as an array of UTF-16 characters; POSIX ones handle them as an
+    // array of UTF-8, which is why UTF-8 works well in Terminal. How it's stored on disk
+    // depends on the disk format; HFS+ uses UTF-16, but that's not important in most
+    // cases." See
+    // http://lists.apple.com/archives/applescript-users/2002/Sep/msg00319.html
+    //
+    // Many thanks to Peter Dimov for digging out the above references!
+    return std::locale(std::locale(), new boost::filesystem::detail::utf8_codecvt_facet);
+# else
+    // ISO C calls std::locale("") "the locale-specific native environment", and this
+    // locale is the default for many POSIX-based operating systems such as Linux.
+    return std::locale("");
+# endif
   }
 
-  inline const path::codecvt_type*& codecvt_facet_ptr()
+  void keep(locale_holder* holder)
   {
-    static const std::codecvt<wchar_t, char, std::mbstate_t>*
-     facet(
-       &std::use_facet<std::codecvt<wchar_t, char, std::mbstate_t> >
-        (path_locale()));
-    return facet;
+    const locale_holder* head = all_locales.load(boost::memory_order_relaxed);
+    do
+      holder->next = head;
+    while (!all_locales.compare_exchange_weak(head, holder,
+             boost::memory_order_release, boost::memory_order_relaxed));
   }
 
-#elif defined(BOOST_WINDOWS_API) && !defined(BOOST_FILESYSTEM_STATIC_LINK)
+  const locale_holder* initialize_locale()
+  {
+    locale_holder* fresh = new locale_holder(default_locale());
+    const locale_holder* expected = 0;
+    if (current_locale.compare_exchange_strong(expected, fresh,
+          boost::memory_order_acq_rel, boost::memory_order_acquire))
+    {
+      keep(fresh);
+      return fresh;
+    }
+    delete fresh;  // another thread won; fresh was never published
+    return expected;
+  }
 
-  std::locale path_locale(std::locale(), new windows_file_codecvt); 
+  //  Returns: a holder for a locale equal to loc, created if there is none. Two threads
+  //  imbuing the same new locale at once may both create one; both are kept.
+  const locale_holder* find_or_keep(const std::locale& loc)
+  {
+    for (const locale_holder* h = all_locales.load(boost::memory_order_acquire);
+         h; h = h->next)
+    {
+      if (h->loc == loc)
+        return h;
+    }
+    locale_holder* fresh = new locale_holder(loc);
+    keep(fresh);
+    return fresh;
+  }
 
-  const std::codecvt<wchar_t, char, std::mbstate_t>*
-    codecvt_facet_ptr(&std::use_facet<std::codecvt<wchar_t, char, std::mbstate_t> >
-      (path_locale));
+  //  per-thread override  --------------------------------------------------------------//
 
-#elif defined(macintosh) || defined(__APPLE__) || defined(__APPLE_CC__)
+  //  Only the owning thread reads or writes its override, so it needs no atomics, and
+  //  may be deleted when replaced. Without C++11 thread_local, an override still set
+  //  when its thread exits is leaked.
 
-  // "All BSD system functions expect their string parameters to be in UTF-8 encoding
-  // and nothing else." See
-  // http://developer.apple.com/mac/library/documentation/MacOSX/Conceptual/BPInternational/Articles/FileEncodings.html
-  //
-  // "The kernel will reject any filename that is not a valid UTF-8 string, and it will
-  // even be normalized (to Unicode NFD) before stored on disk, at least when using HFS.
-  // The right way to deal with it would be to always convert the filename to UTF-8
-  // before trying to open/create a file." See
-  // http://lists.apple.com/archives/unix-porting/2007/Sep/msg00023.html
-  //
-  // "How a file name looks at the API level depends on the API. Current Carbon APIs
-  // handle file names as an array of UTF-16 characters; POSIX ones handle them as an
-  // array of UTF-8, which is why UTF-8 works well in Terminal. How it's stored on disk
-  // depends on the disk format; HFS+ uses UTF-16, but that's not important in most
-  // cases." See
-  // http://lists.apple.com/archives/applescript-users/2002/Sep/msg00319.html
-  //
-  // Many thanks to Peter Dimov for digging out the above references!
+# if !defined(BOOST_NO_CXX11_THREAD_LOCAL)
 
-  std::locale path_locale(std::locale(),
-                          new boost::filesystem::detail::utf8_codecvt_facet);
+  struct thread_locale
+  {
+    const locale_holder* holder;
+    ~thread_locale() { delete holder; }
+  };
 
-  const std::codecvt<wchar_t, char, std::mbstate_t>*
-    codecvt_facet_ptr(&std::use_facet<std::codecvt<wchar_t, char, std::mbstate_t> >
-      (path_locale));
+  thread_local thread_locale this_thread_locale = { 0 };
 
-#else  // Other POSIX
+  inline const locale_holder*& thread_holder() { return this_thread_locale.holder; }
 
-  // ISO C calls std::locale("") "the locale-specific native environment", and this
-  // locale is the default for many POSIX-based operating systems such as Linux.
+# else
 
-  // std::locale("") construction can throw (if environmental variables LC_MESSAGES or
-  // or LANG are wrong, for example), so lazy initialization is used to ensure
-  // that exceptions occur after main() starts and so can be caught.
+#   if defined(_MSC_VER)
+  __declspec(thread) const locale_holder* this_thread_holder = 0;
+#   else
+  __thread const locale_holder* this_thread_holder = 0;
+#   endif
 
-  std::locale path_locale;  // initialized by path::codecvt() below
-  const std::codecvt<wchar_t, char, std::mbstate_t>* codecvt_facet_ptr;  // ditto
+  inline const locale_holder*& thread_holder() { return this_thread_holder; }
 
 # endif
 
+  inline const locale_holder* path_locale()
+  {
+    const locale_holder* holder = thread_holder();
+    if (holder)
+      return holder;
+    holder = current_locale.load(boost::memory_order_acquire);
+    return holder ? holder : initialize_locale();
+  }
+
 }  // unnamed namespace
 
 //--------------------------------------------------------------------------------------//
@@ -881,49 +1295,51 @@ namespace boost
 namespace filesystem
 {
 
-#if defined(BOOST_WINDOWS_API) && defined(BOOST_FILESYSTEM_STATIC_LINK)
-
   const path::codecvt_type& path::codecvt()
   {
-    BOOST_ASSERT_MSG(codecvt_facet_ptr(), "codecvt_facet_ptr() facet hasn't been properly initialized");
-    return *codecvt_facet_ptr();
+    return *path_locale()->facet;
   }
 
-  std::locale path::imbue(const std::locale & loc)
+  std::locale path::imbue(const std::locale& loc)
   {
-    std::locale temp(path_locale());
-    path_locale() = loc;
-    codecvt_facet_ptr() =
-      &std::use_facet<std::codecvt<wchar_t, char, std::mbstate_t> >(path_locale());
-    return temp;
+    //  Before the first conversion, the locale in effect is the default that would
+    //  have been created; it is returned, but not kept. If the environment names no
+    //  valid locale, so creating it would have thrown, the global locale is returned.
+    std::locale previous;
+    if (!current_locale.load(boost::memory_order_acquire))
+    {
+      try { previous = default_locale(); }
+      catch (const std::runtime_error&) {}
+    }
+    const locale_holder* old
+      = current_locale.exchange(find_or_keep(loc), boost::memory_order_acq_rel);
+    return old ? old->loc : previous;
   }
 
-#else
-
-  const path::codecvt_type& path::codecvt()
+  void path::imbue_thread(const std::locale& loc)
   {
-#   if defined(BOOST_POSIX_API) && \
-      !(defined(macintosh) || defined(__APPLE__) || defined(__APPLE_CC__))
-      // A local static initialized by calling path::imbue ensures that std::locale(""),
-      // which may throw, is called only if path_locale and condecvt_facet will actually
-      // be used. Thus misconfigured environmental variables will only cause an
-      // exception if a valid std::locale("") is actually needed.
-      static std::locale posix_lazy_initialization(path::imbue(std::locale("")));
-#   endif
-    return *codecvt_facet_ptr;
+    const locale_holder* fresh = new locale_holder(loc);
+    delete thread_holder();
+    thread_holder() = fresh;
   }
 
-  std::locale path::imbue(const std::locale& loc)
+  void path::reset_thread_locale()
   {
-    std::locale temp(path_locale);
-    path_locale = loc;
-    codecvt_facet_ptr =
-      &std::use_facet<std::codecvt<wchar_t, char, std::mbstate_t> >(path_locale);
-    return temp;
+    delete thread_holder();
+    thread_holder() = 0;
   }
 
-
-#endif
+  namespace detail
+  {
+    bool is_utf8_codecvt(const path_traits::codecvt_type& cvt)
+    {
+      const locale_holder* holder = thread_holder();
+      if (!holder)
+        holder = current_locale.load(boost::memory_order_acquire);
+      return (holder && holder->utf8 && holder->facet == &cvt)
+        || dynamic_cast<const utf8_codecvt_facet*>(&cvt) != 0;
+    }
+  }
 
 }  // namespace filesystem
 }  // namespace boost
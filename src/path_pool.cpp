@@ -0,0 +1,320 @@
+//  filesystem path_pool.cpp  ----------------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//--------------------------------------------------------------------------------------//
+
+// define BOOST_FILESYSTEM_SOURCE so that <boost/filesystem/config.hpp> knows
+// the library is being built (possibly exporting rather than importing code)
+#define BOOST_FILESYSTEM_SOURCE
+
+#ifndef BOOST_SYSTEM_NO_DEPRECATED
+# define BOOST_SYSTEM_NO_DEPRECATED
+#endif
+
+#include <boost/filesystem/path_pool.hpp>
+#include <boost/assert.hpp>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+
+using boost::filesystem::path;
+using boost::filesystem::path_pool;
+using boost::system::error_code;
+using boost::uint32_t;
+using boost::uint64_t;
+
+namespace
+{
+  typedef path::value_type  value_type;
+
+  const std::size_t initial_table_size = 64;  // power of 2
+  const uint32_t max_id = 0xFFFFFFFFu;
+
+  inline bool is_separator(value_type c)
+  {
+    return c == '/'
+#     ifdef BOOST_WINDOWS_API
+      || c == path::preferred_separator
+#     endif
+      ;
+  }
+
+  inline std::size_t node_hash(uint32_t parent, uint32_t name)
+  {
+    // 64-bit finalizer from MurmurHash3
+    uint64_t k = (static_cast<uint64_t>(parent) << 32) | name;
+    k ^= k >> 33;
+    k *= UINT64_C(0xff51afd7ed558ccd);
+    k ^= k >> 33;
+    k *= UINT64_C(0xc4ceb9fe1a85ec53);
+    k ^= k >> 33;
+    return static_cast<std::size_t>(k);
+  }
+
+  void too_many(const char* what)
+  {
+    BOOST_FILESYSTEM_THROW(std::length_error(
+      std::string("boost::filesystem::path_pool: too many ") + what));
+  }
+
+}  // unnamed namespace
+
+namespace boost
+{
+namespace filesystem
+{
+
+  path_pool::path_pool()
+  {
+    clear();
+  }
+
+  void path_pool::clear()
+  {
+    node root = {0, 0};
+    m_nodes.assign(1, root);
+    m_node_table.assign(initial_table_size, 0);
+    m_chars.clear();
+    m_name_offsets.assign(2, 0);  // name 0 is the empty name
+    m_name_table.assign(initial_table_size, 0);
+  }
+
+  void path_pool::swap(path_pool& rhs)
+  {
+    m_nodes.swap(rhs.m_nodes);
+    m_node_table.swap(rhs.m_node_table);
+    m_chars.swap(rhs.m_chars);
+    m_name_offsets.swap(rhs.m_name_offsets);
+    m_name_table.swap(rhs.m_name_table);
+  }
+
+  //  interning  -----------------------------------------------------------------------//
+
+  path_pool::handle path_pool::intern(const path& p)
+  {
+    return intern(handle(), p);
+  }
+
+  path_pool::handle path_pool::intern(handle base, const path& relative)
+  {
+    BOOST_ASSERT_MSG(base.m_id < m_nodes.size(), "handle is not from this path_pool");
+    uint32_t id = base.m_id;
+    for (path::iterator itr = relative.begin(); itr != relative.end(); ++itr)
+      id = m_intern_node(id, m_intern_name(itr->c_str(), itr->native().size()));
+    return handle(id);
+  }
+
+  uint32_t path_pool::m_intern_name(const value_type* s, std::size_t size)
+  {
+    BOOST_ASSERT(size);
+    if ((m_name_offsets.size() - 1) * 2 >= m_name_table.size())
+      m_grow_name_table();
+
+    std::size_t mask = m_name_table.size() - 1;
+    for (std::size_t i = detail::hash_native(s, size) & mask;; i = (i + 1) & mask)
+    {
+      uint32_t id = m_name_table[i];
+      if (id == 0)  // not found, so add it
+      {
+        if (m_chars.size() + size > max_id || m_name_offsets.size() - 1 == max_id)
+          too_many("name characters");
+        m_chars.append(s, size);
+        m_name_offsets.push_back(static_cast<uint32_t>(m_chars.size()));
+        id = static_cast<uint32_t>(m_name_offsets.size() - 2);
+        m_name_table[i] = id;
+        return id;
+      }
+      if (detail::native_equal(m_chars.data() + m_name_offsets[id],
+            m_name_offsets[id+1] - m_name_offsets[id], s, size))
+        return id;
+    }
+  }
+
+  uint32_t path_pool::m_intern_node(uint32_t parent, uint32_t name)
+  {
+    if (m_nodes.size() * 2 >= m_node_table.size())
+      m_grow_node_table();
+
+    std::size_t mask = m_node_table.size() - 1;
+    for (std::size_t i = node_hash(parent, name) & mask;; i = (i + 1) & mask)
+    {
+      uint32_t id = m_node_table[i];
+      if (id == 0)  // not found, so add it
+      {
+        if (m_nodes.size() == max_id)
+          too_many("paths");
+        node n = {parent, name};
+        m_nodes.push_back(n);
+        id = static_cast<uint32_t>(m_nodes.size() - 1);
+        m_node_table[i] = id;
+        return id;
+      }
+      if (m_nodes[id].parent == parent && m_nodes[id].name == name)
+        return id;
+    }
+  }
+
+  void path_pool::m_grow_name_table()
+  {
+    std::vector<uint32_t> table(m_name_table.size() * 2, 0);
+    std::size_t mask = table.size() - 1;
+    for (uint32_t id = 1; id < m_name_offsets.size() - 1; ++id)
+    {
+      std::size_t i = detail::hash_native(m_chars.data() + m_name_offsets[id],
+        m_name_offsets[id+1] - m_name_offsets[id]) & mask;
+      for (; table[i]; i = (i + 1) & mask) {}
+      table[i] = id;
+    }
+    m_name_table.swap(table);
+  }
+
+  void path_pool::m_grow_node_table()
+  {
+    std::vector<uint32_t> table(m_node_table.size() * 2, 0);
+    std::size_t mask = table.size() - 1;
+    for (uint32_t id = 1; id < m_nodes.size(); ++id)
+    {
+      std::size_t i = node_hash(m_nodes[id].parent, m_nodes[id].name) & mask;
+      for (; table[i]; i = (i + 1) & mask) {}
+      table[i] = id;
+    }
+    m_node_table.swap(table);
+  }
+
+  path_pool::handle path_pool::m_intern_directory(const path& dir,
+    std::vector<handle>& entries, bool recursive, system::error_code* ec)
+  {
+    if (ec != 0)
+      ec->clear();
+    handle dir_handle(intern(dir));
+
+    if (!recursive)
+    {
+      directory_iterator itr, end;
+      if (ec == 0)
+        itr = directory_iterator(dir);
+      else
+      {
+        itr = directory_iterator(dir, *ec);
+        if (*ec)
+          return dir_handle;
+      }
+
+      while (itr != end)
+      {
+        entries.push_back(intern(dir_handle, *itr));
+        if (ec == 0)
+          ++itr;
+        else
+        {
+          itr.increment(*ec);
+          if (*ec)
+            return dir_handle;
+        }
+      }
+    }
+    else
+    {
+      recursive_directory_iterator itr, end;
+      if (ec == 0)
+        itr = recursive_directory_iterator(dir);
+      else
+      {
+        itr = recursive_directory_iterator(dir, *ec);
+        if (*ec)
+          return dir_handle;
+      }
+
+      // dirs[n] is the handle of the directory being iterated at depth n
+      std::vector<handle> dirs(1, dir_handle);
+      while (itr != end)
+      {
+        std::size_t depth = static_cast<std::size_t>(itr.depth());
+        dirs.resize(depth + 1);
+        handle h(intern(dirs[depth], *itr));
+        entries.push_back(h);
+        dirs.push_back(h);  // in case itr recurses into it
+        if (ec == 0)
+          ++itr;
+        else
+        {
+          itr.increment(*ec);
+          if (*ec)
+            return dir_handle;
+        }
+      }
+    }
+    return dir_handle;
+  }
+
+  //  observers  -----------------------------------------------------------------------//
+
+  bool path_pool::m_needs_separator(const node& n) const
+  {
+    // a separator goes between two elements unless one is already present, or
+    // (Windows) the parent ends in a drive spec; this is the operator/= logic
+    if (n.parent == 0)
+      return false;
+    value_type last = m_chars[m_name_offsets[m_nodes[n.parent].name+1] - 1];
+    value_type first = m_chars[m_name_offsets[n.name]];
+    return !is_separator(last) && !is_separator(first)
+#     ifdef BOOST_WINDOWS_API
+      && last != L':'
+#     endif
+      ;
+  }
+
+  path path_pool::to_path(handle h) const
+  {
+    BOOST_ASSERT_MSG(h.m_id < m_nodes.size(), "handle is not from this path_pool");
+
+    // first pass computes the exact length, second pass fills from the back
+    std::size_t length = 0;
+    for (uint32_t id = h.m_id; id; id = m_nodes[id].parent)
+    {
+      const node& n = m_nodes[id];
+      length += m_name_offsets[n.name+1] - m_name_offsets[n.name];
+      if (m_needs_separator(n))
+        ++length;
+    }
+
+    path result;
+    path::string_type& s(result.m_pathname);
+    s.resize(length);
+    std::size_t pos = length;
+    for (uint32_t id = h.m_id; id; id = m_nodes[id].parent)
+    {
+      const node& n = m_nodes[id];
+      std::size_t size = m_name_offsets[n.name+1] - m_name_offsets[n.name];
+      pos -= size;
+      std::memcpy(&s[pos], m_chars.data() + m_name_offsets[n.name],
+        size * sizeof(value_type));
+      if (m_needs_separator(n))
+        s[--pos] = path::preferred_separator;
+    }
+    BOOST_ASSERT(pos == 0);
+    return result;
+  }
+
+  path path_pool::filename(handle h) const
+  {
+    BOOST_ASSERT_MSG(h.m_id < m_nodes.size(), "handle is not from this path_pool");
+    const node& n = m_nodes[h.m_id];
+    return path(path::string_type(m_chars.data() + m_name_offsets[n.name],
+      m_chars.data() + m_name_offsets[n.name+1]));
+  }
+
+  path_pool::handle path_pool::parent(handle h) const BOOST_NOEXCEPT
+  {
+    BOOST_ASSERT_MSG(h.m_id < m_nodes.size(), "handle is not from this path_pool");
+    return handle(m_nodes[h.m_id].parent);
+  }
+
+}  // namespace filesystem
+}  // namespace boost
@@ -0,0 +1,239 @@
+//  filesystem path_scan.cpp  ----------------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+// define BOOST_FILESYSTEM_SOURCE so that <boost/filesystem/config.hpp> knows
+// the library is being built (possibly exporting rather than importing code)
+#define BOOST_FILESYSTEM_SOURCE
+
+#ifndef BOOST_SYSTEM_NO_DEPRECATED
+# define BOOST_SYSTEM_NO_DEPRECATED
+#endif
+
+#include "path_scan.hpp"
+#include <boost/type_traits/make_unsigned.hpp>
+
+//  SSE2 is part of the x86-64 baseline, so it needs no runtime check. AVX2 kernels are
+//  compiled with a function target attribute and selected at runtime, so the library
+//  itself does not have to be built with -mavx2.
+
+#if !defined(BOOST_FILESYSTEM_NO_SIMD)
+# if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define BOOST_FILESYSTEM_SCAN_SSE2
+#   include <emmintrin.h>
+#   ifdef _MSC_VER
+#     include <intrin.h>  // _BitScanReverse
+#   endif
+# endif
+# if defined(BOOST_FILESYSTEM_SCAN_SSE2) && (defined(__x86_64__) || defined(__i386__)) \
+    && (defined(__clang__) \
+      || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#   define BOOST_FILESYSTEM_SCAN_AVX2
+#   include <immintrin.h>
+# endif
+#endif
+
+using boost::filesystem::path;
+using boost::filesystem::detail::scan_npos;
+
+namespace
+{
+  typedef path::value_type value_type;
+
+  inline bool is_separator(value_type c)
+  {
+    return c == '/'
+#     ifdef BOOST_WINDOWS_API
+      || c == '\\'
+#     endif
+      ;
+  }
+
+  //  scalar kernel  -------------------------------------------------------------------//
+
+  inline std::size_t scalar_last_of(const value_type* s, std::size_t n,
+    value_type c1, value_type c2)
+  {
+    while (n--)
+    {
+      if (s[n] == c1 || s[n] == c2)
+        return n;
+    }
+    return scan_npos;
+  }
+
+#ifdef BOOST_FILESYSTEM_SCAN_SSE2
+
+  inline unsigned highest_bit(unsigned m)  // m != 0
+  {
+#   ifdef _MSC_VER
+    unsigned long i;
+    _BitScanReverse(&i, m);
+    return i;
+#   else
+    return 31 - __builtin_clz(m);
+#   endif
+  }
+
+  //  SSE2 kernel  ---------------------------------------------------------------------//
+
+  //  Scans backward a block at a time. The match mask has one bit per byte, so for
+  //  16-bit characters each match sets two bits and the bit index is halved.
+
+  std::size_t sse2_last_of(const value_type* s, std::size_t n,
+    value_type c1, value_type c2)
+  {
+    const std::size_t width = 16 / sizeof(value_type);
+#   ifdef BOOST_WINDOWS_API
+    const __m128i v1 = _mm_set1_epi16(static_cast<short>(c1));
+    const __m128i v2 = _mm_set1_epi16(static_cast<short>(c2));
+#   else
+    const __m128i v1 = _mm_set1_epi8(c1);
+    const __m128i v2 = _mm_set1_epi8(c2);
+#   endif
+
+    while (n >= width)
+    {
+      n -= width;
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + n));
+#     ifdef BOOST_WINDOWS_API
+      __m128i eq = _mm_or_si128(_mm_cmpeq_epi16(v, v1), _mm_cmpeq_epi16(v, v2));
+#     else
+      __m128i eq = _mm_or_si128(_mm_cmpeq_epi8(v, v1), _mm_cmpeq_epi8(v, v2));
+#     endif
+      unsigned m = static_cast<unsigned>(_mm_movemask_epi8(eq));
+      if (m)
+        return n + highest_bit(m) / sizeof(value_type);
+    }
+    return scalar_last_of(s, n, c1, c2);
+  }
+
+#endif  // BOOST_FILESYSTEM_SCAN_SSE2
+
+#ifdef BOOST_FILESYSTEM_SCAN_AVX2
+
+  //  AVX2 kernel  ---------------------------------------------------------------------//
+
+  __attribute__((target("avx2")))
+  std::size_t avx2_last_of(const value_type* s, std::size_t n,
+    value_type c1, value_type c2)
+  {
+    const std::size_t width = 32 / sizeof(value_type);
+#   ifdef BOOST_WINDOWS_API
+    const __m256i v1 = _mm256_set1_epi16(static_cast<short>(c1));
+    const __m256i v2 = _mm256_set1_epi16(static_cast<short>(c2));
+#   else
+    const __m256i v1 = _mm256_set1_epi8(c1);
+    const __m256i v2 = _mm256_set1_epi8(c2);
+#   endif
+
+    while (n >= width)
+    {
+      n -= width;
+      __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + n));
+#     ifdef BOOST_WINDOWS_API
+      __m256i eq = _mm256_or_si256(_mm256_cmpeq_epi16(v, v1), _mm256_cmpeq_epi16(v, v2));
+#     else
+      __m256i eq = _mm256_or_si256(_mm256_cmpeq_epi8(v, v1), _mm256_cmpeq_epi8(v, v2));
+#     endif
+      unsigned m = static_cast<unsigned>(_mm256_movemask_epi8(eq));
+      if (m)
+        return n + highest_bit(m) / sizeof(value_type);
+    }
+    return sse2_last_of(s, n, c1, c2);
+  }
+
+  bool cpu_has_avx2()
+  {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+  }
+
+#endif  // BOOST_FILESYSTEM_SCAN_AVX2
+
+  //  dispatch  ------------------------------------------------------------------------//
+
+  //  Short strings go straight to the scalar kernel; most path elements are short
+  //  and the vector setup would not pay for itself.
+
+  inline std::size_t last_of(const value_type* s, std::size_t n,
+    value_type c1, value_type c2)
+  {
+#   ifdef BOOST_FILESYSTEM_SCAN_AVX2
+    if (n >= 32 / sizeof(value_type))
+    {
+      static const bool avx2 = cpu_has_avx2();
+      if (avx2)
+        return avx2_last_of(s, n, c1, c2);
+    }
+#   endif
+#   ifdef BOOST_FILESYSTEM_SCAN_SSE2
+    if (n >= 16 / sizeof(value_type))
+      return sse2_last_of(s, n, c1, c2);
+#   endif
+    return scalar_last_of(s, n, c1, c2);
+  }
+
+}  // unnamed namespace
+
+namespace boost
+{
+namespace filesystem
+{
+namespace detail
+{
+
+  std::size_t find_last_separator(const path::value_type* s, std::size_t n)
+  {
+#   ifdef BOOST_WINDOWS_API
+    return last_of(s, n, L'/', L'\\');
+#   else
+    return last_of(s, n, '/', '/');
+#   endif
+  }
+
+  std::size_t find_last_dot(const path::value_type* s, std::size_t n)
+  {
+    return last_of(s, n, '.', '.');
+  }
+
+  int compare_tree_order(const path::value_type* lhs, std::size_t lhs_size,
+    const path::value_type* rhs, std::size_t rhs_size)
+  {
+    typedef boost::make_unsigned<value_type>::type unsigned_type;
+    std::size_t n = lhs_size < rhs_size ? lhs_size : rhs_size;
+    for (std::size_t i = 0; i != n; ++i)
+    {
+      if (lhs[i] == rhs[i])
+        continue;
+      if (is_separator(lhs[i]) != is_separator(rhs[i]))
+        return is_separator(lhs[i]) ? -1 : 1;
+      if (is_separator(lhs[i]))  // Windows: '/' and '\\' are equivalent
+        continue;
+      return static_cast<unsigned_type>(lhs[i]) < static_cast<unsigned_type>(rhs[i])
+        ? -1 : 1;
+    }
+    return lhs_size < rhs_size ? -1 : lhs_size > rhs_size ? 1 : 0;
+  }
+
+  bool is_at_or_below(const path& p, const path& prefix)
+  {
+    const path::string_type& s(p.native());
+    const path::string_type& pre(prefix.native());
+    if (s.size() < pre.size()
+      || !native_equal(s.c_str(), pre.size(), pre.c_str(), pre.size()))
+      return false;
+    return s.size() == pre.size()
+      || pre.empty()
+      || is_separator(pre[pre.size()-1])
+      || is_separator(s[pre.size()]);
+  }
+
+}  // namespace detail
+}  // namespace filesystem
+}  // namespace boost
@@ -0,0 +1,52 @@
+//  filesystem path_scan.hpp  ----------------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//  Character scanning kernels used by the path decomposition functions. Private to the
+//  library implementation.
+
+#ifndef BOOST_FILESYSTEM3_PATH_SCAN_HPP
+#define BOOST_FILESYSTEM3_PATH_SCAN_HPP
+
+#include <boost/filesystem/config.hpp>
+#include <boost/filesystem/path.hpp>
+#include <cstddef>
+
+//  Define BOOST_FILESYSTEM_NO_SIMD to use only the portable scalar kernels.
+
+namespace boost
+{
+namespace filesystem
+{
+namespace detail
+{
+  const std::size_t scan_npos = static_cast<std::size_t>(-1);
+
+  //  Returns: position of the last directory separator in [s, s+n), or scan_npos.
+  //  Windows: slash or backslash
+  std::size_t find_last_separator(const path::value_type* s, std::size_t n);
+
+  //  Returns: position of the last dot in [s, s+n), or scan_npos.
+  std::size_t find_last_dot(const path::value_type* s, std::size_t n);
+
+  //  Returns: true if p is prefix or a path below it, judged lexically; used by the
+  //  caches to invalidate a directory and everything cached under it.
+  bool is_at_or_below(const path& p, const path& prefix);
+
+  //  Returns: <0, 0 or >0 as [lhs, lhs+lhs_size) orders before, with or after
+  //  [rhs, rhs+rhs_size), comparing code units except that separators order before
+  //  any other character. In that order a directory is immediately followed by
+  //  everything below it.
+  int compare_tree_order(const path::value_type* lhs, std::size_t lhs_size,
+    const path::value_type* rhs, std::size_t rhs_size);
+
+}  // namespace detail
+}  // namespace filesystem
+}  // namespace boost
+
+#endif  // BOOST_FILESYSTEM3_PATH_SCAN_HPP
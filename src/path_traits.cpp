@@ -20,101 +20,98 @@
 #include <boost/filesystem/config.hpp>
 #include <boost/filesystem/path_traits.hpp>
 #include <boost/system/system_error.hpp>
-#include <boost/scoped_array.hpp>
+#include "utf8_transcode.hpp"
 #include <locale>   // for codecvt_base::result
 #include <cstring>  // for strlen
 #include <cwchar>   // for wcslen
+#include <string>
 
 namespace pt = boost::filesystem::path_traits;
 namespace fs = boost::filesystem;
 namespace bs = boost::system;
 
-//--------------------------------------------------------------------------------------//
-//                                  configuration                                       //
-//--------------------------------------------------------------------------------------//
-
-#ifndef BOOST_FILESYSTEM_CODECVT_BUF_SIZE
-# define BOOST_FILESYSTEM_CODECVT_BUF_SIZE 256
-#endif
-
 namespace {
 
-  const std::size_t default_codecvt_buf_size = BOOST_FILESYSTEM_CODECVT_BUF_SIZE;
-
-
 //--------------------------------------------------------------------------------------//
 //                                                                                      //
-//  The public convert() functions do buffer management, and then forward to the        //
-//  convert_aux() functions for the actual call to the codecvt facet.                   //
+//  The public convert() functions forward to convert_aux(), which calls the codecvt    //
+//  facet to write directly into the target string.                                     //
 //                                                                                      //
 //--------------------------------------------------------------------------------------//
 
-//--------------------------------------------------------------------------------------//
-//                      convert_aux const char* to wstring                             //
-//--------------------------------------------------------------------------------------//
-
-  void convert_aux(
-                   const char* from,
-                   const char* from_end,
-                   wchar_t* to, wchar_t* to_end,
-                   std::wstring & target,
-                   const pt::codecvt_type & cvt)
+  inline std::codecvt_base::result
+  do_convert(const pt::codecvt_type& cvt, std::mbstate_t& state,
+    const char* from, const char* from_end, const char*& from_next,
+    wchar_t* to, wchar_t* to_end, wchar_t*& to_next)
   {
-    //std::cout << std::hex
-    //          << " from=" << std::size_t(from)
-    //          << " from_end=" << std::size_t(from_end)
-    //          << " to=" << std::size_t(to)
-    //          << " to_end=" << std::size_t(to_end)
-    //          << std::endl;
-
-    std::mbstate_t state  = std::mbstate_t();  // perhaps unneeded, but cuts bug reports
-    const char* from_next;
-    wchar_t* to_next;
-
-    std::codecvt_base::result res;
+    return cvt.in(state, from, from_end, from_next, to, to_end, to_next);
+  }
 
-    if ((res=cvt.in(state, from, from_end, from_next,
-           to, to_end, to_next)) != std::codecvt_base::ok)
-    {
-      //std::cout << " result is " << static_cast<int>(res) << std::endl;
-      BOOST_FILESYSTEM_THROW(bs::system_error(res, fs::codecvt_error_category(),
-        "boost::filesystem::path codecvt to wstring"));
-    }
-    target.append(to, to_next); 
+  inline std::codecvt_base::result
+  do_convert(const pt::codecvt_type& cvt, std::mbstate_t& state,
+    const wchar_t* from, const wchar_t* from_end, const wchar_t*& from_next,
+    char* to, char* to_end, char*& to_next)
+  {
+    return cvt.out(state, from, from_end, from_next, to, to_end, to_next);
   }
 
+  //  A partial result that leaves fewer than min_room elements of output space means
+  //  the space ran out, rather than that the input ended within a character.
+  const std::size_t min_room = 16;
+
 //--------------------------------------------------------------------------------------//
-//                      convert_aux const wchar_t* to string                           //
+//                                    convert_aux                                       //
 //--------------------------------------------------------------------------------------//
 
-  void convert_aux(
-                   const wchar_t* from,
-                   const wchar_t* from_end,
-                   char* to, char* to_end,
-                   std::string & target,
-                   const pt::codecvt_type & cvt)
+  //  Appends the conversion of [from, from_end) to target. target is first grown by
+  //  first_size elements and the facet writes into that space. If the facet stops
+  //  because the space ran out, target is grown by growth elements per remaining input
+  //  element, and conversion resumes with the same state. Finally target is trimmed to
+  //  the converted size. Any other result than ok is reported as an error, with target
+  //  restored.
+
+  template <class From, class To>
+  void convert_aux(const From* from, const From* from_end,
+                   std::basic_string<To>& target,
+                   std::size_t first_size, std::size_t growth,
+                   const pt::codecvt_type& cvt, const char* what)
   {
-    //std::cout << std::hex
-    //          << " from=" << std::size_t(from)
-    //          << " from_end=" << std::size_t(from_end)
-    //          << " to=" << std::size_t(to)
-    //          << " to_end=" << std::size_t(to_end)
-    //          << std::endl;
-
-    std::mbstate_t state  = std::mbstate_t();  // perhaps unneeded, but cuts bug reports
-    const wchar_t* from_next;
-    char* to_next;
+    const std::size_t old_size = target.size();
+    std::size_t size = old_size;  // target elements converted so far
+    std::mbstate_t state = std::mbstate_t();  // perhaps unneeded, but cuts bug reports
 
-    std::codecvt_base::result res;
-
-    if ((res=cvt.out(state, from, from_end, from_next,
-           to, to_end, to_next)) != std::codecvt_base::ok)
+    //  at least min_room, so a partial result that leaves less made progress
+    target.resize(old_size + (first_size > min_room ? first_size : min_room));
+    for (;;)
     {
-      //std::cout << " result is " << static_cast<int>(res) << std::endl;
-      BOOST_FILESYSTEM_THROW(bs::system_error(res, fs::codecvt_error_category(),
-        "boost::filesystem::path codecvt to string"));
+      To* to = &target[0] + size;
+      To* to_end = &target[0] + target.size();
+      const From* from_next = from;  // in case the facet does not set them
+      To* to_next = to;
+
+      std::codecvt_base::result res = do_convert(cvt, state,
+        from, from_end, from_next, to, to_end, to_next);
+
+      if (res == std::codecvt_base::ok)
+      {
+        size += to_next - to;
+        break;
+      }
+      if (res == std::codecvt_base::partial && from_next != from_end
+        && from_next >= from && to_next >= to && to_next <= to_end
+        && static_cast<std::size_t>(to_end - to_next) < min_room)
+      {
+        size += to_next - to;
+        from = from_next;
+        target.resize(size + (from_end - from) * growth + min_room);
+        continue;
+      }
+
+      target.resize(old_size);
+      BOOST_FILESYSTEM_THROW(bs::system_error(res, fs::codecvt_error_category(), what));
+      return;
     }
-    target.append(to, to_next); 
+    target.resize(size);
   }
   
 }  // unnamed namespace
@@ -144,19 +141,15 @@ namespace boost { namespace filesystem { namespace path_traits {
 
     if (from == from_end) return;
 
-    std::size_t buf_size = (from_end - from) * 3;  // perhaps too large, but that's OK
+    if (fs::detail::is_utf8_codecvt(cvt)
+      && fs::detail::utf8_to_wide(from, from_end, to))
+      return;
 
-    //  dynamically allocate a buffer only if source is unusually large
-    if (buf_size > default_codecvt_buf_size)
-    {
-      boost::scoped_array< wchar_t > buf(new wchar_t [buf_size]);
-      convert_aux(from, from_end, buf.get(), buf.get()+buf_size, to, cvt);
-    }
-    else
-    {
-      wchar_t buf[default_codecvt_buf_size];
-      convert_aux(from, from_end, buf, buf+default_codecvt_buf_size, to, cvt);
-    }
+    //  a wchar_t per byte is enough for most encodings, plus a little room since some
+    //  facets need space beyond the result; if not, space is added for up to three
+    //  per remaining byte
+    convert_aux(from, from_end, to, (from_end - from) + 4, 3, cvt,
+      "boost::filesystem::path codecvt to wstring");
   }
 
 //--------------------------------------------------------------------------------------//
@@ -178,23 +171,14 @@ namespace boost { namespace filesystem { namespace path_traits {
 
     if (from == from_end) return;
 
-    //  The codecvt length functions may not be implemented, and I don't really
-    //  understand them either. Thus this code is just a guess; if it turns
-    //  out the buffer is too small then an error will be reported and the code
-    //  will have to be fixed.
-    std::size_t buf_size = (from_end - from) * 4;  // perhaps too large, but that's OK
-    buf_size += 4;  // encodings like shift-JIS need some prefix space
+    if (fs::detail::is_utf8_codecvt(cvt)
+      && fs::detail::wide_to_utf8(from, from_end, to))
+      return;
 
-    //  dynamically allocate a buffer only if source is unusually large
-    if (buf_size > default_codecvt_buf_size)
-    {
-      boost::scoped_array< char > buf(new char [buf_size]);
-      convert_aux(from, from_end, buf.get(), buf.get()+buf_size, to, cvt);
-    }
-    else
-    {
-      char buf[default_codecvt_buf_size];
-      convert_aux(from, from_end, buf, buf+default_codecvt_buf_size, to, cvt);
-    }
+    //  The codecvt length functions may not be implemented, so the first guess is a
+    //  byte per wchar_t, plus some prefix space for encodings like shift-JIS; if not
+    //  enough, space is added for up to four bytes per remaining wchar_t.
+    convert_aux(from, from_end, to, (from_end - from) + 4, 4, cvt,
+      "boost::filesystem::path codecvt to string");
   }
 }}} // namespace boost::filesystem::path_traits
@@ -0,0 +1,300 @@
+//  filesystem status_cache.cpp  -------------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//--------------------------------------------------------------------------------------//
+
+// define BOOST_FILESYSTEM_SOURCE so that <boost/filesystem/config.hpp> knows
+// the library is being built (possibly exporting rather than importing code)
+#define BOOST_FILESYSTEM_SOURCE
+
+#ifndef BOOST_SYSTEM_NO_DEPRECATED
+# define BOOST_SYSTEM_NO_DEPRECATED
+#endif
+
+#include <boost/filesystem/status_cache.hpp>
+#include "path_scan.hpp"
+#include <boost/detail/lightweight_mutex.hpp>
+#include <boost/unordered_map.hpp>
+#include <deque>
+#include <utility>
+
+#ifdef BOOST_POSIX_API
+# include <cerrno>
+#else
+# include <windows.h>
+#endif
+
+using boost::filesystem::path;
+using boost::system::error_code;
+using boost::system::system_category;
+
+namespace boost
+{
+namespace filesystem
+{
+
+  struct status_cache::shard
+  {
+    struct entry
+    {
+      file_metadata      md;
+      error_code         ec;         // set only for file_type::not_found
+      clock::time_point  inserted;   // only if there is a ttl
+      boost::uintmax_t   sequence;   // identifies the matching order element
+    };
+
+    typedef boost::unordered_map<path, entry, path_hash, path_equal_to> map_type;
+
+    boost::detail::lightweight_mutex  mutex;
+    map_type           map;
+    std::deque<std::pair<path, boost::uintmax_t> >
+                       order;  // insertion order, oldest first; may be stale
+    std::size_t        max_entries;
+    boost::uintmax_t   hits;
+    boost::uintmax_t   misses;
+    boost::uintmax_t   sequence;
+    boost::uintmax_t   generation;  // incremented by clear() and invalidate()
+
+    shard() : max_entries(1), hits(0), misses(0), sequence(0), generation(0) {}
+
+    void make_room()
+    {
+      // discard the oldest entries; order elements whose sequence no longer matches
+      // the map were invalidated or replaced and are skipped
+      while (map.size() >= max_entries && !order.empty())
+      {
+        map_type::iterator it(map.find(order.front().first));
+        if (it != map.end() && it->second.sequence == order.front().second)
+          map.erase(it);
+        order.pop_front();
+      }
+
+      // keep stale elements from accumulating without bound
+      if (order.size() > 2 * max_entries)
+      {
+        std::deque<std::pair<path, boost::uintmax_t> > fresh;
+        for (std::size_t i = 0; i != order.size(); ++i)
+        {
+          map_type::const_iterator it(map.find(order[i].first));
+          if (it != map.end() && it->second.sequence == order[i].second)
+            fresh.push_back(order[i]);
+        }
+        order.swap(fresh);
+      }
+    }
+  };
+
+  status_cache::status_cache(clock::duration ttl, std::size_t max_entries,
+    std::size_t shards)
+    : m_shard_count(shards ? shards : 1),
+      m_max_entries(max_entries ? max_entries : 1), m_ttl(ttl)
+  {
+    m_shards.reset(new shard[m_shard_count]);
+    std::size_t per_shard((m_max_entries + m_shard_count - 1) / m_shard_count);
+    for (std::size_t i = 0; i != m_shard_count; ++i)
+      m_shards[i].max_entries = per_shard;
+  }
+
+  status_cache::~status_cache() {}
+
+  status_cache::shard& status_cache::m_shard(const path& p) const
+  {
+    return m_shards[path_hash()(p) % m_shard_count];
+  }
+
+  void status_cache::clear()
+  {
+    for (std::size_t i = 0; i != m_shard_count; ++i)
+    {
+      boost::detail::lightweight_mutex::scoped_lock lock(m_shards[i].mutex);
+      m_shards[i].map.clear();
+      m_shards[i].order.clear();
+      ++m_shards[i].generation;
+    }
+  }
+
+  void status_cache::invalidate(const path& p)
+  {
+    for (std::size_t i = 0; i != m_shard_count; ++i)
+    {
+      shard& s(m_shards[i]);
+      boost::detail::lightweight_mutex::scoped_lock lock(s.mutex);
+      for (shard::map_type::iterator it = s.map.begin(); it != s.map.end();)
+      {
+        if (detail::is_at_or_below(it->first, p))
+          it = s.map.erase(it);
+        else
+          ++it;
+      }
+      ++s.generation;
+    }
+  }
+
+  void status_cache::erase(const path& p)
+  {
+    shard& s(m_shard(p));
+    boost::detail::lightweight_mutex::scoped_lock lock(s.mutex);
+    s.map.erase(p);
+    ++s.generation;
+  }
+
+  std::size_t status_cache::size() const
+  {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i != m_shard_count; ++i)
+    {
+      boost::detail::lightweight_mutex::scoped_lock lock(m_shards[i].mutex);
+      n += m_shards[i].map.size();
+    }
+    return n;
+  }
+
+  boost::uintmax_t status_cache::hits() const
+  {
+    boost::uintmax_t n = 0;
+    for (std::size_t i = 0; i != m_shard_count; ++i)
+    {
+      boost::detail::lightweight_mutex::scoped_lock lock(m_shards[i].mutex);
+      n += m_shards[i].hits;
+    }
+    return n;
+  }
+
+  boost::uintmax_t status_cache::misses() const
+  {
+    boost::uintmax_t n = 0;
+    for (std::size_t i = 0; i != m_shard_count; ++i)
+    {
+      boost::detail::lightweight_mutex::scoped_lock lock(m_shards[i].mutex);
+      n += m_shards[i].misses;
+    }
+    return n;
+  }
+
+  file_metadata status_cache::lookup(const path& p, system::error_code* ec)
+  {
+    // the clock is only read if entries can expire
+    const bool expires(m_ttl != clock::duration::max());
+    clock::time_point now;
+    if (expires)
+      now = clock::now();
+
+    shard& s(m_shard(p));
+    boost::uintmax_t generation;
+    {
+      boost::detail::lightweight_mutex::scoped_lock lock(s.mutex);
+      shard::map_type::iterator it(s.map.find(p));
+      if (it != s.map.end())
+      {
+        if (!expires || now - it->second.inserted <= m_ttl)
+        {
+          ++s.hits;
+          if (ec != 0)
+            *ec = it->second.ec;
+          return it->second.md;
+        }
+        s.map.erase(it);  // expired
+      }
+      ++s.misses;
+      generation = s.generation;
+    }
+
+    // query without holding the lock, so lookups of other paths in the shard do not
+    // wait for the system call
+    error_code local_ec;
+    file_metadata md(detail::metadata(p, &local_ec));
+
+    if (local_ec && md.status.type() != file_type::not_found)
+    {
+      // errors other than not_found are not cached; status() throws for those it
+      // reports as file_type::none
+      if (ec == 0 && md.status.type() == file_type::none)
+        BOOST_FILESYSTEM_THROW(filesystem_error("boost::filesystem::status",
+          p, local_ec));
+      if (ec != 0)
+        *ec = local_ec;
+      return md;
+    }
+
+    {
+      boost::detail::lightweight_mutex::scoped_lock lock(s.mutex);
+
+      // if p was invalidated while it was being queried, the result may predate the
+      // change that prompted the invalidation, so it is returned but not cached
+      if (s.generation == generation)
+      {
+        shard::entry e;
+        e.md = md;
+        e.ec = local_ec;
+        e.inserted = now;
+        e.sequence = ++s.sequence;
+
+        s.make_room();
+        s.map[p] = e;
+        s.order.push_back(std::make_pair(p, e.sequence));
+      }
+    }
+
+    if (ec != 0)
+      *ec = local_ec;
+    return md;
+  }
+
+namespace detail
+{
+  BOOST_FILESYSTEM_DECL
+  boost::uintmax_t file_size(const path& p, status_cache& cache, system::error_code* ec)
+  {
+    error_code local_ec;
+    file_metadata md(cache.lookup(p, &local_ec));
+
+    // as for file_size(p): POSIX requires a regular file, Windows rejects directories
+#   ifdef BOOST_POSIX_API
+    if (!local_ec && !is_regular_file(md.status))
+      local_ec.assign(EPERM, system_category());
+#   else
+    if (!local_ec && is_directory(md.status))
+      local_ec.assign(ERROR_NOT_SUPPORTED, system_category());
+#   endif
+
+    if (local_ec)
+    {
+      if (ec == 0)
+        BOOST_FILESYSTEM_THROW(filesystem_error("boost::filesystem::file_size",
+          p, local_ec));
+      *ec = local_ec;
+      return static_cast<boost::uintmax_t>(-1);
+    }
+    if (ec != 0)
+      ec->clear();
+    return md.size;
+  }
+
+  BOOST_FILESYSTEM_DECL
+  boost::chrono::system_clock::time_point
+  last_write_time_point(const path& p, status_cache& cache, system::error_code* ec)
+  {
+    error_code local_ec;
+    file_metadata md(cache.lookup(p, &local_ec));
+    if (local_ec)
+    {
+      if (ec == 0)
+        BOOST_FILESYSTEM_THROW(filesystem_error("boost::filesystem::last_write_time",
+          p, local_ec));
+      *ec = local_ec;
+      return boost::chrono::system_clock::from_time_t(std::time_t(-1));
+    }
+    if (ec != 0)
+      ec->clear();
+    return md.last_write_time;
+  }
+
+}  // namespace detail
+}  // namespace filesystem
+}  // namespace boost
@@ -0,0 +1,212 @@
+//  filesystem tree_snapshot.cpp  ------------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//--------------------------------------------------------------------------------------//
+
+// define BOOST_FILESYSTEM_SOURCE so that <boost/filesystem/config.hpp> knows
+// the library is being built (possibly exporting rather than importing code)
+#define BOOST_FILESYSTEM_SOURCE
+
+#ifndef BOOST_SYSTEM_NO_DEPRECATED
+# define BOOST_SYSTEM_NO_DEPRECATED
+#endif
+
+#include <boost/filesystem/tree_snapshot.hpp>
+#include <boost/filesystem/status_cache.hpp>  // for detail::symlink_metadata
+#include "path_scan.hpp"
+#include <algorithm>
+
+using boost::filesystem::path;
+using boost::system::error_code;
+using boost::filesystem::detail::compare_tree_order;
+
+namespace
+{
+  template <class Entry>
+  class entry_less
+  {
+  public:
+    explicit entry_less(const path::value_type* names) : m_names(names) {}
+
+    bool operator()(const Entry& lhs, const Entry& rhs) const
+    {
+      return compare_tree_order(m_names + lhs.name, lhs.name_size,
+        m_names + rhs.name, rhs.name_size) < 0;
+    }
+
+  private:
+    const path::value_type* m_names;
+  };
+
+}  // unnamed namespace
+
+namespace boost
+{
+namespace filesystem
+{
+
+  void tree_snapshot::capture(const path& root)
+  {
+    m_capture(root, 0);
+  }
+
+  void tree_snapshot::capture(const path& root, system::error_code& ec)
+  {
+    m_capture(root, &ec);
+  }
+
+  void tree_snapshot::clear()
+  {
+    m_root.clear();
+    m_root_time = boost::chrono::system_clock::time_point();
+    m_names.clear();
+    m_entries.clear();
+  }
+
+  void tree_snapshot::swap(tree_snapshot& rhs)
+  {
+    m_root.swap(rhs.m_root);
+    std::swap(m_root_time, rhs.m_root_time);
+    m_names.swap(rhs.m_names);
+    m_entries.swap(rhs.m_entries);
+  }
+
+  void tree_snapshot::m_capture(const path& root, system::error_code* ec)
+  {
+    clear();
+    m_root = root;
+
+    // every entry's path is root / relative; this is the length of that prefix
+    const std::size_t prefix_size((root / "x").native().size() - 1);
+
+    // each directory's time is read before it is listed, so a change made while it
+    // is being listed leaves the recorded time stale rather than the contents
+    error_code local_ec;
+    m_root_time = detail::metadata(root, &local_ec).last_write_time;
+    for (recursive_directory_iterator itr(root, local_ec), end;
+      !local_ec && itr != end; itr.increment(local_ec))
+    {
+      const path& p(itr->path());
+      file_metadata md(detail::symlink_metadata(p, &local_ec));
+      if (local_ec)
+      {
+        // removed since it was listed; the next capture reports it as removed
+        if (md.status.type() == file_type::not_found)
+        {
+          local_ec.clear();
+          continue;
+        }
+        break;
+      }
+
+      entry e;
+      e.name = m_names.size();
+      e.name_size = p.native().size() - prefix_size;
+      e.type = md.status.type();
+      e.size = e.type == file_type::regular ? md.size : 0;
+      e.last_write_time = md.last_write_time;
+      e.inode = md.inode;
+      m_names.append(p.native(), prefix_size, e.name_size);
+      m_entries.push_back(e);
+    }
+
+    if (local_ec)
+    {
+      clear();
+      if (ec == 0)
+        BOOST_FILESYSTEM_THROW(filesystem_error("boost::filesystem::tree_snapshot",
+          root, local_ec));
+      *ec = local_ec;
+      return;
+    }
+    if (ec != 0)
+      ec->clear();
+
+    std::sort(m_entries.begin(), m_entries.end(), entry_less<entry>(m_names.c_str()));
+  }
+
+  snapshot_entry tree_snapshot::operator[](std::size_t i) const
+  {
+    const entry& e(m_entries[i]);
+    snapshot_entry result;
+    result.relative_path = relative_path(i);
+    result.type = e.type;
+    result.size = e.size;
+    result.last_write_time = e.last_write_time;
+    result.inode = e.inode;
+    return result;
+  }
+
+  path tree_snapshot::relative_path(std::size_t i) const
+  {
+    const entry& e(m_entries[i]);
+    return path(m_names.c_str() + e.name, m_names.c_str() + e.name + e.name_size);
+  }
+
+  std::size_t tree_snapshot::find(const path& relative) const
+  {
+    const path::string_type& s(relative.native());
+    std::size_t lo = 0, hi = m_entries.size();
+    while (lo < hi)
+    {
+      std::size_t mid = lo + (hi - lo) / 2;
+      const entry& e(m_entries[mid]);
+      int cmp = compare_tree_order(m_names.c_str() + e.name, e.name_size, s.c_str(), s.size());
+      if (cmp == 0)
+        return mid;
+      if (cmp < 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return m_entries.size();
+  }
+
+  void tree_snapshot::diff(const tree_snapshot& after, tree_diff& result) const
+  {
+    result.added.clear();
+    result.removed.clear();
+    result.modified.clear();
+
+    std::size_t i = 0, j = 0;
+    while (i != m_entries.size() || j != after.m_entries.size())
+    {
+      int cmp;
+      if (i == m_entries.size())
+        cmp = 1;
+      else if (j == after.m_entries.size())
+        cmp = -1;
+      else
+      {
+        const entry& b(m_entries[i]);
+        const entry& a(after.m_entries[j]);
+        cmp = compare_tree_order(m_names.c_str() + b.name, b.name_size,
+          after.m_names.c_str() + a.name, a.name_size);
+      }
+
+      if (cmp < 0)
+        result.removed.push_back(relative_path(i++));
+      else if (cmp > 0)
+        result.added.push_back(after.relative_path(j++));
+      else
+      {
+        const entry& b(m_entries[i]);
+        const entry& a(after.m_entries[j]);
+        if (b.type != a.type || b.inode != a.inode
+          || (b.type != file_type::directory
+            && (b.size != a.size || b.last_write_time != a.last_write_time)))
+          result.modified.push_back(relative_path(i));
+        ++i;
+        ++j;
+      }
+    }
+  }
+
+}  // namespace filesystem
+}  // namespace boost
@@ -18,15 +18,39 @@
 #endif
 
 #include <boost/filesystem/operations.hpp>
+#include <boost/atomic.hpp>
+#include <boost/move/utility.hpp>
+#include "error_report.hpp"
+
+#include <cstring>
+#include <cstdio>
 
 # ifdef BOOST_POSIX_API
 #   include <fcntl.h>
+#   include <unistd.h>
+#   include <pthread.h>
+#   include <cerrno>
+#   include <sys/stat.h>
+#   if defined(__linux__)
+#     include <sys/syscall.h>
+#   endif
 # else // BOOST_WINDOWS_API
 #   include <windows.h>
 #   include <wincrypt.h>
 #   pragma comment(lib, "Advapi32.lib")
 # endif
 
+namespace boost { namespace filesystem { namespace detail {
+
+//  lets the functions that create a temp_file fill it in
+struct temp_file_access
+{
+  static temp_file::native_handle_type& handle(temp_file& f)  { return f.m_handle; }
+  static path& file_path(temp_file& f)                        { return f.m_path; }
+};
+
+}}}
+
 namespace {
 
 void fail(int err, boost::system::error_code* ec)
@@ -40,10 +64,53 @@ void fail(int err, boost::system::error_code* ec)
   return;
 }
 
+# if defined(BOOST_POSIX_API) && defined(SYS_getrandom)
+
+//  getrandom() needs no file descriptor, so works under fd exhaustion and in chroots
+//  without /dev. Returns false if the kernel predates it (ENOSYS), and the caller
+//  should fall back to /dev/urandom.
+
+//  Set once ENOSYS is seen. Every thread that races to set it stores the same value,
+//  so relaxed ordering is enough.
+boost::atomic<bool> no_getrandom(false);
+
+bool linux_getrandom(void* buf, std::size_t len, boost::system::error_code* ec)
+{
+  if (no_getrandom.load(boost::memory_order_relaxed))
+    return false;
+
+  while (len != 0)
+  {
+    long n = ::syscall(SYS_getrandom, buf, len, 0u);
+    if (n == -1)
+    {
+      if (errno == EINTR)
+        continue;
+      if (errno == ENOSYS)
+      {
+        no_getrandom.store(true, boost::memory_order_relaxed);
+        return false;
+      }
+      fail(errno, ec);
+      return true;
+    }
+    len -= n;
+    buf = static_cast<char*>(buf) + n;
+  }
+  return true;
+}
+
+# endif
+
 void system_crypt_random(void* buf, std::size_t len, boost::system::error_code* ec)
 {
 # ifdef BOOST_POSIX_API
 
+#   ifdef SYS_getrandom
+  if (linux_getrandom(buf, len, ec))
+    return;
+#   endif
+
   int file = open("/dev/urandom", O_RDONLY);
   if (file == -1)
   {
@@ -104,9 +171,263 @@ void system_crypt_random(void* buf, std::size_t len, boost::system::error_code*
 # endif
 }
 
+//  entropy pool  ----------------------------------------------------------------------//
+
+//  Each thread keeps a buffer of bytes from system_crypt_random(), so unique_path()
+//  costs one system call per refill rather than one per name. Bytes are cleared as
+//  they are handed out. A fork() copies the buffer into the child, so the child
+//  would repeat the parent's names; a pthread_atfork() handler advances a generation
+//  count that makes every thread's buffer in the child stale.
+
+# if !defined(BOOST_NO_CXX11_THREAD_LOCAL)
+#   define BOOST_FILESYSTEM_ENTROPY_POOL
+#   define BOOST_FILESYSTEM_THREAD_LOCAL thread_local
+# elif defined(BOOST_POSIX_API) && defined(__GNUC__)
+#   define BOOST_FILESYSTEM_ENTROPY_POOL
+#   define BOOST_FILESYSTEM_THREAD_LOCAL __thread
+# endif
+
+# ifdef BOOST_FILESYSTEM_ENTROPY_POOL
+
+const std::size_t pool_size = 256;
+
+struct entropy_pool  // POD, so zero initialized for each thread
+{
+  unsigned char  bytes[pool_size];
+  std::size_t    available;   // the last available bytes are unused
+  unsigned       generation;
+};
+
+BOOST_FILESYSTEM_THREAD_LOCAL entropy_pool thread_pool;
+
+#   ifdef BOOST_POSIX_API
+
+volatile unsigned fork_generation = 1;  // 0 is a new thread's pool
+pthread_once_t atfork_once = PTHREAD_ONCE_INIT;
+
+extern "C" void entropy_pool_child() { ++fork_generation; }
+extern "C" void entropy_pool_register() { ::pthread_atfork(0, 0, entropy_pool_child); }
+
+inline unsigned current_generation()
+{
+  ::pthread_once(&atfork_once, entropy_pool_register);
+  return fork_generation;
+}
+
+#   else
+
+inline unsigned current_generation() { return 1; }
+
+#   endif
+
+void crypt_random(void* buf, std::size_t len, boost::system::error_code* ec)
+{
+  if (len > pool_size)
+  {
+    system_crypt_random(buf, len, ec);
+    return;
+  }
+
+  entropy_pool& pool(thread_pool);
+  unsigned generation = current_generation();
+  if (pool.generation != generation)
+  {
+    pool.available = 0;
+    pool.generation = generation;
+  }
+
+  if (pool.available < len)
+  {
+    pool.available = 0;
+    system_crypt_random(pool.bytes, pool_size, ec);
+    if (ec != 0 && *ec)
+      return;
+    pool.available = pool_size;
+  }
+
+  unsigned char* p = pool.bytes + (pool_size - pool.available);
+  std::memcpy(buf, p, len);
+  std::memset(p, 0, len);
+  pool.available -= len;
+}
+
+# else
+
+inline void crypt_random(void* buf, std::size_t len, boost::system::error_code* ec)
+{
+  system_crypt_random(buf, len, ec);
+}
+
+# endif
+
+//  temp file support  -----------------------------------------------------------------//
+
+using boost::filesystem::path;
+using boost::filesystem::detail::report;
+typedef boost::filesystem::temp_file::native_handle_type native_handle_type;
+
+const int max_attempts = 100;  // collisions are only likely if the model has few %s
+
+# ifdef BOOST_POSIX_API
+
+const native_handle_type invalid_handle = -1;
+const int name_taken = EEXIST;
+inline bool is_name_taken(int err) { return err == EEXIST; }
+
+#   ifdef O_CLOEXEC
+const int cloexec = O_CLOEXEC;
+#   else
+const int cloexec = 0;
+#   endif
+
+//  returns 0 and sets h, or returns the error
+int create_exclusive_file(const path& p, native_handle_type& h, bool /*delete_on_close*/)
+{
+  h = ::open(p.c_str(), O_RDWR | O_CREAT | O_EXCL | cloexec, S_IRUSR | S_IWUSR);
+  return h == -1 ? errno : 0;
+}
+
+int create_exclusive_directory(const path& p)
+{
+  return ::mkdir(p.c_str(), S_IRWXU) == 0 ? 0 : errno;
+}
+
+# else // BOOST_WINDOWS_API
+
+const native_handle_type invalid_handle = INVALID_HANDLE_VALUE;
+const int name_taken = ERROR_FILE_EXISTS;
+inline bool is_name_taken(int err)
+{
+  return err == ERROR_FILE_EXISTS || err == ERROR_ALREADY_EXISTS;
+}
+
+int create_exclusive_file(const path& p, native_handle_type& h, bool delete_on_close)
+{
+  h = ::CreateFileW(p.c_str(), GENERIC_READ | GENERIC_WRITE,
+    delete_on_close ? FILE_SHARE_DELETE : 0, 0, CREATE_NEW,
+    delete_on_close ? FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE
+                    : FILE_ATTRIBUTE_NORMAL, 0);
+  return h == INVALID_HANDLE_VALUE ? ::GetLastError() : 0;
+}
+
+int create_exclusive_directory(const path& p)
+{
+  return ::CreateDirectoryW(p.c_str(), 0) ? 0 : ::GetLastError();
+}
+
+# endif
+
+int close_handle(native_handle_type h)
+{
+# ifdef BOOST_POSIX_API
+  return ::close(h) == 0 ? 0 : errno;
+# else
+  return ::CloseHandle(h) ? 0 : ::GetLastError();
+# endif
+}
+
+boost::filesystem::temp_file create_temp_file(const path& dir, const path& model,
+  bool delete_on_close, boost::system::error_code* ec)
+{
+  using boost::filesystem::detail::temp_file_access;
+  boost::filesystem::temp_file f;
+  for (int attempt = 0; attempt != max_attempts; ++attempt)
+  {
+    path p(join(dir, boost::filesystem::detail::unique_path(model, ec)));
+    if (ec != 0 && *ec)
+      return boost::move(f);
+    int err = create_exclusive_file(p, temp_file_access::handle(f), delete_on_close);
+    if (!err)
+    {
+      temp_file_access::file_path(f) = p;
+      if (ec != 0)
+        ec->clear();
+      return boost::move(f);
+    }
+    temp_file_access::handle(f) = invalid_handle;
+    if (!is_name_taken(err))
+    {
+      report(err, p, ec, "boost::filesystem::create_temp_file");
+      return boost::move(f);
+    }
+  }
+  report(name_taken, join(dir, model), ec, "boost::filesystem::create_temp_file");
+  return boost::move(f);
+}
+
 }  // unnamed namespace
 
-namespace boost { namespace filesystem { namespace detail {
+namespace boost { namespace filesystem {
+
+//  temp_file  -------------------------------------------------------------------------//
+
+temp_file::temp_file() : m_handle(invalid_handle) {}
+
+temp_file::temp_file(BOOST_RV_REF(temp_file) f)
+  : m_handle(f.m_handle)
+{
+  m_path.swap(f.m_path);
+  f.m_handle = invalid_handle;
+}
+
+temp_file& temp_file::operator=(BOOST_RV_REF(temp_file) f)
+{
+  if (this != &f)
+  {
+    m_abandon();
+    m_handle = f.m_handle;
+    m_path.swap(f.m_path);
+    f.m_handle = invalid_handle;
+    f.m_path.clear();
+  }
+  return *this;
+}
+
+temp_file::~temp_file()
+{
+  m_abandon();
+}
+
+bool temp_file::is_open() const
+{
+  return m_handle != invalid_handle;
+}
+
+temp_file::native_handle_type temp_file::release()
+{
+  native_handle_type h(m_handle);
+  m_handle = invalid_handle;
+  return h;
+}
+
+void temp_file::m_close(system::error_code* ec)
+{
+  native_handle_type h(release());
+  int err = h == invalid_handle ? 0 : close_handle(h);
+  if (err)
+  {
+    report(err, m_path, ec, "boost::filesystem::temp_file::close");
+    return;
+  }
+  if (ec != 0)
+    ec->clear();
+}
+
+//  an anonymous file, or one created delete on close, goes away with its handle
+void temp_file::m_abandon()
+{
+  if (!is_open())
+    return;
+  close_handle(release());
+  if (!m_path.empty())
+  {
+    system::error_code ec;
+    detail::remove(m_path, &ec);
+  }
+  m_path.clear();
+}
+
+namespace detail {
 
 BOOST_FILESYSTEM_DECL
 path unique_path(const path& model, system::error_code* ec)
@@ -118,13 +439,15 @@ path unique_path(const path& model, system::error_code* ec)
   char ran[n_ran];
 
   int nibbles_used = max_nibbles;
+  if (ec != 0)
+    ec->clear();  // errors are detected by testing *ec
   for(std::wstring::size_type i=0; i < s.size(); ++i)
   {
     if (s[i] == L'%')                        // digit request
     {
       if (nibbles_used == max_nibbles)
       {
-        system_crypt_random(ran, sizeof(ran), ec);
+        crypt_random(ran, sizeof(ran), ec);
         if (ec != 0 && *ec)
           return path();
         nibbles_used = 0;
@@ -135,10 +458,116 @@ path unique_path(const path& model, system::error_code* ec)
     }
   }
 
-  if (ec != 0)
-    ec->clear();
-
   return s;
 }
 
+BOOST_FILESYSTEM_DECL
+temp_file create_temp_file(const path& dir, const path& model, system::error_code* ec)
+{
+  return ::create_temp_file(dir, model, false, ec);
+}
+
+BOOST_FILESYSTEM_DECL
+path create_temp_directory(const path& dir, const path& model, system::error_code* ec)
+{
+  for (int attempt = 0; attempt != max_attempts; ++attempt)
+  {
+    path p(join(dir, unique_path(model, ec)));
+    if (ec != 0 && *ec)
+      return path();
+    int err = create_exclusive_directory(p);
+    if (!err)
+    {
+      if (ec != 0)
+        ec->clear();
+      return p;
+    }
+    if (!is_name_taken(err))
+    {
+      report(err, p, ec, "boost::filesystem::create_temp_directory");
+      return path();
+    }
+  }
+  report(name_taken, join(dir, model), ec, "boost::filesystem::create_temp_directory");
+  return path();
+}
+
+BOOST_FILESYSTEM_DECL
+temp_file create_anonymous_temp_file(const path& dir, system::error_code* ec)
+{
+  temp_file f;
+
+# if defined(BOOST_POSIX_API) && defined(O_TMPFILE)
+  int h = ::open(dir.c_str(), O_TMPFILE | O_RDWR | cloexec, S_IRUSR | S_IWUSR);
+  if (h != -1)
+  {
+    temp_file_access::handle(f) = h;
+    if (ec != 0)
+      ec->clear();
+    return boost::move(f);
+  }
+  // kernels or file systems without O_TMPFILE report EISDIR or EOPNOTSUPP
+  if (errno != EISDIR && errno != EOPNOTSUPP && errno != EINVAL)
+  {
+    report(errno, dir, ec, "boost::filesystem::create_anonymous_temp_file");
+    return boost::move(f);
+  }
+# endif
+
+  f = ::create_temp_file(dir, "%%%%-%%%%-%%%%-%%%%", true, ec);
+  if (!f.is_open())
+    return boost::move(f);
+# ifdef BOOST_POSIX_API
+  ::unlink(f.file_path().c_str());
+# endif
+  temp_file_access::file_path(f).clear();
+  return boost::move(f);
+}
+
+BOOST_FILESYSTEM_DECL
+void link_temp_file(temp_file& f, const path& dir, const path& model,
+  system::error_code* ec)
+{
+# if defined(BOOST_POSIX_API) && defined(O_TMPFILE)
+  if (!f.is_open() || !f.file_path().empty())  // closed or already named
+  {
+    report(EINVAL, f.file_path().empty() ? dir : f.file_path(), ec,
+      "boost::filesystem::link_temp_file");
+    return;
+  }
+
+  // linkat(f.native_handle(), "", ..., AT_EMPTY_PATH) needs CAP_DAC_READ_SEARCH; linking the
+  // /proc entry does not
+  char proc_path[32];
+  std::sprintf(proc_path, "/proc/self/fd/%d", f.native_handle());
+  for (int attempt = 0; attempt != max_attempts; ++attempt)
+  {
+    path p(join(dir, unique_path(model, ec)));
+    if (ec != 0 && *ec)
+      return;
+    if (::linkat(AT_FDCWD, proc_path, AT_FDCWD, p.c_str(), AT_SYMLINK_FOLLOW) == 0)
+    {
+      temp_file_access::file_path(f) = p;
+      if (ec != 0)
+        ec->clear();
+      return;
+    }
+    if (errno != EEXIST)
+    {
+      report(errno, p, ec, "boost::filesystem::link_temp_file");
+      return;
+    }
+  }
+  report(EEXIST, join(dir, model), ec, "boost::filesystem::link_temp_file");
+# else
+  report(
+#   ifdef BOOST_POSIX_API
+    ENOTSUP,
+#   else
+    ERROR_NOT_SUPPORTED,
+#   endif
+    f.file_path().empty() ? dir : f.file_path(), ec, "boost::filesystem::link_temp_file");
+# endif
+}
+
 }}}
@@ -0,0 +1,365 @@
+//  filesystem utf8_transcode.cpp  -----------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+// define BOOST_FILESYSTEM_SOURCE so that <boost/filesystem/config.hpp> knows
+// the library is being built (possibly exporting rather than importing code)
+#define BOOST_FILESYSTEM_SOURCE
+
+#ifndef BOOST_SYSTEM_NO_DEPRECATED
+# define BOOST_SYSTEM_NO_DEPRECATED
+#endif
+
+#include "utf8_transcode.hpp"
+#include <boost/cstdint.hpp>
+#include <cctype>
+#include <locale>
+
+//  SSE2 is part of the x86-64 baseline, so it needs no runtime check. The ASCII loops
+//  handle 16 bytes of UTF-8 per iteration; the scalar loops finish the remainder.
+
+#if !defined(BOOST_FILESYSTEM_NO_SIMD)
+# if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define BOOST_FILESYSTEM_UTF8_SSE2
+#   include <emmintrin.h>
+# endif
+#endif
+
+namespace pt = boost::filesystem::path_traits;
+
+namespace
+{
+  typedef boost::uint32_t code_point;
+
+  const bool wide_is_utf16 = sizeof(wchar_t) == 2;
+
+  inline code_point wide_unit(wchar_t c)
+  {
+    return wide_is_utf16 ? static_cast<boost::uint16_t>(c) : static_cast<code_point>(c);
+  }
+
+  //  ASCII runs  ----------------------------------------------------------------------//
+
+  //  Returns: the number of leading ASCII characters in [s, s+n)
+
+  std::size_t ascii_run(const char* s, std::size_t n)
+  {
+    std::size_t i = 0;
+#   ifdef BOOST_FILESYSTEM_UTF8_SSE2
+    for (; i + 16 <= n; i += 16)
+    {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+      if (_mm_movemask_epi8(v))  // a byte with its high bit set
+        break;
+    }
+#   endif
+    while (i < n && !(static_cast<unsigned char>(s[i]) & 0x80))
+      ++i;
+    return i;
+  }
+
+  std::size_t ascii_run(const wchar_t* s, std::size_t n)
+  {
+    std::size_t i = 0;
+#   ifdef BOOST_FILESYSTEM_UTF8_SSE2
+    const std::size_t width = 16 / sizeof(wchar_t);
+    const __m128i non_ascii = wide_is_utf16
+      ? _mm_set1_epi16(static_cast<short>(0xFF80))
+      : _mm_set1_epi32(static_cast<int>(0xFFFFFF80));
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + width <= n; i += width)
+    {
+      __m128i v = _mm_and_si128(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i)), non_ascii);
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) != 0xFFFF)
+        break;
+    }
+#   endif
+    while (i < n && wide_unit(s[i]) < 0x80)
+      ++i;
+    return i;
+  }
+
+  //  Copy n ASCII characters, zero extending or truncating each
+
+  void widen_ascii(const char* s, std::size_t n, wchar_t* to)
+  {
+    std::size_t i = 0;
+#   ifdef BOOST_FILESYSTEM_UTF8_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16)
+    {
+      __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+      __m128i lo = _mm_unpacklo_epi8(v, zero);
+      __m128i hi = _mm_unpackhi_epi8(v, zero);
+      __m128i* out = reinterpret_cast<__m128i*>(to + i);
+      if (wide_is_utf16)
+      {
+        _mm_storeu_si128(out, lo);
+        _mm_storeu_si128(out + 1, hi);
+      }
+      else
+      {
+        _mm_storeu_si128(out, _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(hi, zero));
+      }
+    }
+#   endif
+    for (; i < n; ++i)
+      to[i] = static_cast<unsigned char>(s[i]);
+  }
+
+  void narrow_ascii(const wchar_t* s, std::size_t n, char* to)
+  {
+    std::size_t i = 0;
+#   ifdef BOOST_FILESYSTEM_UTF8_SSE2
+    for (; i + 16 <= n; i += 16)
+    {
+      const __m128i* in = reinterpret_cast<const __m128i*>(s + i);
+      __m128i v;
+      if (wide_is_utf16)
+        v = _mm_packus_epi16(_mm_loadu_si128(in), _mm_loadu_si128(in + 1));
+      else
+        v = _mm_packus_epi16(
+          _mm_packs_epi32(_mm_loadu_si128(in), _mm_loadu_si128(in + 1)),
+          _mm_packs_epi32(_mm_loadu_si128(in + 2), _mm_loadu_si128(in + 3)));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(to + i), v);
+    }
+#   endif
+    for (; i < n; ++i)
+      to[i] = static_cast<char>(s[i]);
+  }
+
+  //  code points  ---------------------------------------------------------------------//
+
+  //  Returns: the length of the well-formed UTF-8 sequence at s, setting cp, or 0.
+  //  Overlong forms, surrogates and values above 0x10FFFF are not well-formed.
+
+  std::size_t decode_utf8(const unsigned char* s, const unsigned char* end,
+    code_point& cp)
+  {
+    unsigned c = s[0];
+    unsigned lo = 0x80, hi = 0xBF;  // range of the second byte
+    std::size_t len;
+
+    if (c < 0x80)      { cp = c; return 1; }
+    else if (c < 0xC2) return 0;
+    else if (c < 0xE0) { len = 2; cp = c & 0x1F; }
+    else if (c < 0xF0)
+    {
+      len = 3; cp = c & 0x0F;
+      if (c == 0xE0) lo = 0xA0;
+      else if (c == 0xED) hi = 0x9F;
+    }
+    else if (c < 0xF5)
+    {
+      len = 4; cp = c & 0x07;
+      if (c == 0xF0) lo = 0x90;
+      else if (c == 0xF4) hi = 0x8F;
+    }
+    else return 0;
+
+    if (static_cast<std::size_t>(end - s) < len || s[1] < lo || s[1] > hi)
+      return 0;
+    cp = (cp << 6) | (s[1] & 0x3F);
+    for (std::size_t i = 2; i < len; ++i)
+    {
+      if ((s[i] & 0xC0) != 0x80)
+        return 0;
+      cp = (cp << 6) | (s[i] & 0x3F);
+    }
+    return len;
+  }
+
+  //  Returns: the number of wchar_t's for the code point at s, setting cp, or 0 for an
+  //  unpaired surrogate or a value above 0x10FFFF.
+
+  std::size_t decode_wide(const wchar_t* s, const wchar_t* end, code_point& cp)
+  {
+    code_point c = wide_unit(s[0]);
+    if (c >= 0xD800 && c <= 0xDFFF)
+    {
+      if (!wide_is_utf16 || c > 0xDBFF || end - s < 2)
+        return 0;
+      code_point c2 = wide_unit(s[1]);
+      if (c2 < 0xDC00 || c2 > 0xDFFF)
+        return 0;
+      cp = 0x10000 + ((c - 0xD800) << 10) + (c2 - 0xDC00);
+      return 2;
+    }
+    if (c > 0x10FFFF)
+      return 0;
+    cp = c;
+    return 1;
+  }
+
+  inline std::size_t utf8_length(code_point cp)
+  {
+    return cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+  }
+
+  char* encode_utf8(code_point cp, char* to)
+  {
+    if (cp < 0x80)
+      *to++ = static_cast<char>(cp);
+    else if (cp < 0x800)
+    {
+      *to++ = static_cast<char>(0xC0 | (cp >> 6));
+      *to++ = static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000)
+    {
+      *to++ = static_cast<char>(0xE0 | (cp >> 12));
+      *to++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+      *to++ = static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else
+    {
+      *to++ = static_cast<char>(0xF0 | (cp >> 18));
+      *to++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+      *to++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+      *to++ = static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    return to;
+  }
+
+  //  Returns: true if the codeset of the LC_CTYPE category in a locale name, such as
+  //  "en_US.UTF-8" or "LC_CTYPE=C.utf8;LC_NUMERIC=C", is UTF-8
+
+  bool is_utf8_locale_name(const std::string& name)
+  {
+    std::string::size_type start = name.find("LC_CTYPE=");
+    start = start == std::string::npos ? 0 : start + 9;
+    std::string::size_type end = name.find(';', start);
+    if (end == std::string::npos)
+      end = name.size();
+    std::string::size_type dot = name.find('.', start);
+    if (dot == std::string::npos || dot > end)
+      return false;
+
+    std::string codeset;
+    for (std::string::size_type i = dot + 1; i != end && name[i] != '@'; ++i)
+    {
+      if (name[i] != '-')
+        codeset += static_cast<char>(std::tolower(static_cast<unsigned char>(name[i])));
+    }
+    return codeset == "utf8";
+  }
+
+}  // unnamed namespace
+
+namespace boost
+{
+namespace filesystem
+{
+namespace detail
+{
+
+  bool is_utf8_locale(const std::locale& loc)
+  {
+    // a locale with a user supplied facet is named "*", so a UTF-8 name means the
+    // facet is the standard library's own UTF-8 facet
+    return is_utf8_locale_name(loc.name());
+  }
+
+  bool utf8_to_wide(const char* from, const char* from_end, std::wstring& target)
+  {
+    const unsigned char* const begin = reinterpret_cast<const unsigned char*>(from);
+    const unsigned char* const end = reinterpret_cast<const unsigned char*>(from_end);
+    const unsigned char* s;
+    code_point cp = 0;
+
+    //  validate and size
+    std::size_t size = 0;
+    for (s = begin; s != end;)
+    {
+      std::size_t run = ascii_run(reinterpret_cast<const char*>(s), end - s);
+      size += run;
+      s += run;
+      if (s == end)
+        break;
+      std::size_t len = decode_utf8(s, end, cp);
+      if (!len)
+        return false;
+      size += wide_is_utf16 && cp > 0xFFFF ? 2 : 1;
+      s += len;
+    }
+    if (size == 0)
+      return true;
+
+    //  convert
+    std::size_t old_size = target.size();
+    target.resize(old_size + size);
+    wchar_t* to = &target[old_size];
+    for (s = begin; s != end;)
+    {
+      std::size_t run = ascii_run(reinterpret_cast<const char*>(s), end - s);
+      widen_ascii(reinterpret_cast<const char*>(s), run, to);
+      to += run;
+      s += run;
+      if (s == end)
+        break;
+      s += decode_utf8(s, end, cp);
+      if (wide_is_utf16 && cp > 0xFFFF)
+      {
+        cp -= 0x10000;
+        *to++ = static_cast<wchar_t>(0xD800 + (cp >> 10));
+        *to++ = static_cast<wchar_t>(0xDC00 + (cp & 0x3FF));
+      }
+      else
+        *to++ = static_cast<wchar_t>(cp);
+    }
+    return true;
+  }
+
+  bool wide_to_utf8(const wchar_t* from, const wchar_t* from_end, std::string& target)
+  {
+    const wchar_t* s;
+    code_point cp = 0;
+
+    //  validate and size
+    std::size_t size = 0;
+    for (s = from; s != from_end;)
+    {
+      std::size_t run = ascii_run(s, from_end - s);
+      size += run;
+      s += run;
+      if (s == from_end)
+        break;
+      std::size_t len = decode_wide(s, from_end, cp);
+      if (!len)
+        return false;
+      size += utf8_length(cp);
+      s += len;
+    }
+    if (size == 0)
+      return true;
+
+    //  convert
+    std::size_t old_size = target.size();
+    target.resize(old_size + size);
+    char* to = &target[old_size];
+    for (s = from; s != from_end;)
+    {
+      std::size_t run = ascii_run(s, from_end - s);
+      narrow_ascii(s, run, to);
+      to += run;
+      s += run;
+      if (s == from_end)
+        break;
+      s += decode_wide(s, from_end, cp);
+      to = encode_utf8(cp, to);
+    }
+    return true;
+  }
+
+}  // namespace detail
+}  // namespace filesystem
+}  // namespace boost
@@ -0,0 +1,47 @@
+//  filesystem utf8_transcode.hpp  -----------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//  UTF-8 <-> wchar_t transcoding used by path_traits::convert() in place of the codecvt
+//  facet when the facet is known to be UTF-8. Private to the library implementation.
+
+#ifndef BOOST_FILESYSTEM3_UTF8_TRANSCODE_HPP
+#define BOOST_FILESYSTEM3_UTF8_TRANSCODE_HPP
+
+#include <boost/filesystem/config.hpp>
+#include <boost/filesystem/path_traits.hpp>
+#include <string>
+#include <locale>
+
+//  Define BOOST_FILESYSTEM_NO_SIMD to use only the portable scalar ASCII loops.
+
+namespace boost
+{
+namespace filesystem
+{
+namespace detail
+{
+  //  Returns: true if the name of loc says its LC_CTYPE codeset is UTF-8.
+  bool is_utf8_locale(const std::locale& loc);
+
+  //  Returns: true if cvt is the library's utf8_codecvt_facet, or is the path locale's
+  //  facet and that locale is UTF-8. Defined in path.cpp, which owns the path locale.
+  bool is_utf8_codecvt(const path_traits::codecvt_type& cvt);
+
+  //  Append the conversion of [from, from_end) to target, resizing target once to the
+  //  exact size of the result. wchar_t is UTF-16 if it is 16 bits, otherwise UTF-32.
+  //  Returns: false, with target unchanged, if the input is not well-formed; the caller
+  //  then uses the codecvt facet, which decides how the error is reported.
+  bool utf8_to_wide(const char* from, const char* from_end, std::wstring& target);
+  bool wide_to_utf8(const wchar_t* from, const wchar_t* from_end, std::string& target);
+
+}  // namespace detail
+}  // namespace filesystem
+}  // namespace boost
+
+#endif  // BOOST_FILESYSTEM3_UTF8_TRANSCODE_HPP
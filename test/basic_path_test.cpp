@@ -0,0 +1,258 @@
+//  basic_path_test.cpp  ---------------------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+#include <boost/config/warning_disable.hpp>
+
+//  See deprecated_test for tests of deprecated features
+#ifndef BOOST_FILESYSTEM_NO_DEPRECATED
+#  define BOOST_FILESYSTEM_NO_DEPRECATED
+#endif
+#ifndef BOOST_SYSTEM_NO_DEPRECATED
+#  define BOOST_SYSTEM_NO_DEPRECATED
+#endif
+
+#include <boost/filesystem/basic_path.hpp>
+
+#include <boost/config.hpp>
+# if defined( BOOST_NO_STD_WSTRING )
+#   error Configuration not supported: Boost.Filesystem V3 and later requires std::wstring support
+# endif
+
+#include <boost/detail/lightweight_test.hpp>
+
+#ifndef BOOST_LIGHTWEIGHT_MAIN
+#  include <boost/test/prg_exec_monitor.hpp>
+#else
+#  include <boost/detail/lightweight_main.hpp>
+#endif
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <memory>
+#include <cstddef>
+
+namespace fs = boost::filesystem;
+using fs::path;
+
+namespace
+{
+  //  counting_allocator: counts allocations made on behalf of the test  ---------------//
+
+  std::size_t allocations;
+
+  template <class T>
+  class counting_allocator : public std::allocator<T>
+  {
+  public:
+    template <class U> struct rebind { typedef counting_allocator<U> other; };
+
+    counting_allocator() {}
+    counting_allocator(const counting_allocator&) : std::allocator<T>() {}
+    template <class U>
+    counting_allocator(const counting_allocator<U>&) {}
+
+    T* allocate(std::size_t n, const void* = 0)
+    {
+      ++allocations;
+      return std::allocator<T>::allocate(n);
+    }
+  };
+
+  template <class T, class U>
+  bool operator==(const counting_allocator<T>&, const counting_allocator<U>&)
+    { return true; }
+  template <class T, class U>
+  bool operator!=(const counting_allocator<T>&, const counting_allocator<U>&)
+    { return false; }
+
+  typedef fs::basic_path<counting_allocator<path::value_type> > cpath;
+
+  //  construction_tests  --------------------------------------------------------------//
+
+  void construction_tests()
+  {
+    std::cout << "construction_tests..." << std::endl;
+
+    // the long strings defeat the small string optimization
+    const std::string s("foo/bar/a-long-enough-name-to-require-an-allocation");
+    const path p(s);
+
+    allocations = 0;
+    cpath a(p);
+    BOOST_TEST(allocations > 0);
+    BOOST_TEST(a.native() == p.native().c_str());
+    BOOST_TEST(a.to_path() == p);
+
+    cpath b(s);
+    BOOST_TEST(b == a);
+    cpath c(p.c_str());
+    BOOST_TEST(c == a);
+    cpath d(std::wstring(L"foo/bar/a-long-enough-name-to-require-an-allocation"));
+    BOOST_TEST(d == a);
+    cpath e(a);
+    BOOST_TEST(e == a);
+    BOOST_TEST(hash_value(e) == hash_value(p));
+
+    cpath f;
+    BOOST_TEST(f.empty());
+    f = s;
+    BOOST_TEST(f == a);
+    f = p;
+    BOOST_TEST(f == a);
+    f = f.native();  // self-assignment through native()
+    BOOST_TEST(f == a);
+    f.clear();
+    BOOST_TEST(f.empty());
+    BOOST_TEST(f != a);
+
+    swap(e, f);
+    BOOST_TEST(e.empty());
+    BOOST_TEST(f == a);
+  }
+
+  //  append_tests  --------------------------------------------------------------------//
+
+  void append_tests()
+  {
+    std::cout << "append_tests..." << std::endl;
+
+    cpath p("foo");
+    p /= "bar";
+    BOOST_TEST(p.to_path() == path("foo") / "bar");
+    p /= "/baz";
+    BOOST_TEST(p.to_path() == path("foo") / "bar" / "/baz");
+    p /= "";
+    BOOST_TEST(p.to_path() == path("foo") / "bar" / "/baz");
+    p += ".txt";
+    BOOST_TEST(p.to_path() == path("foo/bar/baz.txt").make_preferred());
+
+    cpath q("foo/");
+    q /= path("bar");
+    BOOST_TEST(q.to_path() == path("foo/bar"));
+
+    cpath r("dir");
+    r /= r;  // self-append
+    BOOST_TEST(r.to_path() == path("dir") / "dir");
+    r /= r.c_str() + 1;  // overlapping append
+    BOOST_TEST(r.to_path() == path("dir") / "dir" / "ir" / "dir");
+
+    cpath s(cpath("a") / "b");
+    BOOST_TEST(s.to_path() == path("a") / "b");
+    BOOST_TEST((cpath("a") / cpath("b")).to_path() == path("a") / "b");
+    BOOST_TEST((cpath("a") / path("b")).to_path() == path("a") / "b");
+    BOOST_TEST((cpath() / "b").to_path() == path("b"));
+
+#   ifdef BOOST_WINDOWS_API
+    cpath w("c:");
+    w /= "foo";
+    BOOST_TEST(w.to_path() == path("c:foo"));
+#   endif
+
+    // conversion to path for other operations
+    path x(cpath("a/b"));
+    BOOST_TEST(x == path("a/b"));
+  }
+
+  //  operations_tests  ----------------------------------------------------------------//
+
+  void operations_tests(const path& dir)
+  {
+    std::cout << "operations_tests..." << std::endl;
+
+    fs::create_directory(dir);
+    {
+      std::ofstream f((dir / "f").string().c_str());
+      f << "1234567";
+    }
+
+    cpath d(dir);
+    cpath f(d / "f");
+    cpath missing(d / "no-such-file");
+
+    BOOST_TEST(fs::exists(d));
+    BOOST_TEST(fs::is_directory(d));
+    BOOST_TEST(!fs::is_regular_file(d));
+    BOOST_TEST(fs::is_regular_file(f));
+    BOOST_TEST(!fs::is_symlink(f));
+    BOOST_TEST(!fs::is_other(f));
+    BOOST_TEST(fs::is_regular_file(fs::status(f)));
+    BOOST_TEST(fs::is_regular_file(fs::symlink_status(f)));
+    BOOST_TEST_EQ(fs::file_size(f), 7U);
+    BOOST_TEST(fs::last_write_time(f) == fs::last_write_time(dir / "f"));
+
+    boost::system::error_code ec;
+    BOOST_TEST(!fs::exists(missing, ec));
+    boost::system::error_code path_ec;
+    fs::exists(missing.to_path(), path_ec);
+    BOOST_TEST(ec == path_ec);  // same reporting as the path overloads
+    BOOST_TEST(fs::status(missing, ec).type() == fs::file_type::not_found);
+    BOOST_TEST(ec);
+    BOOST_TEST(fs::file_size(missing, ec) == static_cast<boost::uintmax_t>(-1));
+    BOOST_TEST(ec);
+    BOOST_TEST(fs::file_size(d, ec) == static_cast<boost::uintmax_t>(-1));
+    BOOST_TEST(ec);
+
+    bool thrown = false;
+    try { fs::file_size(missing); }
+    catch (const fs::filesystem_error& ex)
+    {
+      thrown = true;
+      BOOST_TEST(ex.path1() == missing.to_path());
+    }
+    BOOST_TEST(thrown);
+
+    // operations without basic_path overloads accept basic_path by conversion
+    BOOST_TEST(fs::is_empty(d) == false);
+    BOOST_TEST(fs::remove(f));
+    BOOST_TEST(!fs::exists(f));
+  }
+
+#ifdef __cpp_lib_memory_resource
+  //  pmr_tests  -----------------------------------------------------------------------//
+
+  void pmr_tests()
+  {
+    std::cout << "pmr_tests..." << std::endl;
+
+    char buffer[1024];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+      std::pmr::null_memory_resource());
+
+    fs::pmr::path p(path("foo/bar/a-long-enough-name-to-require-an-allocation"), &arena);
+    fs::pmr::path q(p / "and-another-long-enough-name");
+    BOOST_TEST(q.get_allocator().resource() == &arena);
+    BOOST_TEST(q.to_path() == path("foo/bar/a-long-enough-name-to-require-an-allocation")
+      / "and-another-long-enough-name");
+  }
+#endif
+
+}  // unnamed namespace
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//                                    main                                              //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+int cpp_main(int, char*[])
+{
+  construction_tests();
+  append_tests();
+
+  path dir(fs::temp_directory_path() / fs::unique_path("basic_path_test-%%%%-%%%%"));
+  operations_tests(dir);
+  fs::remove_all(dir);
+
+#ifdef __cpp_lib_memory_resource
+  pmr_tests();
+#endif
+
+  return ::boost::report_errors();
+}
@@ -0,0 +1,161 @@
+//  cached_path_test.cpp  --------------------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+#include <boost/config/warning_disable.hpp>
+
+//  See deprecated_test for tests of deprecated features
+#ifndef BOOST_FILESYSTEM_NO_DEPRECATED
+#  define BOOST_FILESYSTEM_NO_DEPRECATED
+#endif
+#ifndef BOOST_SYSTEM_NO_DEPRECATED
+#  define BOOST_SYSTEM_NO_DEPRECATED
+#endif
+
+#include <boost/filesystem/cached_path.hpp>
+
+#include <boost/config.hpp>
+# if defined( BOOST_NO_STD_WSTRING )
+#   error Configuration not supported: Boost.Filesystem V3 and later requires std::wstring support
+# endif
+
+#include <boost/detail/lightweight_test.hpp>
+
+#ifndef BOOST_LIGHTWEIGHT_MAIN
+#  include <boost/test/prg_exec_monitor.hpp>
+#else
+#  include <boost/detail/lightweight_main.hpp>
+#endif
+
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <iostream>
+#include <vector>
+
+namespace fs = boost::filesystem;
+using fs::path;
+using fs::cached_path;
+
+namespace
+{
+  //  conversion_tests  ----------------------------------------------------------------//
+
+  void conversion_tests()
+  {
+    std::cout << "conversion_tests..." << std::endl;
+
+    path p("foo/bar.txt");
+    cached_path cp(p);
+    BOOST_TEST(cp.get() == p);
+    BOOST_TEST(cp.native() == p.native());
+    BOOST_TEST(cp.string() == p.string());
+    BOOST_TEST(cp.wstring() == p.wstring());
+    BOOST_TEST(cp.u16string() == p.u16string());
+    BOOST_TEST(cp.u32string() == p.u32string());
+
+    // cached: the same object is returned each time
+    BOOST_TEST(&cp.wstring() == &cp.wstring());
+    BOOST_TEST(&cp.string() == &cp.string());
+    BOOST_TEST(&cp.u16string() == &cp.u16string());
+
+    // implicit conversion to const path&
+    const path& ref = cp;
+    BOOST_TEST(ref == p);
+    BOOST_TEST(cached_path("foo") == cached_path(std::string("foo")));
+    BOOST_TEST(cached_path("a") < cached_path("b"));
+  }
+
+  //  invalidation_tests  --------------------------------------------------------------//
+
+  void invalidation_tests()
+  {
+    std::cout << "invalidation_tests..." << std::endl;
+
+    cached_path cp("foo");
+    BOOST_TEST(cp.wstring() == L"foo");
+    BOOST_TEST(cp.u32string().size() == 3);
+
+    cp /= "bar";
+    BOOST_TEST(cp.wstring() == path("foo/bar").wstring());
+    BOOST_TEST(cp.u32string() == path("foo/bar").u32string());
+
+    cp += ".txt";
+    BOOST_TEST(cp.wstring() == path("foo/bar.txt").wstring());
+
+    cp.replace_extension(".dat");
+    BOOST_TEST(cp.wstring() == path("foo/bar.dat").wstring());
+    BOOST_TEST(cp.u16string() == path("foo/bar.dat").u16string());
+
+    cp.remove_filename();
+    BOOST_TEST(cp.wstring() == path("foo").wstring());
+
+    cp = path("baz");
+    BOOST_TEST(cp.wstring() == L"baz");
+
+    cached_path other("qux");
+    BOOST_TEST(other.wstring() == L"qux");
+    swap(cp, other);
+    BOOST_TEST(cp.wstring() == L"qux");
+    BOOST_TEST(other.wstring() == L"baz");
+
+    cp = other;
+    BOOST_TEST(cp.wstring() == L"baz");
+    cached_path copy(cp);
+    BOOST_TEST(copy.wstring() == L"baz");
+
+    cp.clear();
+    BOOST_TEST(cp.wstring().empty());
+    BOOST_TEST(cp.empty());
+  }
+
+  //  thread_tests: concurrent const access  -------------------------------------------//
+
+  void read_many(const cached_path* cp, const std::wstring* expected, int* failures)
+  {
+    for (int i = 0; i < 1000; ++i)
+    {
+      if (cp->wstring() != *expected || cp->u32string().size() != expected->size())
+        ++*failures;
+    }
+  }
+
+  void thread_tests()
+  {
+    std::cout << "thread_tests..." << std::endl;
+
+    for (int round = 0; round < 20; ++round)
+    {
+      cached_path cp("some/shared/read-only/path");
+      std::wstring expected(path("some/shared/read-only/path").wstring());
+      const int n = 8;
+      std::vector<int> failures(n, 0);
+      boost::thread_group threads;
+      for (int i = 0; i < n; ++i)
+        threads.create_thread(boost::bind(read_many, &cp, &expected, &failures[i]));
+      threads.join_all();
+      for (int i = 0; i < n; ++i)
+        BOOST_TEST_EQ(failures[i], 0);
+    }
+  }
+
+}  // unnamed namespace
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//                                    main                                              //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+int cpp_main(int, char*[])
+{
+  conversion_tests();
+  invalidation_tests();
+  thread_tests();
+
+  return ::boost::report_errors();
+}
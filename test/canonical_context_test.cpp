@@ -0,0 +1,243 @@
+//  canonical_context_test.cpp  --------------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+#include <boost/config/warning_disable.hpp>
+
+//  See deprecated_test for tests of deprecated features
+#ifndef BOOST_FILESYSTEM_NO_DEPRECATED
+#  define BOOST_FILESYSTEM_NO_DEPRECATED
+#endif
+#ifndef BOOST_SYSTEM_NO_DEPRECATED
+#  define BOOST_SYSTEM_NO_DEPRECATED
+#endif
+
+#include <boost/filesystem/canonical_context.hpp>
+
+#include <boost/config.hpp>
+# if defined( BOOST_NO_STD_WSTRING )
+#   error Configuration not supported: Boost.Filesystem V3 and later requires std::wstring support
+# endif
+
+#include <boost/detail/lightweight_test.hpp>
+
+#ifndef BOOST_LIGHTWEIGHT_MAIN
+#  include <boost/test/prg_exec_monitor.hpp>
+#else
+#  include <boost/detail/lightweight_main.hpp>
+#endif
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace fs = boost::filesystem;
+using fs::path;
+using fs::canonical_context;
+
+namespace
+{
+  void create_file(const path& ph)
+  {
+    std::ofstream f(ph.string().c_str());
+    BOOST_TEST(f);
+  }
+
+  //  no_symlink_tests: results must match canonical() without a context  -------------//
+
+  void no_symlink_tests(const path& dir)
+  {
+    std::cout << "no_symlink_tests..." << std::endl;
+
+    canonical_context ctx;
+    path p(dir / "real" / "sub" / "." / ".." / "sub" / "file");
+    BOOST_TEST(fs::canonical(p, ctx) == fs::canonical(p));
+    boost::uintmax_t misses = ctx.misses();
+    boost::uintmax_t hits = ctx.hits();
+    BOOST_TEST(misses > 0);
+    BOOST_TEST(hits > 0);  // "sub" is revisited after ".."
+
+    BOOST_TEST(fs::canonical(p, ctx) == fs::canonical(p));
+    BOOST_TEST_EQ(ctx.misses(), misses);  // every prefix came from the cache
+    BOOST_TEST(ctx.hits() > hits);
+
+    // relative to a base
+    BOOST_TEST(fs::canonical("sub/file", dir / "real", ctx)
+      == fs::canonical("sub/file", dir / "real"));
+
+    // errors are reported, and not cached
+    boost::system::error_code ec;
+    BOOST_TEST(fs::canonical(dir / "no-such-file", ctx, ec).empty());
+    BOOST_TEST(ec);
+    bool thrown = false;
+    try { fs::canonical(dir / "no-such-file", ctx); }
+    catch (const fs::filesystem_error&) { thrown = true; }
+    BOOST_TEST(thrown);
+  }
+
+  //  symlink_tests  -------------------------------------------------------------------//
+
+  void symlink_tests(const path& dir)
+  {
+    std::cout << "symlink_tests..." << std::endl;
+
+    boost::system::error_code ec;
+    fs::create_directory_symlink(dir / "real", dir / "link", ec);
+    if (ec)
+    {
+      std::cout << "  create_directory_symlink() failed, so symlink tests skipped"
+                << std::endl;
+      return;
+    }
+    fs::create_directory(dir / "other");
+    fs::create_directory(dir / "other" / "sub");
+    create_file(dir / "other" / "sub" / "file");
+
+    canonical_context ctx;
+    path p(dir / "link" / "sub" / "file");
+    path real(fs::canonical(dir / "real" / "sub" / "file"));
+    BOOST_TEST(fs::canonical(p, ctx) == real);
+    BOOST_TEST(fs::canonical(p, ctx) == real);
+    BOOST_TEST(ctx.hits() > 0);
+
+    // the realpath() fast path and the portable scan must agree
+    BOOST_TEST(fs::canonical(p) == real);
+    BOOST_TEST(fs::detail::canonical_scan(p, fs::current_path()) == real);
+    BOOST_TEST(fs::canonical(dir / "link" / "sub" / ".." / "sub" / "file")
+      == fs::detail::canonical_scan(dir / "link" / "sub" / ".." / "sub" / "file",
+           fs::current_path()));
+
+    // retarget the link; the cache is stale until invalidated
+    fs::remove(dir / "link");
+    fs::create_directory_symlink(dir / "other", dir / "link");
+    BOOST_TEST(fs::canonical(p, ctx) == real);
+    ctx.invalidate(dir / "link");
+    BOOST_TEST(fs::canonical(p, ctx) == fs::canonical(dir / "other" / "sub" / "file"));
+
+    // a zero ttl never uses the cache
+    canonical_context zero(100, canonical_context::clock::duration::zero());
+    fs::remove(dir / "link");
+    fs::create_directory_symlink(dir / "real", dir / "link");
+    BOOST_TEST(fs::canonical(p, zero) == real);
+    fs::remove(dir / "link");
+    fs::create_directory_symlink(dir / "other", dir / "link");
+    BOOST_TEST(fs::canonical(p, zero) == fs::canonical(dir / "other" / "sub" / "file"));
+  }
+
+  //  bound_tests  ---------------------------------------------------------------------//
+
+  void bound_tests(const path& dir)
+  {
+    std::cout << "bound_tests..." << std::endl;
+
+    canonical_context ctx(3);
+    BOOST_TEST_EQ(ctx.max_entries(), 3U);
+    for (int i = 0; i < 10; ++i)
+    {
+      BOOST_TEST(fs::canonical(dir / "real" / "sub" / "file", ctx)
+        == fs::canonical(dir / "real" / "sub" / "file"));
+      BOOST_TEST(fs::canonical(dir / "real", ctx) == fs::canonical(dir / "real"));
+      BOOST_TEST(ctx.size() <= 3U);
+    }
+    ctx.clear();
+    BOOST_TEST_EQ(ctx.size(), 0U);
+  }
+
+  //  batch_tests: each result must match canonical() of the same path  ---------------//
+
+  void batch_tests(const path& dir)
+  {
+    std::cout << "batch_tests..." << std::endl;
+
+    boost::system::error_code ec;
+    fs::create_directory(dir / "real" / "sub-x");
+    create_file(dir / "real" / "sub-x" / "file");
+    fs::create_directory_symlink(dir / "real" / "sub", dir / "real" / "sublink", ec);
+    bool symlinks = !ec;
+
+    std::vector<path> paths;
+    paths.push_back(dir / "real" / "sub-x" / "file");
+    paths.push_back(dir / "real" / "sub" / "file");
+    paths.push_back("sub/file");   // relative to the base
+    paths.push_back(dir / "real");
+    paths.push_back(dir / "real" / "sub");
+    paths.push_back(dir / "real" / "sub" / "file");  // duplicate
+    paths.push_back(dir / "real" / "sub" / ".." / "sub-x" / "file");
+    paths.push_back(dir / "real" / "sub" / "no-such-file");
+    paths.push_back(dir / "real" / "no-such-dir" / "file");
+    paths.push_back(dir / "real" / "sub" / "file" / "not-a-dir");
+    paths.push_back(dir / "real" / "sub-x" / "file");
+    paths.push_back(dir / "real" / "sub" / "");
+    if (symlinks)
+    {
+      paths.push_back(dir / "real" / "sublink" / "file");
+      paths.push_back(dir / "real" / "sublink");
+    }
+
+    std::vector<path> results;
+    std::vector<boost::system::error_code> errors;
+    fs::canonical_batch(paths, dir / "real", results, errors);
+    BOOST_TEST_EQ(results.size(), paths.size());
+    BOOST_TEST_EQ(errors.size(), paths.size());
+    for (std::size_t i = 0; i != paths.size(); ++i)
+    {
+      boost::system::error_code single_ec;
+      path single(fs::canonical(paths[i], dir / "real", single_ec));
+      BOOST_TEST(results[i] == single);
+      BOOST_TEST(!errors[i] == !single_ec);
+      if (results[i] != single)
+        std::cout << "  " << paths[i] << ": " << results[i] << " != " << single
+                  << std::endl;
+    }
+    BOOST_TEST(errors[7]);
+    BOOST_TEST(errors[8]);
+    BOOST_TEST(errors[9]);
+    BOOST_TEST(results[7].empty());
+
+    // with a context
+    canonical_context ctx;
+    std::vector<path> ctx_results;
+    fs::canonical_batch(paths, dir / "real", ctx_results, errors, &ctx);
+    BOOST_TEST(ctx_results == results);
+    BOOST_TEST(ctx.misses() > 0);
+
+    // empty input
+    fs::canonical_batch(std::vector<path>(), results, errors);
+    BOOST_TEST(results.empty());
+    BOOST_TEST(errors.empty());
+
+    if (symlinks)
+      fs::remove(dir / "real" / "sublink");
+  }
+
+}  // unnamed namespace
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//                                    main                                              //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+int cpp_main(int, char*[])
+{
+  path dir(fs::canonical(fs::temp_directory_path())
+    / fs::unique_path("canonical_context_test-%%%%-%%%%"));
+  fs::create_directory(dir);
+  fs::create_directory(dir / "real");
+  fs::create_directory(dir / "real" / "sub");
+  create_file(dir / "real" / "sub" / "file");
+
+  no_symlink_tests(dir);
+  symlink_tests(dir);
+  bound_tests(dir);
+  batch_tests(dir);
+
+  fs::remove_all(dir);
+
+  return ::boost::report_errors();
+}
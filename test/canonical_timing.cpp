@@ -0,0 +1,151 @@
+//  canonical_timing.cpp  --------------------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+//  Compares canonical(), which uses realpath() on POSIX, with the portable element by
+//  element scan, on a deep directory tree with a symlink at every level, and
+//  canonical_batch() with canonical() on each of a directory's files.
+//
+//  Usage: canonical_timing [depth [iterations]]
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/canonical_context.hpp>
+#include <boost/chrono.hpp>
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <string>
+#include <sstream>
+#include <vector>
+
+namespace fs = boost::filesystem;
+using fs::path;
+using boost::chrono::steady_clock;
+using boost::chrono::duration;
+
+namespace
+{
+  std::string num(int i)
+  {
+    std::ostringstream ss;
+    ss << i;
+    return ss.str();
+  }
+
+  template <class F>
+  double seconds(F f, int iterations)
+  {
+    steady_clock::time_point start(steady_clock::now());
+    for (int i = 0; i < iterations; ++i)
+      f();
+    return duration<double>(steady_clock::now() - start).count();
+  }
+
+  struct run_canonical
+  {
+    const path& p;
+    explicit run_canonical(const path& p_) : p(p_) {}
+    void operator()() const { fs::canonical(p); }
+  };
+
+  struct run_scan
+  {
+    const path& p;
+    explicit run_scan(const path& p_) : p(p_) {}
+    void operator()() const { fs::detail::canonical_scan(p, fs::current_path()); }
+  };
+
+  struct run_context
+  {
+    const path& p;
+    fs::canonical_context& ctx;
+    run_context(const path& p_, fs::canonical_context& ctx_) : p(p_), ctx(ctx_) {}
+    void operator()() const { fs::canonical(p, ctx); }
+  };
+
+  struct run_each
+  {
+    const std::vector<path>& paths;
+    explicit run_each(const std::vector<path>& paths_) : paths(paths_) {}
+    void operator()() const
+    {
+      for (std::size_t i = 0; i != paths.size(); ++i)
+        fs::canonical(paths[i]);
+    }
+  };
+
+  struct run_batch
+  {
+    const std::vector<path>& paths;
+    explicit run_batch(const std::vector<path>& paths_) : paths(paths_) {}
+    void operator()() const
+    {
+      std::vector<path> results;
+      std::vector<boost::system::error_code> errors;
+      fs::canonical_batch(paths, results, errors);
+    }
+  };
+}
+
+int main(int argc, char* argv[])
+{
+  int depth = argc > 1 ? std::atoi(argv[1]) : 16;
+  int iterations = argc > 2 ? std::atoi(argv[2]) : 10000;
+
+  // dir/d0/l1 -> d1, d1/l2 -> d2, ..., so each level is reached through a symlink
+  path dir(fs::temp_directory_path() / fs::unique_path("canonical_timing-%%%%-%%%%"));
+  fs::create_directories(dir / "d0");
+  path p(dir / "d0");
+  for (int i = 1; i <= depth; ++i)
+  {
+    std::string n(num(i));
+    fs::create_directory(dir / ("d" + n));
+    fs::create_directory_symlink(dir / ("d" + n), dir / ("d" + num(i-1))
+      / ("l" + n));
+    p /= "l" + n;
+  }
+
+  std::cout << "path: " << p << "\n"
+            << "depth " << depth << ", " << iterations << " iterations\n";
+
+  if (fs::canonical(p) != fs::detail::canonical_scan(p, fs::current_path()))
+    std::cout << "error: results differ\n";
+
+  fs::canonical_context ctx;
+  double fast = seconds(run_canonical(p), iterations);
+  double scan = seconds(run_scan(p), iterations);
+  double cached = seconds(run_context(p, ctx), iterations);
+
+  std::cout << "  canonical()           " << fast << " sec\n"
+            << "  canonical_scan()      " << scan << " sec\n"
+            << "  canonical(p, context) " << cached << " sec\n";
+
+  std::vector<path> files;
+  for (int i = 0; i < 100; ++i)
+  {
+    files.push_back(p / ("f" + num(i)));
+    std::ofstream f(files.back().string().c_str());
+  }
+  std::vector<path> results;
+  std::vector<boost::system::error_code> errors;
+  fs::canonical_batch(files, results, errors);
+  for (std::size_t i = 0; i != files.size(); ++i)
+    if (results[i] != fs::canonical(files[i]))
+      std::cout << "error: batch result differs for " << files[i] << "\n";
+
+  int rounds = iterations / 100 > 0 ? iterations / 100 : 1;
+  double each = seconds(run_each(files), rounds);
+  double batch = seconds(run_batch(files), rounds);
+
+  std::cout << files.size() << " files, " << rounds << " iterations\n"
+            << "  canonical() each      " << each << " sec\n"
+            << "  canonical_batch()     " << batch << " sec\n";
+
+  fs::remove_all(dir);
+  return 0;
+}
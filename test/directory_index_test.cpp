@@ -0,0 +1,286 @@
+//  directory_index_test.cpp  ----------------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+#include <boost/config/warning_disable.hpp>
+
+//  See deprecated_test for tests of deprecated features
+#ifndef BOOST_FILESYSTEM_NO_DEPRECATED
+#  define BOOST_FILESYSTEM_NO_DEPRECATED
+#endif
+#ifndef BOOST_SYSTEM_NO_DEPRECATED
+#  define BOOST_SYSTEM_NO_DEPRECATED
+#endif
+
+#include <boost/filesystem/directory_index.hpp>
+
+#include <boost/config.hpp>
+# if defined( BOOST_NO_STD_WSTRING )
+#   error Configuration not supported: Boost.Filesystem V3 and later requires std::wstring support
+# endif
+
+#include <boost/detail/lightweight_test.hpp>
+
+#ifndef BOOST_LIGHTWEIGHT_MAIN
+#  include <boost/test/prg_exec_monitor.hpp>
+#else
+#  include <boost/detail/lightweight_main.hpp>
+#endif
+
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+namespace fs = boost::filesystem;
+using fs::path;
+using fs::tree_snapshot;
+using fs::directory_index;
+using boost::system::error_code;
+
+namespace
+{
+  void create_file(const path& ph, const std::string& contents = std::string())
+  {
+    std::ofstream f(ph.string().c_str(), std::ios_base::out | std::ios_base::binary);
+    BOOST_TEST(f);
+    f << contents;
+  }
+
+  bool contains(const std::vector<path>& v, const path& p)
+  {
+    return std::find(v.begin(), v.end(), p) != v.end();
+  }
+
+  //  round_trip_tests: the index holds what the snapshot held  -----------------------//
+
+  void round_trip_tests(const path& tree, const path& index_file)
+  {
+    std::cout << "round_trip_tests..." << std::endl;
+
+    tree_snapshot snap(tree);
+    directory_index::write(snap, index_file);
+
+    directory_index index(index_file);
+    BOOST_TEST(index.is_open());
+    BOOST_TEST(index.root() == tree);
+    BOOST_TEST(index.root_last_write_time() == snap.root_last_write_time());
+    BOOST_TEST_EQ(index.size(), snap.size());
+    for (std::size_t i = 0; i != snap.size(); ++i)
+    {
+      fs::snapshot_entry a(snap[i]), b(index[i]);
+      BOOST_TEST(a.relative_path == b.relative_path);
+      BOOST_TEST(a.type == b.type);
+      BOOST_TEST_EQ(a.size, b.size);
+      BOOST_TEST(a.last_write_time == b.last_write_time);
+      BOOST_TEST_EQ(a.inode, b.inode);
+    }
+
+    index.close();
+    BOOST_TEST(!index.is_open());
+    BOOST_TEST_EQ(index.size(), 0U);
+  }
+
+  //  lookup_tests  --------------------------------------------------------------------//
+
+  void lookup_tests(const path& index_file)
+  {
+    std::cout << "lookup_tests..." << std::endl;
+
+    // a, a/b, a/b/c, a/b/e, a/f, a-z, d
+    directory_index index(index_file);
+    BOOST_TEST_EQ(index.size(), 7U);
+
+    std::size_t a = index.find("a");
+    std::size_t b = index.find(path("a") / "b");
+    std::size_t c = index.find(path("a") / "b" / "c");
+    BOOST_TEST_EQ(a, 0U);
+    BOOST_TEST_EQ(b, 1U);
+    BOOST_TEST_EQ(c, 2U);
+    BOOST_TEST_EQ(index.find("a-z"), 5U);
+    BOOST_TEST_EQ(index.find("missing"), index.size());
+    BOOST_TEST_EQ(index.find(path("a") / "missing"), index.size());
+
+    BOOST_TEST(index.type(b) == fs::file_type::directory);
+    BOOST_TEST(index.type(c) == fs::file_type::regular);
+    BOOST_TEST_EQ(index.file_size(c), 3U);
+
+    // parent links
+    BOOST_TEST_EQ(index.parent(a), directory_index::npos);
+    BOOST_TEST_EQ(index.parent(b), a);
+    BOOST_TEST_EQ(index.parent(c), b);
+    BOOST_TEST_EQ(index.parent(index.find(path("a") / "f")), a);
+    BOOST_TEST_EQ(index.parent(index.find("d")), directory_index::npos);
+
+    // the entries below a directory are contiguous
+    BOOST_TEST_EQ(index.subtree_end(a), 5U);
+    BOOST_TEST_EQ(index.subtree_end(b), 4U);
+    BOOST_TEST_EQ(index.subtree_end(c), 3U);
+
+    std::pair<std::size_t, std::size_t> r(index.below("a"));
+    BOOST_TEST_EQ(r.first, 1U);
+    BOOST_TEST_EQ(r.second, 5U);
+    r = index.below(path("a") / "b");
+    BOOST_TEST(index.relative_path(r.first) == path("a") / "b" / "c");
+    BOOST_TEST(index.relative_path(r.second - 1) == path("a") / "b" / "e");
+    r = index.below("");
+    BOOST_TEST_EQ(r.first, 0U);
+    BOOST_TEST_EQ(r.second, index.size());
+    r = index.below("d");  // not a directory
+    BOOST_TEST(r.first == r.second);
+    r = index.below("missing");
+    BOOST_TEST(r.first == r.second);
+  }
+
+  //  validation_tests  ----------------------------------------------------------------//
+
+  void validation_tests(const path& tree, const path& index_file)
+  {
+    std::cout << "validation_tests..." << std::endl;
+
+    directory_index::write(tree_snapshot(tree), index_file);
+    directory_index index(index_file);
+    std::vector<path> stale;
+    BOOST_TEST(index.is_current());
+    BOOST_TEST(index.is_current(&stale));
+    BOOST_TEST(stale.empty());
+
+    // rewriting a file in place is not detected; see directory_index.hpp
+    create_file(tree / "a" / "b" / "c", "xyz");
+    BOOST_TEST(index.is_current());
+
+    // adding to a directory makes it, and only it, stale
+    create_file(tree / "a" / "b" / "new");
+    BOOST_TEST(!index.is_current());
+    BOOST_TEST(!index.is_current(&stale));
+    BOOST_TEST_EQ(stale.size(), 1U);
+    BOOST_TEST(contains(stale, path("a") / "b"));
+
+    // as does removing, and the root is reported as an empty path
+    fs::remove(tree / "d");
+    stale.clear();
+    error_code ec;
+    BOOST_TEST(!index.is_current(&stale, ec));
+    BOOST_TEST(!ec);
+    BOOST_TEST_EQ(stale.size(), 2U);
+    BOOST_TEST(contains(stale, path()));
+    BOOST_TEST(contains(stale, path("a") / "b"));
+
+    // a removed directory is stale
+    fs::remove(tree / "a" / "b" / "new");
+    fs::remove(tree / "a" / "b" / "c");
+    fs::remove(tree / "a" / "b" / "e");
+    fs::remove(tree / "a" / "b");
+    stale.clear();
+    index.is_current(&stale);
+    BOOST_TEST(contains(stale, path("a")));
+    BOOST_TEST(contains(stale, path("a") / "b"));
+
+    // rewriting replaces the file; the open index keeps the old contents
+    directory_index::write(tree_snapshot(tree), index_file);
+    BOOST_TEST_EQ(index.size(), 7U);
+    BOOST_TEST(index.find(path("a") / "b") != index.size());
+    directory_index fresh(index_file);
+    BOOST_TEST_EQ(fresh.size(), 3U);  // a, a/f, a-z
+    BOOST_TEST(fresh.is_current());
+  }
+
+  //  error_tests  ---------------------------------------------------------------------//
+
+  void error_tests(const path& dir)
+  {
+    std::cout << "error_tests..." << std::endl;
+
+    directory_index index;
+    BOOST_TEST(!index.is_open());
+    BOOST_TEST(index.empty());
+
+    error_code ec;
+    index.open(dir / "no-such-index", ec);
+    BOOST_TEST(!!ec);
+    BOOST_TEST(!index.is_open());
+
+    bool threw = false;
+    try { index.open(dir / "no-such-index"); }
+    catch (const fs::filesystem_error&) { threw = true; }
+    BOOST_TEST(threw);
+
+    // not an index
+    create_file(dir / "garbage", std::string(512, 'x'));
+    index.open(dir / "garbage", ec);
+    BOOST_TEST(ec == boost::system::errc::bad_message);
+    BOOST_TEST(!index.is_open());
+
+    // truncated
+    directory_index::write(tree_snapshot(dir / "tree"), dir / "truncated");
+    fs::resize_file(dir / "truncated", fs::file_size(dir / "truncated") - 1);
+    index.open(dir / "truncated", ec);
+    BOOST_TEST(ec == boost::system::errc::bad_message);
+
+    // a damaged entry is found when it is read, not by open()
+    directory_index::write(tree_snapshot(dir / "tree"), dir / "damaged");
+    {
+      std::fstream f((dir / "damaged").string().c_str(),
+        std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+      f.seekp(144);  // the first entry's name offset, just after the header
+      f.write("\xff\xff\xff\xff\xff\xff\xff\xff", 8);
+    }
+    index.open(dir / "damaged", ec);
+    BOOST_TEST(!ec);
+    threw = false;
+    try { index.relative_path(0); }
+    catch (const fs::filesystem_error& ex)
+    {
+      threw = ex.code() == boost::system::errc::bad_message;
+    }
+    BOOST_TEST(threw);
+    index.close();
+
+    // an index of an empty directory
+    fs::create_directory(dir / "empty");
+    directory_index::write(tree_snapshot(dir / "empty"), dir / "empty.idx");
+    index.open(dir / "empty.idx", ec);
+    BOOST_TEST(!ec);
+    BOOST_TEST(index.empty());
+    BOOST_TEST_EQ(index.find("x"), 0U);
+    BOOST_TEST(index.is_current());
+
+    directory_index::write(tree_snapshot(), dir / "no-such-dir" / "x.idx", ec);
+    BOOST_TEST(!!ec);
+  }
+
+}  // unnamed namespace
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//                                    main                                              //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+int cpp_main(int, char*[])
+{
+  path dir(fs::temp_directory_path() / fs::unique_path("directory_index_test-%%%%-%%%%"));
+  fs::create_directory(dir);
+
+  // the index is kept outside the tree, so writing it does not change the tree
+  path tree(dir / "tree");
+  fs::create_directories(tree / "a" / "b");
+  create_file(tree / "a" / "b" / "c", "abc");
+  create_file(tree / "a" / "b" / "e");
+  create_file(tree / "a" / "f");
+  create_file(tree / "a-z");
+  create_file(tree / "d");
+
+  round_trip_tests(tree, dir / "tree.idx");
+  lookup_tests(dir / "tree.idx");
+  validation_tests(tree, dir / "tree.idx");
+  error_tests(dir);
+
+  fs::remove_all(dir);
+
+  return ::boost::report_errors();
+}
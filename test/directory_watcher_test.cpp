@@ -0,0 +1,276 @@
+//  directory_watcher_test.cpp  --------------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+#include <boost/config/warning_disable.hpp>
+
+//  See deprecated_test for tests of deprecated features
+#ifndef BOOST_FILESYSTEM_NO_DEPRECATED
+#  define BOOST_FILESYSTEM_NO_DEPRECATED
+#endif
+#ifndef BOOST_SYSTEM_NO_DEPRECATED
+#  define BOOST_SYSTEM_NO_DEPRECATED
+#endif
+
+#include <boost/filesystem/directory_watcher.hpp>
+#include <boost/filesystem/status_cache.hpp>
+
+#include <boost/config.hpp>
+# if defined( BOOST_NO_STD_WSTRING )
+#   error Configuration not supported: Boost.Filesystem V3 and later requires std::wstring support
+# endif
+
+#include <boost/detail/lightweight_test.hpp>
+
+#ifndef BOOST_LIGHTWEIGHT_MAIN
+#  include <boost/test/prg_exec_monitor.hpp>
+#else
+#  include <boost/detail/lightweight_main.hpp>
+#endif
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace fs = boost::filesystem;
+using fs::path;
+using fs::directory_watcher;
+using fs::watch_event;
+using fs::change_kind;
+using boost::system::error_code;
+
+namespace
+{
+  void create_file(const path& ph, const std::string& contents = std::string())
+  {
+    std::ofstream f(ph.string().c_str());
+    BOOST_TEST(f);
+    f << contents;
+  }
+
+  //  read everything pending; a short timeout lets the kernel queue the events
+  std::vector<watch_event> drain(directory_watcher& w)
+  {
+    std::vector<watch_event> events;
+    while (w.read(events, boost::chrono::milliseconds(100)) != 0) {}
+    return events;
+  }
+
+  bool has(const std::vector<watch_event>& events, BOOST_SCOPED_ENUM(change_kind) kind,
+    const path& p)
+  {
+    for (std::size_t i = 0; i != events.size(); ++i)
+      if (events[i].kind == kind && events[i].path == p)
+        return true;
+    return false;
+  }
+
+#ifdef BOOST_FILESYSTEM_HAS_DIRECTORY_WATCHER
+
+  //  basic_tests  ---------------------------------------------------------------------//
+
+  void basic_tests(const path& dir)
+  {
+    std::cout << "basic_tests..." << std::endl;
+
+    path d(dir / "basic");
+    fs::create_directory(d);
+    directory_watcher w;
+    BOOST_TEST(w.native_handle() != -1);
+    w.add(d);
+    BOOST_TEST_EQ(w.watch_count(), 1U);
+
+    std::vector<watch_event> events;
+    BOOST_TEST_EQ(w.read(events, boost::chrono::milliseconds(0)), 0U);
+
+    create_file(d / "a", "1");
+    create_file(d / "a", "22");
+    fs::rename(d / "a", d / "b");
+    fs::remove(d / "b");
+    events = drain(w);
+
+    BOOST_TEST(has(events, change_kind::created, d / "a"));
+    BOOST_TEST(has(events, change_kind::modified, d / "a"));
+    BOOST_TEST(has(events, change_kind::renamed, d / "b"));
+    BOOST_TEST(has(events, change_kind::removed, d / "b"));
+    for (std::size_t i = 0; i != events.size(); ++i)
+    {
+      if (events[i].kind == change_kind::renamed)
+        BOOST_TEST(events[i].old_path == d / "a");
+      BOOST_TEST(!events[i].is_directory);
+    }
+
+    // not recursive: changes in a subdirectory are not reported
+    fs::create_directory(d / "sub");
+    events = drain(w);
+    BOOST_TEST(has(events, change_kind::created, d / "sub"));
+    create_file(d / "sub" / "c");
+    events = drain(w);
+    BOOST_TEST(!has(events, change_kind::created, d / "sub" / "c"));
+
+    w.remove(d);
+    BOOST_TEST_EQ(w.watch_count(), 0U);
+    error_code ec;
+    w.remove(d, ec);
+    BOOST_TEST(!!ec);
+  }
+
+  //  recursive_tests  -----------------------------------------------------------------//
+
+  void recursive_tests(const path& dir)
+  {
+    std::cout << "recursive_tests..." << std::endl;
+
+    path d(dir / "tree");
+    fs::create_directory(d);
+    fs::create_directory(d / "x");
+    fs::create_directory(d / "x" / "y");
+    directory_watcher w;
+    w.add(d, true);
+    BOOST_TEST_EQ(w.watch_count(), 3U);
+
+    create_file(d / "x" / "y" / "deep");
+    std::vector<watch_event> events(drain(w));
+    BOOST_TEST(has(events, change_kind::created, d / "x" / "y" / "deep"));
+
+    // a new directory is watched, and its existing contents reported
+    fs::create_directories(d / "n" / "m");
+    create_file(d / "n" / "m" / "f");
+    events = drain(w);
+    BOOST_TEST(has(events, change_kind::created, d / "n"));
+    BOOST_TEST(has(events, change_kind::created, d / "n" / "m" / "f"));
+    BOOST_TEST_EQ(w.watch_count(), 5U);
+
+    // a directory renamed within the tree keeps its watches, under the new name
+    fs::rename(d / "n", d / "renamed");
+    events = drain(w);
+    BOOST_TEST(has(events, change_kind::renamed, d / "renamed"));
+    create_file(d / "renamed" / "m" / "g");
+    events = drain(w);
+    BOOST_TEST(has(events, change_kind::created, d / "renamed" / "m" / "g"));
+
+    // a directory moved out is reported as removed and no longer watched
+    fs::rename(d / "renamed", dir / "outside");
+    events = drain(w);
+    BOOST_TEST(has(events, change_kind::removed, d / "renamed"));
+    BOOST_TEST_EQ(w.watch_count(), 3U);
+    fs::remove_all(dir / "outside");
+
+    fs::remove_all(d / "x");
+    events = drain(w);
+    BOOST_TEST(has(events, change_kind::removed, d / "x" / "y" / "deep"));
+    BOOST_TEST(has(events, change_kind::removed, d / "x"));
+    BOOST_TEST_EQ(w.watch_count(), 1U);
+
+    // removing the root itself
+    fs::remove(d);
+    events = drain(w);
+    BOOST_TEST(has(events, change_kind::removed, d));
+    BOOST_TEST_EQ(w.watch_count(), 0U);
+  }
+
+  //  cache_tests: events invalidate an attached status_cache  ------------------------//
+
+  void cache_tests(const path& dir)
+  {
+    std::cout << "cache_tests..." << std::endl;
+
+    path d(dir / "cached");
+    fs::create_directory(d);
+    fs::status_cache cache(fs::status_cache::clock::duration::max());
+    directory_watcher w;
+    w.attach(&cache);
+    BOOST_TEST(w.attached() == &cache);
+    w.add(d, true);
+
+    BOOST_TEST(!fs::exists(d / "f", cache));
+    create_file(d / "f", "abc");
+    drain(w);
+    BOOST_TEST(fs::exists(d / "f", cache));
+    BOOST_TEST_EQ(fs::file_size(d / "f", cache), 3U);
+
+    create_file(d / "f", "abcdef");
+    drain(w);
+    BOOST_TEST_EQ(fs::file_size(d / "f", cache), 6U);
+
+    fs::remove(d / "f");
+    drain(w);
+    BOOST_TEST(!fs::exists(d / "f", cache));
+  }
+
+  //  error_tests  ---------------------------------------------------------------------//
+
+  void error_tests(const path& dir)
+  {
+    std::cout << "error_tests..." << std::endl;
+
+    directory_watcher w;
+    error_code ec;
+    w.add(dir / "no-such-directory", false, ec);
+    BOOST_TEST(!!ec);
+
+    bool threw = false;
+    try { w.add(dir / "no-such-directory"); }
+    catch (const fs::filesystem_error&) { threw = true; }
+    BOOST_TEST(threw);
+
+    create_file(dir / "not-a-directory");
+    w.add(dir / "not-a-directory", false, ec);
+    BOOST_TEST(!!ec);
+    BOOST_TEST_EQ(w.watch_count(), 0U);
+
+    // a new subdirectory that cannot be watched is reported after the events queued
+    // behind it, not instead of them; run as root, it can be watched
+    path t(dir / "unwatchable");
+    fs::create_directory(t);
+    directory_watcher rw;
+    rw.add(t, true);
+    create_file(t / "a");
+    fs::create_directory(t / "locked");
+    fs::permissions(t / "locked", fs::no_perms);
+    create_file(t / "b");
+    std::vector<watch_event> events;
+    rw.read(events, boost::chrono::milliseconds(100), ec);
+    BOOST_TEST(!ec || ec == boost::system::errc::permission_denied);
+    BOOST_TEST(has(events, change_kind::created, t / "a"));
+    BOOST_TEST(has(events, change_kind::created, t / "locked"));
+    BOOST_TEST(has(events, change_kind::created, t / "b"));
+    fs::permissions(t / "locked", fs::owner_all);
+  }
+
+#endif
+
+}  // unnamed namespace
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//                                    main                                              //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+int cpp_main(int, char*[])
+{
+#ifdef BOOST_FILESYSTEM_HAS_DIRECTORY_WATCHER
+  path dir(fs::temp_directory_path()
+    / fs::unique_path("directory_watcher_test-%%%%-%%%%"));
+  fs::create_directory(dir);
+
+  basic_tests(dir);
+  recursive_tests(dir);
+  cache_tests(dir);
+  error_tests(dir);
+
+  fs::remove_all(dir);
+#else
+  error_code ec;
+  directory_watcher w(ec);
+  BOOST_TEST(ec == boost::system::errc::not_supported);
+#endif
+
+  return ::boost::report_errors();
+}
@@ -136,6 +136,292 @@ namespace
       fs::remove(p);
 
   } // test
+
+  std::string contents(const fs::path & p)
+  {
+    fs::native_ifstream f(p);
+    return std::string(std::istreambuf_iterator<char>(f),
+      std::istreambuf_iterator<char>());
+  }
+
+  void native_test(const fs::path & p)
+  {
+    fs::remove(p);
+    {
+      std::cout << " in native test 1\n";  // small buffer; writes larger than it
+      fs::native_ofstream f;
+      f.rdbuf()->set_buffer_size(16);
+      BOOST_TEST_EQ(f.rdbuf()->buffer_size(), 16U);
+      BOOST_TEST(!f.is_open());
+      f.open(p);
+      BOOST_TEST(f.is_open());
+      BOOST_TEST(f.native_handle() == f.rdbuf()->native_handle());
+      f << "0123456789";
+      f << std::string(100, 'x');
+      f << 'y';
+      f.close();
+      BOOST_TEST(f);
+      BOOST_TEST(!f.is_open());
+      BOOST_TEST_EQ(fs::file_size(p), 111U);
+    }
+    {
+      std::cout << " in native test 2\n";
+      fs::native_ifstream f(p);
+      BOOST_TEST(f.is_open());
+      char buf[11] = {0};
+      f.read(buf, 10);
+      BOOST_TEST(std::string(buf) == "0123456789");
+      std::string rest;
+      f >> rest;
+      BOOST_TEST_EQ(rest.size(), 101U);
+      BOOST_TEST_EQ(rest[100], 'y');
+    }
+    {
+      std::cout << " in native test 3\n";  // switching between reading and writing
+      char buf[8];
+      fs::native_filebuf fb(0);
+      BOOST_TEST(fb.pubsetbuf(buf, sizeof(buf)) == &fb);
+      BOOST_TEST(fb.open(p, std::ios_base::in | std::ios_base::out
+        | std::ios_base::trunc) == &fb);
+      BOOST_TEST_EQ(fb.sputn("abcdefghijklmnop", 16), 16);
+      BOOST_TEST_EQ(fb.pubseekoff(2, std::ios_base::beg), 2);
+      BOOST_TEST_EQ(fb.sbumpc(), 'c');
+      BOOST_TEST_EQ(fb.sgetc(), 'd');
+      BOOST_TEST_EQ(fb.sputc('D'), 'D');  // overwrites 'd', not the end of the buffer
+      BOOST_TEST_EQ(fb.pubseekoff(0, std::ios_base::cur), 4);
+      BOOST_TEST_EQ(fb.sbumpc(), 'e');
+      BOOST_TEST_EQ(fb.pubseekpos(14), 14);
+      char tail[3] = {0};
+      BOOST_TEST_EQ(fb.sgetn(tail, 2), 2);
+      BOOST_TEST(std::string(tail) == "op");
+      BOOST_TEST(fb.close() == &fb);
+      BOOST_TEST(contents(p) == "abcDefghijklmnop");
+    }
+    {
+      std::cout << " in native test 4\n";  // unbuffered, append and ate
+      fs::native_ofstream f;
+      f.rdbuf()->pubsetbuf(0, 0);
+      BOOST_TEST_EQ(f.rdbuf()->buffer_size(), 0U);
+      f.open(p, std::ios_base::app);
+      f << "123";
+      f.close();
+      BOOST_TEST(contents(p) == "abcDefghijklmnop123");
+
+      fs::native_fstream fs2(p, std::ios_base::in | std::ios_base::out
+        | std::ios_base::ate);
+      BOOST_TEST(fs2.is_open());
+      BOOST_TEST_EQ(fs2.tellp(), 19);
+      fs2 << "!";
+      fs2.seekg(0);
+      std::string s;
+      fs2 >> s;
+      BOOST_TEST(s == "abcDefghijklmnop123!");
+    }
+    {
+      std::cout << " in native test 5\n";  // hints
+      fs::open_hints hints;
+      hints.access = fs::access_hint::sequential;
+      hints.willneed = true;
+      hints.preallocate = 1024 * 1024;
+      fs::native_ofstream f(p, std::ios_base::out, hints);
+      BOOST_TEST(f.is_open());
+      f << "z";
+      f.close();
+      BOOST_TEST_EQ(fs::file_size(p), 1U);  // preallocation does not change the size
+
+      fs::native_ifstream g(p, std::ios_base::in, hints);
+      BOOST_TEST(g.is_open());
+      BOOST_TEST_EQ(g.get(), 'z');
+    }
+    {
+      std::cout << " in native test 5a\n";  // uncached, past a drop-behind window
+      fs::open_hints hints;
+      hints.uncached = true;
+      std::string block(1024 * 1024 + 1, 'u');
+      {
+        fs::native_ofstream f(p, std::ios_base::out, hints);
+        for (int i = 0; i != 10; ++i)
+          f << block;
+        f.close();
+        BOOST_TEST(f);
+      }
+      BOOST_TEST_EQ(fs::file_size(p), 10U * block.size());
+      fs::native_ifstream g(p, std::ios_base::in, hints);
+      std::string s;
+      std::getline(g, s);
+      BOOST_TEST_EQ(s.size(), 10U * block.size());
+      BOOST_TEST_EQ(s[s.size() - 1], 'u');
+      g.seekg(5);
+      BOOST_TEST_EQ(g.get(), 'u');
+    }
+    {
+      std::cout << " in native test 6\n";  // errors
+      fs::native_filebuf fb;
+      BOOST_TEST(fb.open(p, std::ios_base::trunc) == 0);  // not a valid mode
+      BOOST_TEST(fb.error() == boost::system::errc::invalid_argument);
+      BOOST_TEST(fb.open(p / "no-such-file", std::ios_base::in) == 0);
+      BOOST_TEST(!!fb.error());
+      BOOST_TEST(fb.close() == 0);
+
+      fs::native_ifstream f(p / "no-such-file");
+      BOOST_TEST(!f);
+      BOOST_TEST(!f.is_open());
+      BOOST_TEST(f.native_handle() == fs::native_filebuf().native_handle());
+    }
+
+    if (cleanup)
+      fs::remove(p);
+  } // native_test
+
+  void atomic_test(const fs::path & p)
+  {
+    fs::remove(p);
+    {
+      std::cout << " in atomic test 1\n";  // creates the target on commit
+      fs::atomic_ofstream f(p);
+      BOOST_TEST(f.is_open());
+      BOOST_TEST(f.target_path() == p);
+      BOOST_TEST(fs::exists(f.temp_path()));
+      BOOST_TEST(f.temp_path().parent_path() == p.parent_path());
+      f << "first";
+      BOOST_TEST(!fs::exists(p));
+      f.commit(fs::commit_options::none);
+      BOOST_TEST(f);
+      BOOST_TEST(!f.is_open());
+      BOOST_TEST(contents(p) == "first");
+    }
+    {
+      std::cout << " in atomic test 2\n";  // replaces it, readers see old or new
+      fs::native_ifstream reader(p);
+      fs::atomic_ofstream f(p);
+      fs::path temp(f.temp_path());
+      f << std::string(200000, 'x');  // more than a buffer full
+      BOOST_TEST(contents(p) == "first");
+      boost::system::error_code ec;
+      f.commit(fs::commit_options::durable, ec);
+      BOOST_TEST(!ec);
+      BOOST_TEST(!fs::exists(temp));
+      BOOST_TEST_EQ(fs::file_size(p), 200000U);
+      std::string s;
+      reader >> s;
+      BOOST_TEST(s == "first");  // an open reader keeps the old file
+    }
+    {
+      std::cout << " in atomic test 3\n";  // uncommitted output is discarded
+      fs::path temp;
+      {
+        fs::atomic_ofstream f(p);
+        temp = f.temp_path();
+        f << "lost";
+      }
+      BOOST_TEST(!fs::exists(temp));
+      BOOST_TEST_EQ(fs::file_size(p), 200000U);
+
+      fs::atomic_ofstream f(p);
+      temp = f.temp_path();
+      f << "lost";
+      f.discard();
+      BOOST_TEST(!f.is_open());
+      BOOST_TEST(!fs::exists(temp));
+      BOOST_TEST_EQ(fs::file_size(p), 200000U);
+    }
+#   ifdef BOOST_POSIX_API
+    {
+      std::cout << " in atomic test 4\n";  // the target's permissions are kept
+      fs::permissions(p, fs::owner_read | fs::owner_write | fs::group_read);
+      fs::atomic_ofstream f(p);
+      BOOST_TEST((fs::status(f.temp_path()).permissions() & fs::perms_mask)
+        == (fs::owner_read | fs::owner_write | fs::group_read));
+      f << "second";
+      f.commit();
+      BOOST_TEST(contents(p) == "second");
+      BOOST_TEST((fs::status(p).permissions() & fs::perms_mask)
+        == (fs::owner_read | fs::owner_write | fs::group_read));
+    }
+#   endif
+    {
+      std::cout << " in atomic test 5\n";  // errors
+      fs::atomic_ofstream f(p / "no-such-dir");
+      BOOST_TEST(!f);
+      BOOST_TEST(!f.is_open());
+      BOOST_TEST(!!f.rdbuf()->error());
+
+      boost::system::error_code ec;
+      f.commit(fs::commit_options::none, ec);
+      BOOST_TEST(ec == boost::system::errc::bad_file_descriptor);
+      bool threw = false;
+      try { f.commit(); }
+      catch (const fs::filesystem_error&) { threw = true; }
+      BOOST_TEST(threw);
+    }
+
+    if (cleanup)
+      fs::remove(p);
+  } // atomic_test
+
+  void async_test(const fs::path & p)
+  {
+    fs::remove(p);
+    {
+      std::cout << " in async test 1\n";
+      fs::async_ofstream f(p);
+      BOOST_TEST(f.is_open());
+      BOOST_TEST_EQ(f.rdbuf()->buffer_size(), fs::async_filebuf::default_buffer_size);
+      BOOST_TEST_EQ(f.rdbuf()->buffer_count(), fs::async_filebuf::default_buffer_count);
+      f << "hello";
+      f.flush();  // waits for the write
+      BOOST_TEST(f);
+      BOOST_TEST_EQ(fs::file_size(p), 5U);
+      f << ", world";
+      f.close();
+      BOOST_TEST(f);
+      BOOST_TEST(!f.is_open());
+      BOOST_TEST(contents(p) == "hello, world");
+    }
+    {
+      std::cout << " in async test 2\n";  // more output than the buffers hold
+      fs::async_filebuf fb(16, 2);
+      BOOST_TEST(fb.open(p, std::ios_base::app) == &fb);
+      std::string expected("hello, world");
+      for (int i = 0; i != 1000; ++i)
+      {
+        std::string line(i % 50, static_cast<char>('a' + i % 26));
+        line += '\n';
+        BOOST_TEST_EQ(fb.sputn(line.data(), static_cast<std::streamsize>(line.size())),
+          static_cast<std::streamsize>(line.size()));
+        expected += line;
+      }
+      BOOST_TEST_EQ(fb.sputc('!'), '!');
+      expected += '!';
+      BOOST_TEST(fb.close() == &fb);
+      BOOST_TEST(contents(p) == expected);
+    }
+    {
+      std::cout << " in async test 3\n";  // errors
+      fs::async_filebuf fb;
+      BOOST_TEST(fb.open(p, std::ios_base::in | std::ios_base::out) == 0);
+      BOOST_TEST(fb.error() == boost::system::errc::invalid_argument);
+      BOOST_TEST(fb.open(p / "no-such-file") == 0);
+      BOOST_TEST(!!fb.error());
+      BOOST_TEST(fb.close() == 0);
+      BOOST_TEST_EQ(fb.sputc('x'), std::char_traits<char>::eof());
+
+#   ifdef __linux__
+      // a failed write is reported later, by a flush
+      fs::async_ofstream f("/dev/full");
+      BOOST_TEST(f.is_open());
+      f << "x";
+      f.flush();
+      BOOST_TEST(!f);
+      BOOST_TEST(f.rdbuf()->error() == boost::system::errc::no_space_on_device);
+      f.close();
+      BOOST_TEST(!f.is_open());
+#   endif
+    }
+
+    if (cleanup)
+      fs::remove(p);
+  } // async_test
 } // unnamed namespace
 
 int cpp_main(int argc, char*[])
@@ -148,6 +434,9 @@ int cpp_main(int argc, char*[])
   // test narrow characters
   std::cout << "narrow character tests:\n";
   test("narrow_fstream_test");
+  native_test("narrow_fstream_test");
+  atomic_test("narrow_fstream_test");
+  async_test("narrow_fstream_test");
 
 
   // So that tests are run with known encoding, use Boost UTF-8 codecvt
@@ -164,6 +453,9 @@ int cpp_main(int argc, char*[])
   ws += 0x2780;
   ws += 0x263A;
   test(ws);
+  native_test(ws);
+  atomic_test(ws);
+  async_test(ws);
 
   return ::boost::report_errors();
 }
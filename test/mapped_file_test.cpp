@@ -0,0 +1,227 @@
+//  mapped_file_test.cpp  --------------------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+#include <boost/config/warning_disable.hpp>
+
+//  See deprecated_test for tests of deprecated features
+#ifndef BOOST_FILESYSTEM_NO_DEPRECATED
+#  define BOOST_FILESYSTEM_NO_DEPRECATED
+#endif
+#ifndef BOOST_SYSTEM_NO_DEPRECATED
+#  define BOOST_SYSTEM_NO_DEPRECATED
+#endif
+
+#include <boost/filesystem/mapped_file.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/cstdint.hpp>
+
+#include <boost/config.hpp>
+# if defined( BOOST_NO_STD_WSTRING )
+#   error Configuration not supported: Boost.Filesystem V3 and later requires std::wstring support
+# endif
+
+#include <boost/detail/lightweight_test.hpp>
+
+#ifndef BOOST_LIGHTWEIGHT_MAIN
+#  include <boost/test/prg_exec_monitor.hpp>
+#else
+#  include <boost/detail/lightweight_main.hpp>
+#endif
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <cstring>
+
+namespace fs = boost::filesystem;
+using fs::path;
+using fs::mapped_file;
+using fs::map_mode;
+using fs::map_options;
+using fs::map_advice;
+using boost::system::error_code;
+
+namespace
+{
+  void create_file(const path& ph, const std::string& contents = std::string())
+  {
+    std::ofstream f(ph.string().c_str(), std::ios_base::out | std::ios_base::binary);
+    BOOST_TEST(f);
+    f << contents;
+  }
+
+  std::string read_file(const path& ph)
+  {
+    std::ifstream f(ph.string().c_str(), std::ios_base::in | std::ios_base::binary);
+    return std::string(std::istreambuf_iterator<char>(f),
+      std::istreambuf_iterator<char>());
+  }
+
+  //  read_only_tests  -----------------------------------------------------------------//
+
+  void read_only_tests(const path& dir)
+  {
+    std::cout << "read_only_tests..." << std::endl;
+
+    create_file(dir / "ro", "hello, world");
+    mapped_file m(dir / "ro");
+    BOOST_TEST(m.is_open());
+    BOOST_TEST(m.mode() == map_mode::read_only);
+    BOOST_TEST_EQ(m.size(), 12U);
+    BOOST_TEST(m.const_data() != 0);
+    BOOST_TEST(m.data() == 0);  // not writable
+    BOOST_TEST(std::string(m.const_data(), m.size()) == "hello, world");
+#   ifdef BOOST_POSIX_API
+    BOOST_TEST(m.native_handle() != -1);
+#   endif
+
+    m.advise(map_advice::sequential);
+    m.advise(map_advice::random, 5, 100);  // length is clipped to the mapping
+    error_code ec;
+    m.advise(map_advice::willneed, 13, 1, ec);
+    BOOST_TEST(ec == boost::system::errc::invalid_argument);
+
+    m.resize(100, ec);
+    BOOST_TEST(!!ec);
+    BOOST_TEST_EQ(m.size(), 12U);
+
+    m.close();
+    BOOST_TEST(!m.is_open());
+    BOOST_TEST_EQ(m.size(), 0U);
+    BOOST_TEST(m.const_data() == 0);
+
+    // an empty file is open, but not mapped
+    create_file(dir / "empty");
+    m.open(dir / "empty");
+    BOOST_TEST(m.is_open());
+    BOOST_TEST_EQ(m.size(), 0U);
+    BOOST_TEST(m.const_data() == 0);
+    m.advise(map_advice::willneed);
+  }
+
+  //  read_write_tests  ----------------------------------------------------------------//
+
+  void read_write_tests(const path& dir)
+  {
+    std::cout << "read_write_tests..." << std::endl;
+
+    create_file(dir / "rw", "abcdef");
+    {
+      mapped_file m(dir / "rw", map_mode::read_write);
+      BOOST_TEST(m.data() == m.const_data());
+      m.data()[0] = 'X';
+      m.flush();
+    }
+    BOOST_TEST(read_file(dir / "rw") == "Xbcdef");
+
+    // without create, the file must exist
+    error_code ec;
+    mapped_file m(dir / "new", map_mode::read_write, map_options::none, ec);
+    BOOST_TEST(!!ec);
+    BOOST_TEST(!m.is_open());
+
+    // growth from empty, then shrinking
+    m.open(dir / "new", map_mode::read_write, map_options::create);
+    BOOST_TEST(m.is_open());
+    BOOST_TEST_EQ(m.size(), 0U);
+    m.resize(10000);
+    BOOST_TEST_EQ(m.size(), 10000U);
+    BOOST_TEST_EQ(fs::file_size(dir / "new"), 10000U);
+    BOOST_TEST_EQ(m.data()[9999], 0);
+    std::memset(m.data(), 'a', m.size());
+    m.resize(20000);
+    BOOST_TEST_EQ(m.data()[9999], 'a');  // kept across the remap
+    BOOST_TEST_EQ(m.data()[10000], 0);
+    m.resize(3);
+    BOOST_TEST_EQ(m.size(), 3U);
+    m.flush();
+    m.close();
+    BOOST_TEST(read_file(dir / "new") == "aaa");
+
+    bool threw = false;
+    try { m.resize(1); }  // not open
+    catch (const fs::filesystem_error&) { threw = true; }
+    BOOST_TEST(threw);
+  }
+
+  //  option_tests  --------------------------------------------------------------------//
+
+  void option_tests(const path& dir)
+  {
+    std::cout << "option_tests..." << std::endl;
+
+    const std::size_t size = 4 * 1024 * 1024 + 123;
+    std::string contents(size, 'z');
+    contents[size - 1] = '!';
+    create_file(dir / "big", contents);
+
+    mapped_file m(dir / "big", map_mode::read_only,
+      map_options::populate | map_options::huge_pages);
+    BOOST_TEST_EQ(m.size(), size);
+    BOOST_TEST_EQ(m.const_data()[0], 'z');
+    BOOST_TEST_EQ(m.const_data()[size - 1], '!');
+#   ifdef __linux__
+    BOOST_TEST_EQ(reinterpret_cast<boost::uintptr_t>(m.const_data()) % (2 * 1024 * 1024),
+      0U);
+#   endif
+
+    // huge_pages on a writable map that is then grown
+    mapped_file w(dir / "big", map_mode::read_write, map_options::huge_pages);
+    w.resize(size + 1);
+    w.data()[size] = '?';
+    BOOST_TEST_EQ(w.data()[size - 1], '!');
+    w.close();
+    BOOST_TEST_EQ(fs::file_size(dir / "big"), size + 1);
+  }
+
+  //  error_tests  ---------------------------------------------------------------------//
+
+  void error_tests(const path& dir)
+  {
+    std::cout << "error_tests..." << std::endl;
+
+    error_code ec;
+    mapped_file m;
+    m.open(dir / "no-such-file", map_mode::read_only, map_options::none, ec);
+    BOOST_TEST(!!ec);
+    BOOST_TEST(!m.is_open());
+
+    bool threw = false;
+    try { mapped_file m2(dir / "no-such-file"); }
+    catch (const fs::filesystem_error&) { threw = true; }
+    BOOST_TEST(threw);
+
+    m.advise(map_advice::normal, ec);
+    BOOST_TEST(!!ec);
+    m.flush(ec);
+    BOOST_TEST(!!ec);
+  }
+
+}  // unnamed namespace
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//                                    main                                              //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+int cpp_main(int, char*[])
+{
+  path dir(fs::temp_directory_path() / fs::unique_path("mapped_file_test-%%%%-%%%%"));
+  fs::create_directory(dir);
+
+  read_only_tests(dir);
+  read_write_tests(dir);
+  option_tests(dir);
+  error_tests(dir);
+
+  fs::remove_all(dir);
+
+  return ::boost::report_errors();
+}
@@ -48,6 +48,7 @@ using std::endl;
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <iterator>
 #include <cstring> // for strncmp, etc.
 #include <ctime>
 #include <cstdlib> // for system(), getenv(), etc.
@@ -1547,6 +1548,29 @@ namespace
     create_file(d1 / "f5a", "12345");
     BOOST_TEST(fs::copy_file(d1 / "f5a", d1 / "f5", fs::copy_options::update_existing));
     BOOST_TEST_EQ(fs::file_size(d1 / "f5"), 5U);
+
+    // copy_options::uncached, with a size that is not a multiple of any block size and
+    // spans several drop-behind windows
+    {
+      std::string big(20 * 1024 * 1024 + 123, '\0');
+      for (std::size_t i = 0; i != big.size(); ++i)
+        big[i] = static_cast<char>(i * 7 + i / 4096);
+      std::ofstream f((d1 / "f6").BOOST_FILESYSTEM_C_STR,
+        std::ios_base::out | std::ios_base::binary);
+      f.write(big.data(), static_cast<std::streamsize>(big.size()));
+      f.close();
+      BOOST_TEST(fs::copy_file(d1 / "f6", d1 / "f7", fs::copy_options::uncached));
+      BOOST_TEST_EQ(fs::file_size(d1 / "f7"), big.size());
+      std::ifstream g((d1 / "f7").BOOST_FILESYSTEM_C_STR,
+        std::ios_base::in | std::ios_base::binary);
+      BOOST_TEST(std::string(std::istreambuf_iterator<char>(g),
+        std::istreambuf_iterator<char>()) == big);
+      g.close();
+      BOOST_TEST(!fs::copy_file(d1 / "f6", d1 / "f7",
+        fs::copy_options::uncached | fs::copy_options::skip_existing));
+      fs::remove(d1 / "f6");
+      fs::remove(d1 / "f7");
+    }
   }
 
  //  copy_tests  ------------------------------------------------------------------//
@@ -1730,6 +1754,28 @@ namespace
       << "  original last_write_time() - current last_write_time() is "
       << time_diff << " seconds" << endl;
     BOOST_TEST(time_diff >= -60.0 && time_diff <= 60.0);
+
+#   ifndef BOOST_FILESYSTEM_USE_TIME_T
+    // sub-second times are kept to the resolution of the file system
+    cout << "\n  Set a sub-second time" << endl;
+    fs::file_time_type fine = from_time_t(ft)
+      + boost::chrono::duration_cast<fs::file_time_type::duration>(
+          boost::chrono::microseconds(123457));
+    fs::last_write_time(f1, fine);
+    fs::file_time_type fine2 = fs::last_write_time(f1);
+    BOOST_TEST(fine2 <= fine);
+    BOOST_TEST(fine - fine2 < boost::chrono::seconds(1));
+    if (fine2 != from_time_t(ft))  // the file system stores more than seconds
+      BOOST_TEST(fine - fine2 < boost::chrono::milliseconds(1));
+
+    // times before 1970 too
+    fs::file_time_type early = from_time_t(0) - boost::chrono::milliseconds(500);
+    fs::last_write_time(f1, early);
+    fs::file_time_type early2 = fs::last_write_time(f1);
+    BOOST_TEST(early2 <= early);
+    BOOST_TEST(early - early2 < boost::chrono::seconds(1));
+    fs::last_write_time(f1, from_time_t(ft));
+#   endif
   }
 
   //  platform_specific_tests  ---------------------------------------------------------//
@@ -35,6 +35,7 @@
 #include <boost/foreach.hpp>
 #include <boost/system/error_code.hpp>
 #include <boost/detail/lightweight_test.hpp>
+#include <boost/move/utility.hpp>
 
 #ifndef BOOST_LIGHTWEIGHT_MAIN
 #  include <boost/test/prg_exec_monitor.hpp>
@@ -43,6 +44,12 @@
 #endif
 
 #include <iostream>
+#include <set>
+
+#ifdef BOOST_POSIX_API
+#  include <unistd.h>
+#  include <sys/wait.h>
+#endif
 
 using namespace boost::filesystem;
 using namespace boost::system;
@@ -323,6 +330,153 @@ namespace
     CHECK(!create_directory("/", ec));
   }
 
+  //  unique_path_test  ----------------------------------------------------------------//
+
+  void unique_path_test()
+  {
+    cout << "unique_path test..." << endl;
+
+    // names come from a per-thread buffer of random bytes; none may repeat
+    std::set<path> names;
+    for (int i = 0; i < 1000; ++i)
+      names.insert(unique_path("%%%%-%%%%-%%%%-%%%%-%%%%-%%%%-%%%%-%%%%"));
+    CHECK(names.size() == 1000);
+
+    error_code ec;
+    path p(unique_path("%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%", ec));  // > 16 bytes
+    CHECK(!ec);
+    CHECK(p.native().size() == 40);
+    CHECK(p.native().find('%') == string::npos);
+
+#   ifdef BOOST_POSIX_API
+    // a child process must not repeat the parent's buffered bytes
+    int fds[2];
+    CHECK(::pipe(fds) == 0);
+    pid_t pid = ::fork();
+    if (pid == 0)
+    {
+      string name(unique_path("%%%%%%%%%%%%%%%%").string());
+      ssize_t n = ::write(fds[1], name.c_str(), name.size());
+      ::_exit(n == static_cast<ssize_t>(name.size()) ? 0 : 1);
+    }
+    CHECK(pid > 0);
+    string parent_name(unique_path("%%%%%%%%%%%%%%%%").string());
+    char buf[17] = {};
+    CHECK(::read(fds[0], buf, 16) == 16);
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    ::close(fds[0]);
+    ::close(fds[1]);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    CHECK(parent_name != buf);
+#   endif
+  }
+
+  //  temp_file_test  ------------------------------------------------------------------//
+
+  void temp_file_test()
+  {
+    cout << "temp_file test..." << endl;
+
+    path dir(create_temp_directory(temp_directory_path(), "temp_file_test-%%%%-%%%%"));
+    CHECK(is_directory(dir));
+    CHECK(dir.parent_path() == temp_directory_path());
+
+    std::set<path> names;
+    for (int i = 0; i < 100; ++i)
+    {
+      temp_file f(create_temp_file(dir));
+      CHECK(f.is_open());
+      CHECK(f.file_path().parent_path() == dir);
+      CHECK(is_regular_file(f.file_path()));
+      names.insert(f.file_path());
+#     ifdef BOOST_POSIX_API
+      CHECK(::write(f.native_handle(), "x", 1) == 1);
+#     endif
+      f.close();
+      CHECK(!f.is_open());
+#     ifdef BOOST_POSIX_API
+      CHECK(file_size(f.file_path()) == 1);
+#     endif
+    }
+    CHECK(names.size() == 100);
+
+    // a model with no % collides on every attempt
+    error_code ec;
+    temp_file fixed(create_temp_file(dir, "fixed", ec));
+    CHECK(!ec);
+    fixed.close(ec);
+    CHECK(!ec);
+    create_temp_file(dir, "fixed", ec);
+    CHECK(!!ec);
+    CHECK(create_temp_directory(dir, "fixed", ec).empty());
+    CHECK(!!ec);
+    create_temp_file(dir / "no-such-dir", ec);
+    CHECK(!!ec);
+
+    bool threw = false;
+    try { create_temp_file(dir / "no-such-dir"); }
+    catch (const filesystem_error&) { threw = true; }
+    CHECK(threw);
+
+    path sub(create_temp_directory(dir, ec));
+    CHECK(!ec);
+    CHECK(is_directory(sub));
+
+    // a temp_file destroyed while open is abandoned, and one moved from owns nothing
+    path abandoned;
+    {
+      temp_file f(create_temp_file(dir));
+      temp_file g(boost::move(f));
+      CHECK(!f.is_open());
+      CHECK(f.file_path().empty());
+      CHECK(g.is_open());
+      abandoned = g.file_path();
+      CHECK(exists(abandoned));
+    }
+    CHECK(!exists(abandoned));
+    {
+      temp_file f(create_temp_file(dir));
+      abandoned = f.file_path();
+      f = create_temp_file(dir);
+      CHECK(!exists(abandoned));
+      CHECK(exists(f.file_path()));
+      path kept(f.file_path());
+      temp_file::native_handle_type h = f.release();
+      CHECK(!f.is_open());
+#     ifdef BOOST_POSIX_API
+      ::close(h);
+#     else
+      ::CloseHandle(h);
+#     endif
+      CHECK(exists(kept));
+    }
+
+    // an anonymous file is not visible until linked
+    std::size_t count = std::distance(directory_iterator(dir), directory_iterator());
+    temp_file anon(create_anonymous_temp_file(dir));
+    CHECK(anon.is_open());
+    CHECK(anon.file_path().empty());
+    CHECK(std::distance(directory_iterator(dir), directory_iterator())
+      == static_cast<std::ptrdiff_t>(count));
+#   ifdef BOOST_POSIX_API
+    CHECK(::write(anon.native_handle(), "abc", 3) == 3);
+    link_temp_file(anon, dir, "linked-%%%%", ec);
+    if (!ec)
+    {
+      CHECK(anon.file_path().parent_path() == dir);
+      CHECK(file_size(anon.file_path()) == 3);
+      link_temp_file(anon, dir, "linked-%%%%", ec);  // already named
+      CHECK(!!ec);
+    }
+    else
+      cout << "  link_temp_file() not supported: " << ec.message() << endl;
+#   endif
+    anon.close();
+
+    remove_all(dir);
+  }
+
 }  // unnamed namespace
 
 //--------------------------------------------------------------------------------------//
@@ -353,6 +507,8 @@ int cpp_main(int, char*[])
   directory_entry_test();
   directory_entry_overload_test();
   error_handling_test();
+  unique_path_test();
+  temp_file_test();
 
   cout << unique_path() << endl;
   cout << unique_path("foo-%%%%%-%%%%%-bar") << endl;
@@ -0,0 +1,195 @@
+//  path_pool_test.cpp  ----------------------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+#include <boost/config/warning_disable.hpp>
+
+//  See deprecated_test for tests of deprecated features
+#ifndef BOOST_FILESYSTEM_NO_DEPRECATED 
+#  define BOOST_FILESYSTEM_NO_DEPRECATED
+#endif
+#ifndef BOOST_SYSTEM_NO_DEPRECATED 
+#  define BOOST_SYSTEM_NO_DEPRECATED
+#endif
+
+#include <boost/filesystem/path_pool.hpp>
+
+#include <boost/config.hpp>
+# if defined( BOOST_NO_STD_WSTRING )
+#   error Configuration not supported: Boost.Filesystem V3 and later requires std::wstring support
+# endif
+
+#include <boost/detail/lightweight_test.hpp>
+
+#ifndef BOOST_LIGHTWEIGHT_MAIN
+#  include <boost/test/prg_exec_monitor.hpp>
+#else
+#  include <boost/detail/lightweight_main.hpp>
+#endif
+
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <vector>
+
+namespace fs = boost::filesystem;
+using fs::path;
+using fs::path_pool;
+
+namespace
+{
+  typedef path_pool::handle handle;
+
+  void round_trip(path_pool& pool, const path& p)
+  {
+    handle h(pool.intern(p));
+    BOOST_TEST(pool.to_path(h) == p);
+    BOOST_TEST(pool.intern(p) == h);
+    BOOST_TEST(pool.intern(pool.to_path(h)) == h);
+  }
+
+  //  interning_tests  -----------------------------------------------------------------//
+
+  void interning_tests()
+  {
+    std::cout << "interning_tests..." << std::endl;
+
+    path_pool pool;
+    BOOST_TEST_EQ(pool.size(), 0U);
+    BOOST_TEST(pool.intern(path()).empty());
+    BOOST_TEST(pool.to_path(handle()).empty());
+
+    round_trip(pool, "a");
+    round_trip(pool, "/");
+    round_trip(pool, "/a/b/c");
+    round_trip(pool, "a/b/c");
+    round_trip(pool, "a/b/");
+    round_trip(pool, "../x/./y");
+    round_trip(pool, "//net");
+    round_trip(pool, "//net/share/file.txt");
+# ifdef BOOST_WINDOWS_API
+    round_trip(pool, "c:");
+    round_trip(pool, "c:foo");
+    round_trip(pool, "c:/foo/bar");
+    round_trip(pool, "c:\\foo\\bar");
+# endif
+
+    BOOST_TEST(pool.to_path(pool.intern("a//b")).native() == path("a/b").make_preferred().native());
+
+    handle abc(pool.intern("/a/b/c"));
+    BOOST_TEST(abc != pool.intern("/a/b/d"));
+    BOOST_TEST(abc != pool.intern("a/b/c"));
+    BOOST_TEST(pool.intern("/a/b//c") == abc);
+
+    // shared prefixes share nodes; repeated names share storage
+    path_pool p2;
+    p2.intern("/usr/include/boost/filesystem/path.hpp");
+    std::size_t nodes = p2.size();
+    std::size_t names = p2.name_count();
+    BOOST_TEST_EQ(nodes, 6U);
+    p2.intern("/usr/include/boost/filesystem/operations.hpp");
+    BOOST_TEST_EQ(p2.size(), nodes + 1);
+    BOOST_TEST_EQ(p2.name_count(), names + 1);
+    p2.intern("/usr/local/include/boost");
+    BOOST_TEST_EQ(p2.size(), nodes + 4);
+    BOOST_TEST_EQ(p2.name_count(), names + 2);
+
+    // parent, filename, and relative interning
+    handle d(pool.intern("/a/b"));
+    BOOST_TEST(pool.parent(abc) == d);
+    BOOST_TEST(pool.filename(abc) == "c");
+    BOOST_TEST(pool.intern(d, "c") == abc);
+    BOOST_TEST(pool.intern(pool.intern("/a"), "b/c") == abc);
+    BOOST_TEST(pool.parent(pool.intern("a")).empty());
+
+    // many paths, to exercise table growth
+    std::vector<handle> hs;
+    for (int i = 0; i < 5000; ++i)
+    {
+      path p("root");
+      p /= path("dir") += static_cast<char>('0' + i % 10);
+      p /= path("file") += static_cast<char>('a' + i % 26);
+      p += static_cast<char>('a' + (i / 26) % 26);
+      p += static_cast<char>('a' + (i / 676) % 26);
+      hs.push_back(pool.intern(p));
+      BOOST_TEST(pool.to_path(hs.back()) == p);
+    }
+    for (int i = 0; i < 5000; i += 97)
+      BOOST_TEST(pool.intern(pool.to_path(hs[i])) == hs[i]);
+
+    path_pool empty;
+    empty.swap(pool);
+    BOOST_TEST_EQ(pool.size(), 0U);
+    BOOST_TEST(empty.to_path(abc) == "/a/b/c");
+    empty.clear();
+    BOOST_TEST_EQ(empty.size(), 0U);
+    BOOST_TEST_EQ(empty.name_count(), 0U);
+  }
+
+  //  directory_tests  -----------------------------------------------------------------//
+
+  void directory_tests(const path& dir)
+  {
+    std::cout << "directory_tests..." << std::endl;
+
+    fs::create_directories(dir / "d1/d2");
+    std::ofstream((dir / "f1").string().c_str());
+    std::ofstream((dir / "d1/f2").string().c_str());
+    std::ofstream((dir / "d1/d2/f3").string().c_str());
+
+    path_pool pool;
+    std::vector<handle> entries;
+    handle dh(pool.intern_directory(dir, entries));
+    BOOST_TEST(dh == pool.intern(dir));
+    BOOST_TEST_EQ(entries.size(), 2U);
+    BOOST_TEST(std::find(entries.begin(), entries.end(), pool.intern(dir / "f1"))
+      != entries.end());
+    BOOST_TEST(std::find(entries.begin(), entries.end(), pool.intern(dir / "d1"))
+      != entries.end());
+
+    entries.clear();
+    boost::system::error_code ec;
+    pool.intern_tree(dir, entries, ec);
+    BOOST_TEST(!ec);
+    BOOST_TEST_EQ(entries.size(), 5U);
+    const char* expected[] = { "f1", "d1", "d1/f2", "d1/d2", "d1/d2/f3" };
+    for (int i = 0; i < 5; ++i)
+      BOOST_TEST(std::find(entries.begin(), entries.end(),
+        pool.intern(dir / expected[i])) != entries.end());
+    for (std::size_t i = 0; i < entries.size(); ++i)
+      BOOST_TEST(fs::exists(pool.to_path(entries[i])));
+
+    // the directory_iterator form
+    handle d1(pool.intern(dir / "d1"));
+    for (fs::directory_iterator itr(dir / "d1"); itr != fs::directory_iterator(); ++itr)
+      BOOST_TEST(pool.intern(d1, *itr) == pool.intern(itr->path()));
+
+    entries.clear();
+    pool.intern_directory(dir / "no-such-directory", entries, ec);
+    BOOST_TEST(ec);
+    BOOST_TEST(entries.empty());
+  }
+
+}  // unnamed namespace
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//                                    main                                              //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+int cpp_main(int, char*[])
+{
+  interning_tests();
+
+  path dir(fs::temp_directory_path() / fs::unique_path("path_pool_test-%%%%-%%%%"));
+  directory_tests(dir);
+  fs::remove_all(dir);
+
+  return ::boost::report_errors();
+}
@@ -1816,6 +1816,77 @@ namespace
     }
   }
 
+  //  lexical_tests  -------------------------------------------------------------------//
+
+  std::string normal(const char* p) { return path(p).lexically_normal().generic_string(); }
+  std::string relative(const char* p, const char* base)
+    { return path(p).lexically_relative(base).generic_string(); }
+
+  void lexical_tests()
+  {
+    std::cout << "lexical_tests..." << std::endl;
+
+    PATH_TEST_EQ(normal(""), "");
+    PATH_TEST_EQ(normal("."), ".");
+    PATH_TEST_EQ(normal("./"), ".");
+    PATH_TEST_EQ(normal(".."), "..");
+    PATH_TEST_EQ(normal("/"), "/");
+    PATH_TEST_EQ(normal("//"), "//");
+    PATH_TEST_EQ(normal("foo"), "foo");
+    PATH_TEST_EQ(normal("foo/"), "foo/");
+    PATH_TEST_EQ(normal("foo/."), "foo/");
+    PATH_TEST_EQ(normal("foo//bar///baz"), "foo/bar/baz");
+    PATH_TEST_EQ(normal("./foo/./bar/."), "foo/bar/");
+    PATH_TEST_EQ(normal("foo/.."), ".");
+    PATH_TEST_EQ(normal("foo/../"), ".");
+    PATH_TEST_EQ(normal("foo/bar/.."), "foo/");
+    PATH_TEST_EQ(normal("foo/./bar/.."), "foo/");
+    PATH_TEST_EQ(normal("foo/../../bar"), "../bar");
+    PATH_TEST_EQ(normal("../../foo"), "../../foo");
+    PATH_TEST_EQ(normal("foo/../.."), "..");
+    PATH_TEST_EQ(normal("foo/../../"), "..");
+    PATH_TEST_EQ(normal("../a/.."), "..");
+    PATH_TEST_EQ(normal("../a/../"), "..");
+    PATH_TEST_EQ(normal("../../a/b/../.."), "../..");
+    PATH_TEST_EQ(normal("../a/./"), "../a/");
+    PATH_TEST_EQ(normal("/.."), "/");
+    PATH_TEST_EQ(normal("/../foo"), "/foo");
+    PATH_TEST_EQ(normal("/foo/../.."), "/");
+    PATH_TEST_EQ(normal("///foo/bar"), "/foo/bar");
+    PATH_TEST_EQ(normal("//net/foo/../bar"), "//net/bar");
+    PATH_TEST_EQ(normal("..foo/bar.."), "..foo/bar..");
+    PATH_TEST_EQ(normal("a/b/c/../../d/./e/"), "a/d/e/");
+
+    PATH_TEST_EQ(relative("/a/d", "/a/b/c"), "../../d");
+    PATH_TEST_EQ(relative("/a/b/c", "/a/d"), "../b/c");
+    PATH_TEST_EQ(relative("a/b/c", "a"), "b/c");
+    PATH_TEST_EQ(relative("a/b/c", "a/b/c/x/y"), "../..");
+    PATH_TEST_EQ(relative("a/b/c", "a/b/c"), ".");
+    PATH_TEST_EQ(relative("a/b", "c/d"), "../../a/b");
+    PATH_TEST_EQ(relative("a/b", "a/./b/.."), "b");
+    PATH_TEST_EQ(relative("a/b", "a/b/."), ".");
+    PATH_TEST_EQ(relative("a", "a/b/../.."), "");
+    PATH_TEST_EQ(relative("a/b/", "a"), "b/");
+    PATH_TEST_EQ(relative("/a", "b"), "");
+    PATH_TEST_EQ(relative("a", "/b"), "");
+    PATH_TEST_EQ(relative("//net/a", "//other/a"), "");
+    PATH_TEST_EQ(relative("/", "/a"), "..");
+    PATH_TEST_EQ(relative("", "a"), "..");
+    PATH_TEST_EQ(relative("/", "/"), ".");
+
+    PATH_TEST_EQ(path("a").lexically_proximate("/b").generic_string(), "a");
+    PATH_TEST_EQ(path("/a/b").lexically_proximate("/a").generic_string(), "b");
+
+    if (platform == "Windows")
+    {
+      PATH_TEST_EQ(path("c:\\foo\\..\\bar").lexically_normal(), "c:\\bar");
+      PATH_TEST_EQ(path("c:/foo/../bar").lexically_normal(), "c:\\bar");
+      PATH_TEST_EQ(path("c:foo/..").lexically_normal(), "c:");
+      PATH_TEST_EQ(path("c:/a/b").lexically_relative("c:/a"), "b");
+      PATH_TEST_EQ(path("c:/a/b").lexically_relative("d:/a"), "");
+    }
+  }
+
 } // unnamed namespace
 
 static boost::filesystem::path ticket_6737 = "FilePath";  // #6737 reported this crashed
@@ -1860,6 +1931,7 @@ int cpp_main(int, char*[])
   replace_filename_tests();
   replace_extension_tests();
   make_preferred_tests();
+  lexical_tests();
 
   // verify deprecated names still available
 
@@ -52,6 +52,10 @@
 #include <cwchar>
 #include <locale>
 #include <list>
+#ifndef BOOST_NO_CXX11_HDR_THREAD
+#  include <thread>
+#  include <vector>
+#endif
 
 namespace fs = boost::filesystem;
 namespace bs = boost::system;
@@ -410,6 +414,23 @@ namespace
     x = "/foo";
     x /= ws.c_str();                                    // const wchar_t* null terminated
     PATH_IS(x, BOOST_FS_FOO L"wstring");
+
+    // join() must agree with operator/ applied left to right
+    x = "/foo";
+    BOOST_TEST(fs::join(x, "bar") == x / "bar");
+    BOOST_TEST(fs::join(x, "bar", "baz") == x / "bar" / "baz");
+    BOOST_TEST(fs::join(x, "", "/bar", "baz/") == x / "" / "/bar" / "baz/");
+    BOOST_TEST(fs::join("a", "b", "c", "d", "e") == path("a") / "b" / "c" / "d" / "e");
+    BOOST_TEST(fs::join(path(), "a", path()) == path("a"));
+    BOOST_TEST(fs::join(x, x) == x / x);
+    BOOST_TEST(fs::join(path("/"), "bar") == path("/bar"));
+#   if !defined(BOOST_NO_CXX11_VARIADIC_TEMPLATES)
+    BOOST_TEST(fs::join("a", "b", "c", "d", "e", string("f"), L"g")
+      == path("a") / "b" / "c" / "d" / "e" / "f" / "g");
+#   endif
+#   ifdef BOOST_WINDOWS_API
+    BOOST_TEST(fs::join("c:", "foo", "bar") == path("c:foo\\bar"));
+#   endif
    }
 
   //  test_concats  --------------------------------------------------------------------//
@@ -605,6 +626,61 @@ namespace
     CHECK(p2 >= p);
 }
 
+  //  test_hash  -----------------------------------------------------------------------//
+
+  void test_hash()
+  {
+    std::cout << "testing hash..." << std::endl;
+
+    fs::path_hash hasher;
+    fs::path_equal_to eq;
+
+    // lengths on either side of the word and four-lane block boundaries
+    path::string_type s;
+    std::size_t prior_hash = hash_value(path(s));
+    for (int i = 1; i < 80; ++i)
+    {
+      s += static_cast<path::value_type>('a' + i % 26);
+      path p(s);
+      std::size_t h = hash_value(p);
+      CHECK(h != prior_hash);
+      CHECK(hasher(p) == h);
+      CHECK(hasher(s) == h);
+      CHECK(hasher(s.c_str()) == h);
+      CHECK(hasher(boost::basic_string_ref<path::value_type>(s)) == h);
+      CHECK(hasher(fs::hashed_path(p)) == h);
+      CHECK(fs::hashed_path(p).hash() == h);
+      CHECK(eq(p, s));
+      CHECK(eq(s.c_str(), fs::hashed_path(p)));
+      prior_hash = h;
+    }
+
+    path p("foo/bar");
+    CHECK(hasher(p) == hasher(p.native()));
+    CHECK(eq(p, p.native()));
+    CHECK(!eq(p, path("foo/baz")));
+    CHECK(!eq(p, path("foo/bar/")));
+    CHECK(hash_value(path("foo/bar")) != hash_value(path("foo/baz")));
+
+    fs::hashed_path hp(p);
+    CHECK(hp.path() == p);
+    CHECK(hp == fs::hashed_path(path("foo/bar")));
+    CHECK(hp != fs::hashed_path(path("foo/baz")));
+    CHECK(hash_value(hp) == hash_value(p));
+    fs::hashed_path hp2;
+    CHECK(hp2.path().empty());
+    CHECK(hp2.hash() == hash_value(path()));
+    swap(hp, hp2);
+    CHECK(hp2.path() == p);
+    CHECK(hp.path().empty());
+
+# ifdef BOOST_WINDOWS_API
+    CHECK(hasher(L"c:\\abc\\def") == hasher(path("c:/abc/def")));
+    CHECK(eq(L"c:\\abc\\def", path("c:/abc/def")));
+    CHECK(fs::hashed_path(path("c:\\abc")) == fs::hashed_path(path("c:/abc")));
+# endif
+  }
+
   //  test_inserter_and_extractor  -----------------------------------------------------//
 
   void test_inserter_and_extractor()
@@ -759,6 +835,24 @@ namespace
     CHECK(path("foo.bar.baz.tar.bz2").extension().string() == ".bz2");
     CHECK(path("/foo/bar/baz.zoo").extension().string() == ".zoo");
     CHECK(path("/foo/bar.woo/baz").extension().string() == "");
+
+    // long paths, with the last separator and dot at every position relative to
+    // the block boundaries of the vectorized scans
+    for (std::size_t sep = 2; sep < 70; ++sep)
+    {
+      for (std::size_t dot = sep + 1; dot < 72; dot += 7)
+      {
+        string s(72, 'x');
+        s[0] = '/';
+        s[sep] = '/';
+        s[dot] = '.';
+        path p(s);
+        CHECK(p.filename().string() == s.substr(sep + 1));
+        CHECK(p.parent_path().string() == s.substr(0, sep));
+        CHECK(p.extension().string() == s.substr(dot));
+        CHECK(p.stem().string() == s.substr(sep + 1, dot - sep - 1));
+      }
+    }
   }
 
   //  test_queries  --------------------------------------------------------------------//
@@ -796,6 +890,29 @@ namespace
 
   }
 
+  //  test_first_imbue  ----------------------------------------------------------------//
+
+  void test_first_imbue()
+  {
+    std::cout << "testing imbue before first use..." << std::endl;
+
+    //  the default locale is returned even though no conversion has created it yet
+    std::locale utf8_loc(std::locale(), new fs::detail::utf8_codecvt_facet);
+    std::locale first = path::imbue(utf8_loc);
+#   if defined(BOOST_POSIX_API) \
+      && !(defined(macintosh) || defined(__APPLE__) || defined(__APPLE_CC__))
+    try { CHECK(first == std::locale("")); }
+    catch (const std::runtime_error&) {}
+#   endif
+
+    //  imbuing a locale equal to one imbued before reuses it
+    CHECK(path::imbue(first) == utf8_loc);
+    const path::codecvt_type* cvt = &path::codecvt();
+    path::imbue(utf8_loc);
+    path::imbue(first);
+    CHECK(&path::codecvt() == cvt);
+  }
+
   //  test_imbue_locale  ---------------------------------------------------------------//
 
   void test_imbue_locale()
@@ -819,6 +936,61 @@ namespace
     CHECK(p2.wstring().size() == 1);
     CHECK(p2.wstring()[0] == 0x2722);
 
+    //  long enough for the UTF-8 fast path to take its vector ASCII loops, with one,
+    //  two, three and four byte sequences at block boundaries
+    std::string long_utf8("abcdefghijklmnopqrstuvwxyz/\xC3\xA9" "abcdefghijklmno\xE2\x9C\xA2"
+      "/0123456789abcde\xF0\x9F\x98\x80xyz/0123456789abcdef0123456789abcdef");
+    std::wstring long_wide(L"abcdefghijklmnopqrstuvwxyz/\u00E9abcdefghijklmno\u2722/"
+      L"0123456789abcde");
+    if (sizeof(wchar_t) == 2)
+      long_wide += L"\xD83D\xDE00";
+    else
+      long_wide += static_cast<wchar_t>(0x1F600);
+    long_wide += L"xyz/0123456789abcdef0123456789abcdef";
+    CHECK(path(long_utf8).wstring() == long_wide);
+    CHECK(path(long_wide).string() == long_utf8);
+    CHECK(path(long_utf8).generic_wstring() == long_wide);
+
+    //  ill-formed input is left to the facet, so results match calling it directly
+    const char bad[] = "abcdefghijklmnopqrstuvwxyz\xC0\xAF\xED\xA0\x80\xFF";
+    std::wstring direct(32, L'\0');
+    std::mbstate_t state = std::mbstate_t();
+    const char* from_next;
+    wchar_t* to_next;
+    bool facet_ok = path::codecvt().in(state, bad, bad + sizeof(bad) - 1, from_next,
+      &direct[0], &direct[0] + direct.size(), to_next) == std::codecvt_base::ok;
+    bool path_ok = true;
+    std::wstring via_path;
+    try { via_path = path(bad).wstring(); }
+    catch (const boost::system::system_error&) { path_ok = false; }
+    CHECK(path_ok == facet_ok);
+    if (facet_ok)
+      CHECK(via_path == std::wstring(&direct[0], to_next));
+
+    //  a UTF-8 named locale, if the system has one, takes the same fast path
+    try
+    {
+      std::locale utf8_loc("C.UTF-8");
+
+      //  through the facet itself, each wchar_t below is three bytes, more than the
+      //  first guess at the output size, so the output space must grow
+      const path::codecvt_type& utf8_cvt(std::use_facet<path::codecvt_type>(utf8_loc));
+      std::wstring cjk(1000, static_cast<wchar_t>(0x4E2D));
+      std::string cjk_utf8;
+      for (int i = 0; i < 1000; ++i)
+        cjk_utf8 += "\xE4\xB8\xAD";
+      CHECK(path(cjk, utf8_cvt).native() == cjk_utf8);
+      CHECK(path(cjk_utf8).wstring(utf8_cvt) == cjk);
+
+      path::imbue(utf8_loc);
+      CHECK(path(long_utf8).wstring() == long_wide);
+      CHECK(path(long_wide).string() == long_utf8);
+    }
+    catch (const std::runtime_error&)
+    {
+      std::cout << "  C.UTF-8 locale not available" << std::endl;
+    }
+
     std::cout << "  imbuing the original locale ..." << std::endl;
     path::imbue(old_loc);
 
@@ -829,6 +1001,66 @@ namespace
     std::cout << "  locale testing complete" << std::endl;
   }
 
+  //  test_thread_locale  --------------------------------------------------------------//
+
+#ifndef BOOST_NO_CXX11_HDR_THREAD
+  void convert_many(std::wstring expected, int* failures)
+  {
+    for (int i = 0; i < 2000; ++i)
+    {
+      if (path("abc/def").wstring() != expected)
+        ++*failures;
+    }
+  }
+
+  void imbue_thread_convert(int* failures)
+  {
+    path::imbue_thread(std::locale(std::locale(), new test_codecvt));
+    for (int i = 0; i < 2000; ++i)
+    {
+      if (path("abc").wstring() != L"bcd")  // test_codecvt adds 1
+        ++*failures;
+    }
+    path::reset_thread_locale();
+  }
+#endif
+
+  void test_thread_locale()
+  {
+    std::cout << "testing thread locale..." << std::endl;
+
+    std::locale utf8_loc(std::locale(), new fs::detail::utf8_codecvt_facet);
+    std::locale old_loc = path::imbue(utf8_loc);
+
+    //  the override applies to this thread only, until reset
+    path::imbue_thread(std::locale(std::locale(), new test_codecvt));
+    CHECK(path("abc").wstring() == L"bcd");
+    CHECK(path(L"bcd").native() == path::string_type(path("abc").native()));
+    path::reset_thread_locale();
+    CHECK(path("abc").wstring() == L"abc");
+    CHECK(path("\xE2\x9C\xA2").wstring() == std::wstring(1, 0x2722));
+
+#ifndef BOOST_NO_CXX11_HDR_THREAD
+    //  conversions in other threads are not disturbed by imbue(), or by another
+    //  thread's override
+    const int n = 4;
+    std::vector<int> failures(n + 1, 0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < n; ++i)
+      threads.push_back(std::thread(convert_many, std::wstring(L"abc/def"), &failures[i]));
+    threads.push_back(std::thread(imbue_thread_convert, &failures[n]));
+    for (int i = 0; i < 200; ++i)
+      path::imbue(utf8_loc);  // same conversions for ASCII, so results do not change
+    for (std::size_t i = 0; i < threads.size(); ++i)
+      threads[i].join();
+    for (int i = 0; i <= n; ++i)
+      CHECK(failures[i] == 0);
+#endif
+
+    path::imbue(old_loc);
+    std::cout << "  thread locale testing complete" << std::endl;
+  }
+
   //  test_codecvt_argument  -----------------------------------------------------------//
 
   void test_codecvt_argument()
@@ -1182,6 +1414,7 @@ int cpp_main(int, char*[])
   wv.push_back(L'u');
   wv.push_back(L'z');
 
+  test_first_imbue();  // before any conversion creates the default locale
   test_overloads();
   test_constructors();
   test_assignments();
@@ -1190,12 +1423,14 @@ int cpp_main(int, char*[])
   test_modifiers();
   test_observers();
   test_relationals();
+  test_hash();
   test_inserter_and_extractor();
   test_other_non_members();
   test_iterators();
   test_decompositions();
   test_queries();
   test_imbue_locale();
+  test_thread_locale();
   test_codecvt_argument();
   test_error_handling();
 
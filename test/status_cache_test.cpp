@@ -0,0 +1,240 @@
+//  status_cache_test.cpp  -------------------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+#include <boost/config/warning_disable.hpp>
+
+//  See deprecated_test for tests of deprecated features
+#ifndef BOOST_FILESYSTEM_NO_DEPRECATED
+#  define BOOST_FILESYSTEM_NO_DEPRECATED
+#endif
+#ifndef BOOST_SYSTEM_NO_DEPRECATED
+#  define BOOST_SYSTEM_NO_DEPRECATED
+#endif
+
+#include <boost/filesystem/status_cache.hpp>
+
+#include <boost/config.hpp>
+# if defined( BOOST_NO_STD_WSTRING )
+#   error Configuration not supported: Boost.Filesystem V3 and later requires std::wstring support
+# endif
+
+#include <boost/detail/lightweight_test.hpp>
+
+#ifndef BOOST_LIGHTWEIGHT_MAIN
+#  include <boost/test/prg_exec_monitor.hpp>
+#else
+#  include <boost/detail/lightweight_main.hpp>
+#endif
+
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace fs = boost::filesystem;
+using fs::path;
+using fs::status_cache;
+using boost::system::error_code;
+
+namespace
+{
+  void create_file(const path& ph, const std::string& contents = std::string())
+  {
+    std::ofstream f(ph.string().c_str());
+    BOOST_TEST(f);
+    f << contents;
+  }
+
+  const status_cache::clock::duration forever(status_cache::clock::duration::max());
+
+  //  query_tests: results must match the uncached queries  ---------------------------//
+
+  void query_tests(const path& dir)
+  {
+    std::cout << "query_tests..." << std::endl;
+
+    status_cache cache(forever);
+    path file(dir / "file");
+    BOOST_TEST(fs::status(file, cache) == fs::status(file));
+    BOOST_TEST(fs::is_regular_file(file, cache));
+    BOOST_TEST(fs::exists(file, cache));
+    BOOST_TEST(!fs::is_directory(file, cache));
+    BOOST_TEST_EQ(fs::file_size(file, cache), fs::file_size(file));
+    BOOST_TEST(fs::last_write_time(file, cache) == fs::last_write_time(file));
+    BOOST_TEST(fs::is_directory(dir, cache));
+
+    // one system call per path
+    BOOST_TEST_EQ(cache.misses(), 2U);
+    BOOST_TEST_EQ(cache.hits(), 5U);
+    BOOST_TEST_EQ(cache.size(), 2U);
+
+    error_code ec;
+    BOOST_TEST_EQ(fs::file_size(dir, cache, ec), static_cast<boost::uintmax_t>(-1));
+    BOOST_TEST(!!ec);
+    BOOST_TEST_EQ(fs::file_size(file, cache, ec), 5U);
+    BOOST_TEST(!ec);
+
+    bool threw = false;
+    try { fs::file_size(dir, cache); }
+    catch (const fs::filesystem_error&) { threw = true; }
+    BOOST_TEST(threw);
+  }
+
+  //  not_found_tests: negative caching  ----------------------------------------------//
+
+  void not_found_tests(const path& dir)
+  {
+    std::cout << "not_found_tests..." << std::endl;
+
+    status_cache cache(forever);
+    path missing(dir / "missing");
+    error_code ec;
+    BOOST_TEST(fs::status(missing, cache, ec).type() == fs::file_type::not_found);
+    BOOST_TEST(!!ec);
+    BOOST_TEST(!fs::exists(missing, cache));
+    BOOST_TEST_EQ(cache.misses(), 1U);
+
+    // the error is reported again from the cache
+    error_code ec2;
+    BOOST_TEST(!fs::exists(missing, cache, ec2));
+    BOOST_TEST(ec2 == ec);
+    BOOST_TEST_EQ(cache.misses(), 1U);
+
+    bool threw = false;
+    try { fs::file_size(missing, cache); }
+    catch (const fs::filesystem_error&) { threw = true; }
+    BOOST_TEST(threw);
+    fs::last_write_time(missing, cache, ec);
+    BOOST_TEST(!!ec);
+
+    // the cache is stale until invalidated
+    create_file(missing);
+    BOOST_TEST(!fs::exists(missing, cache));
+    cache.invalidate(missing);
+    BOOST_TEST(fs::exists(missing, cache));
+    fs::remove(missing);
+  }
+
+  //  invalidation_tests  --------------------------------------------------------------//
+
+  void invalidation_tests(const path& dir)
+  {
+    std::cout << "invalidation_tests..." << std::endl;
+
+    status_cache cache(forever);
+    fs::create_directory(dir / "sub");
+    create_file(dir / "sub" / "a");
+    create_file(dir / "subsidiary");
+    BOOST_TEST(fs::exists(dir / "sub" / "a", cache));
+    BOOST_TEST(fs::exists(dir / "sub", cache));
+    BOOST_TEST(fs::exists(dir / "subsidiary", cache));
+    BOOST_TEST_EQ(cache.size(), 3U);
+
+    // a prefix invalidates what is below it, but not a sibling sharing its characters
+    cache.invalidate(dir / "sub");
+    BOOST_TEST_EQ(cache.size(), 1U);
+    BOOST_TEST(fs::exists(dir / "subsidiary", cache));
+    BOOST_TEST_EQ(cache.misses(), 3U);
+
+    cache.clear();
+    BOOST_TEST_EQ(cache.size(), 0U);
+    fs::remove_all(dir / "sub");
+    fs::remove(dir / "subsidiary");
+  }
+
+  //  bound_tests: max_entries and ttl  ------------------------------------------------//
+
+  void bound_tests(const path& dir)
+  {
+    std::cout << "bound_tests..." << std::endl;
+
+    status_cache small(forever, 4, 1);
+    for (int i = 0; i < 10; ++i)
+      fs::exists(dir / ("f" + std::string(1, char('0' + i))), small);
+    BOOST_TEST(small.size() <= 4);
+    BOOST_TEST_EQ(small.max_entries(), 4U);
+
+    status_cache sharded(forever, 64, 8);
+    for (int i = 0; i < 200; ++i)
+      fs::exists(dir / ("g" + std::string(1, char('0' + i % 10)) + char('a' + i / 10)),
+        sharded);
+    BOOST_TEST(sharded.size() <= 64);
+
+    // zero ttl: every lookup misses
+    status_cache no_ttl(status_cache::clock::duration::zero());
+    fs::exists(dir, no_ttl);
+    fs::exists(dir, no_ttl);
+    BOOST_TEST_EQ(no_ttl.misses(), 2U);
+    BOOST_TEST(no_ttl.ttl() == status_cache::clock::duration::zero());
+  }
+
+  //  thread_tests  --------------------------------------------------------------------//
+
+  void query_many(status_cache* cache, const std::vector<path>* paths, int* failures)
+  {
+    for (int i = 0; i < 2000; ++i)
+    {
+      const path& p((*paths)[i % paths->size()]);
+      bool is_file(p.filename() == "file");
+      if (fs::is_regular_file(p, *cache) != is_file)
+        ++*failures;
+      if (i % 97 == 0)
+        cache->invalidate(p.parent_path());
+    }
+  }
+
+  void thread_tests(const path& dir)
+  {
+    std::cout << "thread_tests..." << std::endl;
+
+    std::vector<path> paths;
+    paths.push_back(dir / "file");
+    paths.push_back(dir);
+    paths.push_back(dir / "missing");
+    for (int i = 0; i < 20; ++i)
+      paths.push_back(dir / ("p" + std::string(1, char('a' + i))));
+
+    status_cache cache(forever, 16, 4);
+    const int n = 8;
+    std::vector<int> failures(n, 0);
+    boost::thread_group threads;
+    for (int i = 0; i < n; ++i)
+      threads.create_thread(boost::bind(query_many, &cache, &paths, &failures[i]));
+    threads.join_all();
+    for (int i = 0; i < n; ++i)
+      BOOST_TEST_EQ(failures[i], 0);
+    BOOST_TEST(cache.size() <= 16);
+    BOOST_TEST_EQ(cache.hits() + cache.misses(), n * 2000U);
+  }
+
+}  // unnamed namespace
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//                                    main                                              //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+int cpp_main(int, char*[])
+{
+  path dir(fs::temp_directory_path() / fs::unique_path("status_cache_test-%%%%-%%%%"));
+  fs::create_directory(dir);
+  create_file(dir / "file", "12345");
+
+  query_tests(dir);
+  not_found_tests(dir);
+  invalidation_tests(dir);
+  bound_tests(dir);
+  thread_tests(dir);
+
+  fs::remove_all(dir);
+
+  return ::boost::report_errors();
+}
@@ -0,0 +1,189 @@
+//  tree_snapshot_test.cpp  ------------------------------------------------------------//
+
+//  Copyright Beman Dawes 2012
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Library home page: http://www.boost.org/libs/filesystem
+
+#include <boost/config/warning_disable.hpp>
+
+//  See deprecated_test for tests of deprecated features
+#ifndef BOOST_FILESYSTEM_NO_DEPRECATED
+#  define BOOST_FILESYSTEM_NO_DEPRECATED
+#endif
+#ifndef BOOST_SYSTEM_NO_DEPRECATED
+#  define BOOST_SYSTEM_NO_DEPRECATED
+#endif
+
+#include <boost/filesystem/tree_snapshot.hpp>
+
+#include <boost/config.hpp>
+# if defined( BOOST_NO_STD_WSTRING )
+#   error Configuration not supported: Boost.Filesystem V3 and later requires std::wstring support
+# endif
+
+#include <boost/detail/lightweight_test.hpp>
+
+#ifndef BOOST_LIGHTWEIGHT_MAIN
+#  include <boost/test/prg_exec_monitor.hpp>
+#else
+#  include <boost/detail/lightweight_main.hpp>
+#endif
+
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+namespace fs = boost::filesystem;
+using fs::path;
+using fs::tree_snapshot;
+using fs::tree_diff;
+using boost::system::error_code;
+
+namespace
+{
+  void create_file(const path& ph, const std::string& contents = std::string())
+  {
+    std::ofstream f(ph.string().c_str());
+    BOOST_TEST(f);
+    f << contents;
+  }
+
+  bool contains(const std::vector<path>& v, const path& p)
+  {
+    return std::find(v.begin(), v.end(), p) != v.end();
+  }
+
+  //  capture_tests  -------------------------------------------------------------------//
+
+  void capture_tests(const path& dir)
+  {
+    std::cout << "capture_tests..." << std::endl;
+
+    tree_snapshot snap(dir);
+    BOOST_TEST(snap.root() == dir);
+    BOOST_TEST_EQ(snap.size(), 5U);  // a, a/b, a/b/c, a-z, d
+
+    // a directory is immediately followed by its contents, even though '-' < '/'
+    BOOST_TEST(snap.relative_path(0) == "a");
+    BOOST_TEST(snap.relative_path(1) == path("a") / "b");
+    BOOST_TEST(snap.relative_path(2) == path("a") / "b" / "c");
+    BOOST_TEST(snap.relative_path(3) == "a-z");
+    BOOST_TEST(snap.relative_path(4) == "d");
+
+    fs::snapshot_entry e(snap[2]);
+    BOOST_TEST(e.type == fs::file_type::regular);
+    BOOST_TEST_EQ(e.size, 3U);
+#   ifdef BOOST_FILESYSTEM_USE_TIME_T
+    BOOST_TEST(boost::chrono::system_clock::to_time_t(e.last_write_time)
+      == fs::last_write_time(dir / "a" / "b" / "c"));
+#   else
+    BOOST_TEST(e.last_write_time == fs::last_write_time(dir / "a" / "b" / "c"));
+#   endif
+    BOOST_TEST(snap[0].type == fs::file_type::directory);
+
+    BOOST_TEST_EQ(snap.find(path("a") / "b" / "c"), 2U);
+    BOOST_TEST_EQ(snap.find("d"), 4U);
+    BOOST_TEST_EQ(snap.find("nope"), snap.size());
+
+    tree_snapshot other;
+    BOOST_TEST(other.empty());
+    swap(snap, other);
+    BOOST_TEST(snap.empty());
+    BOOST_TEST_EQ(other.size(), 5U);
+
+    error_code ec;
+    snap.capture(dir / "no-such-directory", ec);
+    BOOST_TEST(!!ec);
+    BOOST_TEST(snap.empty());
+
+    bool threw = false;
+    try { tree_snapshot bad(dir / "no-such-directory"); }
+    catch (const fs::filesystem_error&) { threw = true; }
+    BOOST_TEST(threw);
+  }
+
+  //  diff_tests  ----------------------------------------------------------------------//
+
+  void diff_tests(const path& dir)
+  {
+    std::cout << "diff_tests..." << std::endl;
+
+    tree_snapshot before(dir);
+    BOOST_TEST(fs::diff(before).empty());
+
+    create_file(dir / "a" / "new", "x");
+    fs::remove(dir / "d");
+    create_file(dir / "a" / "b" / "c", "longer");
+#   ifdef BOOST_FILESYSTEM_USE_TIME_T
+    fs::last_write_time(dir / "a-z", fs::last_write_time(dir / "a-z") - 10);
+#   else
+    fs::last_write_time(dir / "a-z",
+      fs::last_write_time(dir / "a-z") - boost::chrono::seconds(10));
+#   endif
+
+    tree_snapshot after(dir);
+    tree_diff d(fs::diff(before, after));
+    BOOST_TEST_EQ(d.added.size(), 1U);
+    BOOST_TEST(contains(d.added, path("a") / "new"));
+    BOOST_TEST_EQ(d.removed.size(), 1U);
+    BOOST_TEST(contains(d.removed, "d"));
+    // directory "a" changed only by its contents, so is not modified
+    BOOST_TEST_EQ(d.modified.size(), 2U);
+    BOOST_TEST(contains(d.modified, path("a") / "b" / "c"));
+    BOOST_TEST(contains(d.modified, "a-z"));
+
+    // the reverse diff swaps added and removed
+    tree_diff r(fs::diff(after, before));
+    BOOST_TEST(contains(r.removed, path("a") / "new"));
+    BOOST_TEST(contains(r.added, "d"));
+
+    // against the live tree
+    fs::remove_all(dir / "a" / "b");
+    error_code ec;
+    tree_diff live(fs::diff(after, ec));
+    BOOST_TEST(!ec);
+    BOOST_TEST_EQ(live.removed.size(), 2U);
+    BOOST_TEST(contains(live.removed, path("a") / "b"));
+    BOOST_TEST(contains(live.removed, path("a") / "b" / "c"));
+    BOOST_TEST(live.added.empty());
+
+    // replacing a file changes its inode even if size and time match
+    tree_snapshot s1(dir);
+    fs::file_time_type t(fs::last_write_time(dir / "a" / "new"));
+    create_file(dir / "a" / "replacement", "x");
+    fs::last_write_time(dir / "a" / "replacement", t);
+    fs::rename(dir / "a" / "replacement", dir / "a" / "new");
+    tree_diff replaced(fs::diff(s1));
+    BOOST_TEST(replaced.added.empty() && replaced.removed.empty());
+#   ifdef BOOST_POSIX_API
+    BOOST_TEST_EQ(replaced.modified.size(), 1U);
+#   endif
+  }
+
+}  // unnamed namespace
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//                                    main                                              //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+int cpp_main(int, char*[])
+{
+  path dir(fs::temp_directory_path() / fs::unique_path("tree_snapshot_test-%%%%-%%%%"));
+  fs::create_directory(dir);
+  fs::create_directories(dir / "a" / "b");
+  create_file(dir / "a" / "b" / "c", "abc");
+  create_file(dir / "a-z");
+  create_file(dir / "d");
+
+  capture_tests(dir);
+  diff_tests(dir);
+
+  fs::remove_all(dir);
+
+  return ::boost::report_errors();
+}